@@ -29,6 +29,7 @@
 #include "util/util_image.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
+#include "util/util_profiling.h"
 #include "util/util_progress.h"
 #include "util/util_string.h"
 #include "util/util_time.h"
@@ -48,12 +49,15 @@ struct Options {
   Session *session;
   Scene *scene;
   string filepath;
+  vector<string> filepaths;
   int width, height;
   SceneParams scene_params;
   SessionParams session_params;
   bool quiet;
   bool show_help, interactive, pause;
   string output_path;
+  bool benchmark;
+  string benchmark_output_path;
 } options;
 
 static void session_print(const string &str)
@@ -147,7 +151,9 @@ static void scene_init()
 
 static void session_init()
 {
-  options.session_params.write_render_cb = write_render;
+  /* Benchmark statistics are written to standard output, so skip writing images. */
+  if (!options.benchmark)
+    options.session_params.write_render_cb = write_render;
   options.session = new Session(options.session_params);
 
   if (options.session_params.background && !options.quiet)
@@ -178,6 +184,162 @@ static void session_exit()
   }
 }
 
+static string json_escape(const string &str)
+{
+  string result;
+  foreach (char c, str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    }
+    else if ((unsigned char)c < 0x20) {
+      result += string_printf("\\u%04x", (int)c);
+    }
+    else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+/* Split of the time the render threads spent in the kernel, as fractions of the sampled time.
+ * Profiler events are exclusive, so shadow rays traced for light sampling count as intersection
+ * and closures evaluated for it as shader evaluation. Everything else, including the time
+ * threads spend outside of the kernel acquiring tiles, counts as other. */
+static string benchmark_kernel_json(Profiler &profiler)
+{
+  uint64_t total = 0;
+  for (int event = 0; event < PROFILING_NUM_EVENTS; event++) {
+    total += profiler.get_event((ProfilingEvent)event);
+  }
+
+  auto fraction = [&](const vector<ProfilingEvent> &events) {
+    uint64_t samples = 0;
+    foreach (ProfilingEvent event, events) {
+      samples += profiler.get_event(event);
+    }
+    return (total > 0) ? (double)samples / total : 0.0;
+  };
+
+  const double intersection = fraction({PROFILING_SCENE_INTERSECT,
+                                        PROFILING_INTERSECT,
+                                        PROFILING_INTERSECT_LOCAL,
+                                        PROFILING_INTERSECT_SHADOW_ALL,
+                                        PROFILING_INTERSECT_VOLUME,
+                                        PROFILING_INTERSECT_VOLUME_ALL});
+  const double shader_eval = fraction({PROFILING_SHADER_SETUP,
+                                       PROFILING_SHADER_EVAL,
+                                       PROFILING_CLOSURE_EVAL,
+                                       PROFILING_CLOSURE_SAMPLE,
+                                       PROFILING_CLOSURE_VOLUME_EVAL,
+                                       PROFILING_CLOSURE_VOLUME_SAMPLE});
+  const double light_sampling = fraction({PROFILING_CONNECT_LIGHT, PROFILING_INDIRECT_EMISSION});
+  const double film_write = fraction({PROFILING_WRITE_RESULT});
+  const double other = (total > 0) ?
+                           1.0 - intersection - shader_eval - light_sampling - film_write :
+                           0.0;
+
+  /* Profiler samples every thread once per millisecond. */
+  return string_printf(
+      "{\"thread_time\": %.3f, \"intersection\": %.4f, \"shader_eval\": %.4f, "
+      "\"light_sampling\": %.4f, \"film_write\": %.4f, \"other\": %.4f}",
+      total * 1e-3,
+      intersection,
+      shader_eval,
+      light_sampling,
+      film_write,
+      max(other, 0.0));
+}
+
+/* Render every file for the given number of samples and write statistics as JSON, so kernel
+ * performance can be compared between builds. */
+static void benchmark_run()
+{
+  const int width = options.width;
+  const int height = options.height;
+  const int samples = options.session_params.samples;
+  const bool use_profiling = (options.session_params.device.type == DEVICE_CPU);
+
+  string scenes;
+
+  foreach (const string &filepath, options.filepaths) {
+    options.filepath = filepath;
+    options.width = width;
+    options.height = height;
+
+    fprintf(stderr, "Rendering %s\n", filepath.c_str());
+
+    session_init();
+    options.session->wait();
+
+    Progress &progress = options.session->progress;
+    if (progress.get_error()) {
+      fprintf(stderr,
+              "Error rendering %s: %s\n",
+              filepath.c_str(),
+              progress.get_error_message().c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    double total_time, render_time;
+    progress.get_time(total_time, render_time);
+
+    const double pixel_samples = (double)options.width * options.height * samples;
+
+    string scene = string_printf(
+        "    {\"name\": \"%s\", \"width\": %d, \"height\": %d, \"time\": %.3f, "
+        "\"render_time\": %.3f, \"samples_per_second\": %.3f, "
+        "\"pixel_samples_per_second\": %.1f",
+        json_escape(path_filename(filepath)).c_str(),
+        options.width,
+        options.height,
+        total_time,
+        render_time,
+        (render_time > 0.0) ? samples / render_time : 0.0,
+        (render_time > 0.0) ? pixel_samples / render_time : 0.0);
+
+    if (use_profiling) {
+      scene += ", \"kernel\": " + benchmark_kernel_json(options.session->profiler);
+    }
+    scene += "}";
+
+    if (!scenes.empty()) {
+      scenes += ",\n";
+    }
+    scenes += scene;
+
+    session_exit();
+  }
+
+  string result = string_printf(
+      "{\n"
+      "  \"version\": \"%s\",\n"
+      "  \"device\": \"%s\",\n"
+      "  \"samples\": %d,\n"
+      "  \"scenes\": [\n%s\n  ]\n"
+      "}\n",
+      CYCLES_VERSION_STRING,
+      json_escape(options.session_params.device.description).c_str(),
+      samples,
+      scenes.c_str());
+
+  if (options.benchmark_output_path.empty()) {
+    printf("%s", result.c_str());
+    fflush(stdout);
+  }
+  else {
+    FILE *f = path_fopen(options.benchmark_output_path, "w");
+    if (!f) {
+      fprintf(stderr,
+              "Failed to write benchmark statistics to %s\n",
+              options.benchmark_output_path.c_str());
+      exit(EXIT_FAILURE);
+    }
+    fputs(result.c_str(), f);
+    fclose(f);
+  }
+}
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 static void display_info(Progress &progress)
 {
@@ -354,6 +516,9 @@ static void keyboard(unsigned char key)
 
 static int files_parse(int argc, const char *argv[])
 {
+  for (int i = 0; i < argc; i++)
+    options.filepaths.push_back(argv[i]);
+
   if (argc > 0)
     options.filepath = argv[0];
 
@@ -367,6 +532,7 @@ static void options_parse(int argc, const char **argv)
   options.filepath = "";
   options.session = NULL;
   options.quiet = false;
+  options.benchmark = false;
 
   /* device names */
   string device_names = "";
@@ -390,7 +556,7 @@ static void options_parse(int argc, const char **argv)
   bool help = false, debug = false, version = false;
   int verbosity = 1;
 
-  ap.options("Usage: cycles [options] file.xml",
+  ap.options("Usage: cycles [options] file.xml [file.xml ...]",
              "%*",
              files_parse,
              "",
@@ -429,6 +595,12 @@ static void options_parse(int argc, const char **argv)
              "--tile-height %d",
              &options.session_params.tile_size.y,
              "Tile height in pixels",
+             "--benchmark",
+             &options.benchmark,
+             "Render all files in background and print performance statistics as JSON",
+             "--benchmark-output %s",
+             &options.benchmark_output_path,
+             "File path to write benchmark statistics to, instead of standard output",
              "--list-devices",
              &list,
              "List information about all available devices",
@@ -490,8 +662,17 @@ static void options_parse(int argc, const char **argv)
   options.session_params.background = true;
 #endif
 
-  /* Use progressive rendering */
-  options.session_params.progressive = true;
+  if (options.benchmark) {
+    /* Render tiles like a final render, and collect kernel statistics. */
+    options.session_params.background = true;
+    options.session_params.progressive = false;
+    options.session_params.use_profiling = true;
+    options.quiet = true;
+  }
+  else {
+    /* Use progressive rendering */
+    options.session_params.progressive = true;
+  }
 
   /* find matching device */
   DeviceType device_type = Device::type_from_string(devicename.c_str());
@@ -519,7 +700,8 @@ static void options_parse(int argc, const char **argv)
     exit(EXIT_FAILURE);
   }
 #endif
-  else if (options.session_params.samples < 0) {
+  else if (options.session_params.samples < 0 ||
+           (options.benchmark && options.session_params.samples == 0)) {
     fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
     exit(EXIT_FAILURE);
   }
@@ -542,6 +724,11 @@ int main(int argc, const char **argv)
   path_init();
   options_parse(argc, argv);
 
+  if (options.benchmark) {
+    benchmark_run();
+    return 0;
+  }
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
   if (options.session_params.background) {
 #endif
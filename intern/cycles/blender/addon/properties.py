@@ -392,6 +392,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0.0, max=1.0,
         default=0.01,
     )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Pick lights by their estimated contribution to the shading point using a tree of lights, "
+        "reducing noise in scenes with many lights",
+        default=False,
+    )
 
     use_adaptive_sampling: BoolProperty(
         name="Use Adaptive Sampling",
@@ -801,6 +807,21 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Load image files on demand by tile and mipmap level instead of loading them fully into memory. "
+        "Reduces memory usage of scenes with many high resolution textures, and works best with tiled and mipmapped .tx files "
+        "(only supported for CPU rendering with SVM)",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Cache Size",
+        description="Maximum memory used by the texture cache, in megabytes",
+        min=64, max=1048576,
+        default=4096,
+        subtype='NONE',
+    )
+
     use_fast_gi: BoolProperty(
         name="Fast GI Approximation",
         description="Approximate diffuse indirect light with background tinted ambient occlusion. This provides fast alternative to full global illumination, for interactive viewport rendering or final renders with reduced quality",
@@ -838,6 +838,8 @@ void BlenderSync::sync_hair(BL::Depsgraph b_depsgraph, BL::Object b_ob, Hair *ha
 
   /* update original sockets */
 
+  const size_t num_keys = hair->get_curve_keys().size();
+
   for (const SocketType &socket : new_hair.type->inputs) {
     /* Those sockets are updated in sync_object, so do not modify them. */
     if (socket.name == "use_motion_blur" || socket.name == "motion_steps" ||
@@ -851,9 +853,10 @@ void BlenderSync::sync_hair(BL::Depsgraph b_depsgraph, BL::Object b_ob, Hair *ha
 
   /* tag update */
 
-  /* Compares curve_keys rather than strands in order to handle quick hair
-   * adjustments in dynamic BVH - other methods could probably do this better. */
-  const bool rebuild = (hair->curve_keys_is_modified() || hair->curve_radius_is_modified());
+  /* Only rebuild when the curves themselves changed, deformed curves with the same keys per curve
+   * keep the same primitives and their BVH can be refit. */
+  const bool rebuild = (hair->curve_first_key_is_modified() ||
+                        hair->get_curve_keys().size() != num_keys);
 
   hair->tag_update(scene, rebuild);
 }
@@ -36,8 +36,29 @@
 
 #include "mikktspace.h"
 
+#include "DNA_meshdata_types.h"
+#include "DNA_vec_types.h"
+
 CCL_NAMESPACE_BEGIN
 
+/* Direct access to the DNA arrays behind RNA collections and attribute layers, to convert
+ * them with plain loops rather than through an RNA function call for every element. */
+
+template<typename T, typename Collection> static const T *rna_collection_data(Collection &b_coll)
+{
+  return (b_coll.length() != 0) ? static_cast<const T *>(b_coll[0].ptr.data) : NULL;
+}
+
+static float4 get_float4(const MLoopCol &b_col)
+{
+  return make_float4(b_col.r, b_col.g, b_col.b, b_col.a) * (1.0f / 255.0f);
+}
+
+static float2 get_float2(const MLoopUV &b_uv)
+{
+  return make_float2(b_uv.uv[0], b_uv.uv[1]);
+}
+
 /* Tangent Space */
 
 struct MikkUserData {
@@ -302,10 +323,12 @@ static void attr_create_sculpt_vertex_color(Scene *scene,
     vcol_attr->std = vcol_std;
 
     float4 *cdata = vcol_attr->data_float4();
+    const MPropCol *b_cdata = rna_collection_data<MPropCol>(l.data);
     int numverts = b_mesh.vertices.length();
 
     for (int i = 0; i < numverts; i++) {
-      *(cdata++) = get_float4(l.data[i].color());
+      const float *c = b_cdata[i].color;
+      cdata[i] = make_float4(c[0], c[1], c[2], c[3]);
     }
   }
 }
@@ -316,11 +339,14 @@ static void fill_generic_attribute(BL::Mesh &b_mesh,
                                    const AttributeElement element,
                                    const GetValueAtIndex &get_value_at_index)
 {
+  const MLoopTri *looptris = rna_collection_data<MLoopTri>(b_mesh.loop_triangles);
+  const int num_tris = b_mesh.loop_triangles.length();
+
   switch (element) {
     case ATTR_ELEMENT_CORNER: {
-      for (BL::MeshLoopTriangle &t : b_mesh.loop_triangles) {
-        const int index = t.index() * 3;
-        BL::Array<int, 3> loops = t.loops();
+      for (int i = 0; i < num_tris; i++) {
+        const int index = i * 3;
+        const unsigned int *loops = looptris[i].tri;
         data[index] = get_value_at_index(loops[0]);
         data[index + 1] = get_value_at_index(loops[1]);
         data[index + 2] = get_value_at_index(loops[2]);
@@ -335,8 +361,8 @@ static void fill_generic_attribute(BL::Mesh &b_mesh,
       break;
     }
     case ATTR_ELEMENT_FACE: {
-      for (BL::MeshLoopTriangle &t : b_mesh.loop_triangles) {
-        data[t.index()] = get_value_at_index(t.polygon_index());
+      for (int i = 0; i < num_tris; i++) {
+        data[i] = get_value_at_index(looptris[i].poly);
       }
       break;
     }
@@ -388,56 +414,57 @@ static void attr_create_generic(Scene *scene, Mesh *mesh, BL::Mesh &b_mesh, bool
     switch (b_data_type) {
       case BL::Attribute::data_type_FLOAT: {
         BL::FloatAttribute b_float_attribute{b_attribute};
+        const MFloatProperty *b_data = rna_collection_data<MFloatProperty>(b_float_attribute.data);
         Attribute *attr = attributes.add(name, TypeFloat, element);
         float *data = attr->data_float();
-        fill_generic_attribute(
-            b_mesh, data, element, [&](int i) { return b_float_attribute.data[i].value(); });
+        fill_generic_attribute(b_mesh, data, element, [&](int i) { return b_data[i].f; });
         break;
       }
       case BL::Attribute::data_type_BOOLEAN: {
         BL::BoolAttribute b_bool_attribute{b_attribute};
+        const MBoolProperty *b_data = rna_collection_data<MBoolProperty>(b_bool_attribute.data);
         Attribute *attr = attributes.add(name, TypeFloat, element);
         float *data = attr->data_float();
         fill_generic_attribute(
-            b_mesh, data, element, [&](int i) { return (float)b_bool_attribute.data[i].value(); });
+            b_mesh, data, element, [&](int i) { return (float)(b_data[i].b & 1); });
         break;
       }
       case BL::Attribute::data_type_INT: {
         BL::IntAttribute b_int_attribute{b_attribute};
+        const MIntProperty *b_data = rna_collection_data<MIntProperty>(b_int_attribute.data);
         Attribute *attr = attributes.add(name, TypeFloat, element);
         float *data = attr->data_float();
-        fill_generic_attribute(
-            b_mesh, data, element, [&](int i) { return (float)b_int_attribute.data[i].value(); });
+        fill_generic_attribute(b_mesh, data, element, [&](int i) { return (float)b_data[i].i; });
         break;
       }
       case BL::Attribute::data_type_FLOAT_VECTOR: {
         BL::FloatVectorAttribute b_vector_attribute{b_attribute};
+        const vec3f *b_data = rna_collection_data<vec3f>(b_vector_attribute.data);
         Attribute *attr = attributes.add(name, TypeVector, element);
         float3 *data = attr->data_float3();
         fill_generic_attribute(b_mesh, data, element, [&](int i) {
-          BL::Array<float, 3> v = b_vector_attribute.data[i].vector();
-          return make_float3(v[0], v[1], v[2]);
+          return make_float3(b_data[i].x, b_data[i].y, b_data[i].z);
         });
         break;
       }
       case BL::Attribute::data_type_FLOAT_COLOR: {
         BL::FloatColorAttribute b_color_attribute{b_attribute};
+        const MPropCol *b_data = rna_collection_data<MPropCol>(b_color_attribute.data);
         Attribute *attr = attributes.add(name, TypeRGBA, element);
         float4 *data = attr->data_float4();
         fill_generic_attribute(b_mesh, data, element, [&](int i) {
-          BL::Array<float, 4> v = b_color_attribute.data[i].color();
+          const float *v = b_data[i].color;
           return make_float4(v[0], v[1], v[2], v[3]);
         });
         break;
       }
       case BL::Attribute::data_type_FLOAT2: {
         BL::Float2Attribute b_float2_attribute{b_attribute};
+        const vec2f *b_data = rna_collection_data<vec2f>(b_float2_attribute.data);
         Attribute *attr = attributes.add(name, TypeFloat2, element);
         float2 *data = attr->data_float2();
-        fill_generic_attribute(b_mesh, data, element, [&](int i) {
-          BL::Array<float, 2> v = b_float2_attribute.data[i].vector();
-          return make_float2(v[0], v[1]);
-        });
+        fill_generic_attribute(
+            b_mesh, data, element, [&](int i) { return make_float2(b_data[i].x, b_data[i].y); });
         break;
       }
       default:
@@ -463,6 +490,7 @@ static void attr_create_vertex_color(Scene *scene, Mesh *mesh, BL::Mesh &b_mesh,
     }
 
     Attribute *vcol_attr = NULL;
+    const MLoopCol *b_cdata = rna_collection_data<MLoopCol>(l.data);
 
     if (subdivision) {
       if (active_render) {
@@ -473,13 +501,14 @@ static void attr_create_vertex_color(Scene *scene, Mesh *mesh, BL::Mesh &b_mesh,
       }
 
       uchar4 *cdata = vcol_attr->data_uchar4();
+      const MPoly *polys = rna_collection_data<MPoly>(b_mesh.polygons);
+      const int num_polys = b_mesh.polygons.length();
 
-      for (BL::MeshPolygon &p : b_mesh.polygons) {
-        int n = p.loop_total();
-        for (int i = 0; i < n; i++) {
-          float4 color = get_float4(l.data[p.loop_start() + i].color());
+      for (int p = 0; p < num_polys; p++) {
+        const MLoopCol *b_poly_cdata = b_cdata + polys[p].loopstart;
+        for (int i = 0; i < polys[p].totloop; i++) {
           /* Compress/encode vertex color using the sRGB curve. */
-          *(cdata++) = color_float4_to_uchar4(color);
+          *(cdata++) = color_float4_to_uchar4(get_float4(b_poly_cdata[i]));
         }
       }
     }
@@ -492,12 +521,14 @@ static void attr_create_vertex_color(Scene *scene, Mesh *mesh, BL::Mesh &b_mesh,
       }
 
       uchar4 *cdata = vcol_attr->data_uchar4();
+      const MLoopTri *looptris = rna_collection_data<MLoopTri>(b_mesh.loop_triangles);
+      const int num_tris = b_mesh.loop_triangles.length();
 
-      for (BL::MeshLoopTriangle &t : b_mesh.loop_triangles) {
-        int3 li = get_int3(t.loops());
-        float4 c1 = get_float4(l.data[li[0]].color());
-        float4 c2 = get_float4(l.data[li[1]].color());
-        float4 c3 = get_float4(l.data[li[2]].color());
+      for (int t = 0; t < num_tris; t++) {
+        const unsigned int *li = looptris[t].tri;
+        float4 c1 = get_float4(b_cdata[li[0]]);
+        float4 c2 = get_float4(b_cdata[li[1]]);
+        float4 c3 = get_float4(b_cdata[li[2]]);
 
         /* Compress/encode vertex color using the sRGB curve. */
         cdata[0] = color_float4_to_uchar4(c1);
@@ -542,12 +573,15 @@ static void attr_create_uv_map(Scene *scene, Mesh *mesh, BL::Mesh &b_mesh)
         }
 
         float2 *fdata = uv_attr->data_float2();
-
-        for (BL::MeshLoopTriangle &t : b_mesh.loop_triangles) {
-          int3 li = get_int3(t.loops());
-          fdata[0] = get_float2(l.data[li[0]].uv());
-          fdata[1] = get_float2(l.data[li[1]].uv());
-          fdata[2] = get_float2(l.data[li[2]].uv());
+        const MLoopUV *b_uvdata = rna_collection_data<MLoopUV>(l.data);
+        const MLoopTri *looptris = rna_collection_data<MLoopTri>(b_mesh.loop_triangles);
+        const int num_tris = b_mesh.loop_triangles.length();
+
+        for (int t = 0; t < num_tris; t++) {
+          const unsigned int *li = looptris[t].tri;
+          fdata[0] = get_float2(b_uvdata[li[0]]);
+          fdata[1] = get_float2(b_uvdata[li[1]]);
+          fdata[2] = get_float2(b_uvdata[li[2]]);
           fdata += 3;
         }
       }
@@ -609,11 +643,14 @@ static void attr_create_subd_uv_map(Scene *scene, Mesh *mesh, BL::Mesh &b_mesh,
         }
 
         float2 *fdata = uv_attr->data_float2();
-
-        for (BL::MeshPolygon &p : b_mesh.polygons) {
-          int n = p.loop_total();
-          for (int j = 0; j < n; j++) {
-            *(fdata++) = get_float2(l->data[p.loop_start() + j].uv());
+        const MLoopUV *b_uvdata = rna_collection_data<MLoopUV>(l->data);
+        const MPoly *polys = rna_collection_data<MPoly>(b_mesh.polygons);
+        const int num_polys = b_mesh.polygons.length();
+
+        for (int p = 0; p < num_polys; p++) {
+          const MLoopUV *b_poly_uvdata = b_uvdata + polys[p].loopstart;
+          for (int j = 0; j < polys[p].totloop; j++) {
+            *(fdata++) = get_float2(b_poly_uvdata[j]);
           }
         }
       }
@@ -876,13 +913,18 @@ static void create_mesh(Scene *scene,
     return;
   }
 
+  const MVert *verts = rna_collection_data<MVert>(b_mesh.vertices);
+  const MPoly *polys = rna_collection_data<MPoly>(b_mesh.polygons);
+  const MLoop *loops = rna_collection_data<MLoop>(b_mesh.loops);
+  const int numpolys = b_mesh.polygons.length();
+
   if (!subdivision) {
     numtris = numfaces;
   }
   else {
-    for (BL::MeshPolygon &p : b_mesh.polygons) {
-      numngons += (p.loop_total() == 4) ? 0 : 1;
-      numcorners += p.loop_total();
+    for (int p = 0; p < numpolys; p++) {
+      numngons += (polys[p].totloop == 4) ? 0 : 1;
+      numcorners += polys[p].totloop;
     }
   }
 
@@ -894,17 +936,19 @@ static void create_mesh(Scene *scene,
   mesh->reserve_mesh(numverts, numtris);
 
   /* create vertex coordinates and normals */
-  BL::Mesh::vertices_iterator v;
-  for (b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v)
-    mesh->add_vertex(get_float3(v->co()));
+  for (int i = 0; i < numverts; i++) {
+    const float *co = verts[i].co;
+    mesh->add_vertex(make_float3(co[0], co[1], co[2]));
+  }
 
   AttributeSet &attributes = (subdivision) ? mesh->subd_attributes : mesh->attributes;
   Attribute *attr_N = attributes.add(ATTR_STD_VERTEX_NORMAL);
   float3 *N = attr_N->data_float3();
 
-  for (b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v, ++N)
-    *N = get_float3(v->normal());
-  N = attr_N->data_float3();
+  for (int i = 0; i < numverts; i++) {
+    const short *no = verts[i].no;
+    N[i] = make_float3(no[0], no[1], no[2]) * (1.0f / 32767.0f);
+  }
 
   /* create generated coordinates from undeformed coordinates */
   const bool need_default_tangent = (subdivision == false) && (b_mesh.uv_layers.length() == 0) &&
@@ -919,6 +963,7 @@ static void create_mesh(Scene *scene,
     float3 *generated = attr->data_float3();
     size_t i = 0;
 
+    BL::Mesh::vertices_iterator v;
     for (b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v) {
       generated[i++] = get_float3(v->undeformed_co()) * size - loc;
     }
@@ -926,20 +971,15 @@ static void create_mesh(Scene *scene,
 
   /* create faces */
   if (!subdivision) {
-    for (BL::MeshLoopTriangle &t : b_mesh.loop_triangles) {
-      BL::MeshPolygon p = b_mesh.polygons[t.polygon_index()];
-      int3 vi = get_int3(t.vertices());
+    const MLoopTri *looptris = rna_collection_data<MLoopTri>(b_mesh.loop_triangles);
 
-      int shader = clamp(p.material_index(), 0, used_shaders.size() - 1);
-      bool smooth = p.use_smooth() || use_loop_normals;
+    for (int t = 0; t < numtris; t++) {
+      const MLoopTri &lt = looptris[t];
+      const MPoly &p = polys[lt.poly];
+      int3 vi = make_int3(loops[lt.tri[0]].v, loops[lt.tri[1]].v, loops[lt.tri[2]].v);
 
-      if (use_loop_normals) {
-        BL::Array<float, 9> loop_normals = t.split_normals();
-        for (int i = 0; i < 3; i++) {
-          N[vi[i]] = make_float3(
-              loop_normals[i * 3], loop_normals[i * 3 + 1], loop_normals[i * 3 + 2]);
-        }
-      }
+      int shader = clamp((int)p.mat_nr, 0, used_shaders.size() - 1);
+      bool smooth = (p.flag & ME_SMOOTH) || use_loop_normals;
 
       /* Create triangles.
        *
@@ -947,19 +987,31 @@ static void create_mesh(Scene *scene,
        */
       mesh->add_triangle(vi[0], vi[1], vi[2], shader, smooth);
     }
+
+    /* Split normals are computed on demand by RNA, so they still go through it. */
+    if (use_loop_normals) {
+      for (BL::MeshLoopTriangle &t : b_mesh.loop_triangles) {
+        int3 vi = get_int3(t.vertices());
+        BL::Array<float, 9> loop_normals = t.split_normals();
+        for (int i = 0; i < 3; i++) {
+          N[vi[i]] = make_float3(
+              loop_normals[i * 3], loop_normals[i * 3 + 1], loop_normals[i * 3 + 2]);
+        }
+      }
+    }
   }
   else {
     vector<int> vi;
 
-    for (BL::MeshPolygon &p : b_mesh.polygons) {
-      int n = p.loop_total();
-      int shader = clamp(p.material_index(), 0, used_shaders.size() - 1);
-      bool smooth = p.use_smooth() || use_loop_normals;
+    for (int p = 0; p < numpolys; p++) {
+      int n = polys[p].totloop;
+      int shader = clamp((int)polys[p].mat_nr, 0, used_shaders.size() - 1);
+      bool smooth = (polys[p].flag & ME_SMOOTH) || use_loop_normals;
 
       vi.resize(n);
       for (int i = 0; i < n; i++) {
         /* NOTE: Autosmooth is already taken care about. */
-        vi[i] = b_mesh.loops[p.loop_start() + i].vertex_index();
+        vi[i] = loops[polys[p].loopstart + i].v;
       }
 
       /* create subd faces */
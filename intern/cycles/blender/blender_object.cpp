@@ -226,10 +226,6 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
     return NULL;
   }
 
-  /* Use task pool only for non-instances, since sync_dupli_particle accesses
-   * geometry. This restriction should be removed for better performance. */
-  TaskPool *object_geom_task_pool = (is_instance) ? NULL : geom_task_pool;
-
   /* key to lookup object */
   ObjectKey key(b_parent, persistent_id, b_ob_instance, use_particle_hair);
   Object *object;
@@ -254,7 +250,7 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
                              object,
                              motion_time,
                              use_particle_hair,
-                             object_geom_task_pool);
+                             geom_task_pool);
     }
 
     return object;
@@ -273,7 +269,7 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
                                      b_ob_instance,
                                      object_updated,
                                      use_particle_hair,
-                                     object_geom_task_pool);
+                                     geom_task_pool);
   object->set_geometry(geometry);
 
   /* special case not tracked by object update flags */
@@ -313,9 +309,10 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
 
   /* object sync
    * transform comparison should not be needed, but duplis don't work perfect
-   * in the depsgraph and may not signal changes, so this is a workaround */
+   * in the depsgraph and may not signal changes, so this is a workaround. Geometry may
+   * still be synchronizing in a task, so test whether it was synced in this pass. */
   if (object->is_modified() || object_updated ||
-      (object->get_geometry() && object->get_geometry()->is_modified())) {
+      geometry_synced.find(object->get_geometry()) != geometry_synced.end()) {
     object->name = b_ob.name().c_str();
     object->set_pass_id(b_ob.pass_index());
     object->set_color(get_float3(b_ob.color()));
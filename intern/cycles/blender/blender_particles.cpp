@@ -55,8 +55,9 @@ bool BlenderSync::sync_dupli_particle(BL::Object &b_ob,
   bool first_use = !particle_system_map.is_used(key);
   bool need_update = particle_system_map.add_or_update(&psys, b_ob, b_instance.object(), key);
 
-  /* no update needed? */
-  if (!need_update && !object->get_geometry()->is_modified() &&
+  /* no update needed? Geometry may still be synchronizing in a task, so test whether it
+   * was synced in this pass instead of whether it was modified. */
+  if (!need_update && geometry_synced.find(object->get_geometry()) == geometry_synced.end() &&
       !scene->object_manager->need_update())
     return true;
 
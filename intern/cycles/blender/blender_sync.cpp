@@ -333,6 +333,7 @@ void BlenderSync::sync_integrator()
   integrator->set_sample_all_lights_direct(get_boolean(cscene, "sample_all_lights_direct"));
   integrator->set_sample_all_lights_indirect(get_boolean(cscene, "sample_all_lights_indirect"));
   integrator->set_light_sampling_threshold(get_float(cscene, "light_sampling_threshold"));
+  integrator->set_use_light_tree(get_boolean(cscene, "use_light_tree"));
 
   SamplingPattern sampling_pattern = (SamplingPattern)get_enum(
       cscene, "sampling_pattern", SAMPLING_NUM_PATTERNS, SAMPLING_PATTERN_SOBOL);
@@ -827,9 +828,13 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
     params.texture_limit = 0;
   }
 
+  params.use_texture_cache = RNA_boolean_get(&cscene, "use_texture_cache");
+  params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
+  params.persistent_data = b_scene.render().use_persistent_data();
 
   return params;
 }
@@ -26,10 +26,15 @@
 #include "bvh/bvh_unaligned.h"
 
 #include "util/util_foreach.h"
+#include "util/util_logging.h"
 #include "util/util_progress.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Rebuild instead of refit once the surface area heuristic cost of the tree grew by this factor
+ * compared to the first refit after the last build. */
+#define BVH2_REFIT_MAX_SAH_COST_RATIO 1.5f
+
 BVHStackEntry::BVHStackEntry(const BVHNode *n, int i) : node(n), idx(i)
 {
 }
@@ -42,7 +47,11 @@ int BVHStackEntry::encodeIdx() const
 BVH2::BVH2(const BVHParams &params_,
            const vector<Geometry *> &geometry_,
            const vector<Object *> &objects_)
-    : BVH(params_, geometry_, objects_)
+    : BVH(params_, geometry_, objects_),
+      refit_sah_cost(0.0f),
+      top_level_prims_size(0),
+      top_level_nodes_size(0),
+      top_level_leaf_nodes_size(0)
 {
 }
 
@@ -96,10 +105,32 @@ void BVH2::build(Progress &progress, Stats *)
 
   /* free build nodes */
   root->deleteSubtree();
+
+  refit_sah_cost = 0.0f;
 }
 
 void BVH2::refit(Progress &progress)
 {
+  if (params.top_level) {
+    /* Remove the merged instance BVHs, they are merged again after refitting since their size
+     * changes when they were rebuilt. */
+    pack.prim_index.resize(top_level_prims_size);
+    pack.prim_type.resize(top_level_prims_size);
+    pack.prim_object.resize(top_level_prims_size);
+    if (pack.prim_time.size()) {
+      pack.prim_time.resize(top_level_prims_size);
+    }
+    pack.nodes.resize(top_level_nodes_size);
+    pack.leaf_nodes.resize(top_level_leaf_nodes_size);
+
+    /* Primitive indices were offset into the global arrays when merging. */
+    for (size_t i = 0; i < pack.prim_index.size(); i++) {
+      if (pack.prim_index[i] != -1) {
+        pack.prim_index[i] -= objects[pack.prim_object[i]]->get_geometry()->prim_offset;
+      }
+    }
+  }
+
   progress.set_substatus("Packing BVH primitives");
   pack_primitives();
 
@@ -107,7 +138,22 @@ void BVH2::refit(Progress &progress)
     return;
 
   progress.set_substatus("Refitting BVH nodes");
-  refit_nodes();
+  const float sah_cost = refit_nodes();
+
+  if (refit_sah_cost == 0.0f) {
+    refit_sah_cost = sah_cost;
+  }
+  else if (sah_cost > refit_sah_cost * BVH2_REFIT_MAX_SAH_COST_RATIO) {
+    /* Primitives moved too much for the tree to still be efficient. */
+    VLOG(1) << "Rebuilding BVH, refit increased cost from " << refit_sah_cost << " to "
+            << sah_cost << ".";
+    build(progress, NULL);
+    return;
+  }
+
+  if (params.top_level) {
+    pack_instances(top_level_nodes_size, top_level_leaf_nodes_size);
+  }
 }
 
 BVHNode *BVH2::widen_children_nodes(const BVHNode *root)
@@ -260,6 +306,8 @@ void BVH2::pack_nodes(const BVHNode *root)
   pack.leaf_nodes.clear();
   /* For top level BVH, first merge existing BVH's so we know the offsets. */
   if (params.top_level) {
+    top_level_nodes_size = node_size;
+    top_level_leaf_nodes_size = num_leaf_nodes * BVH_NODE_LEAF_SIZE;
     pack_instances(node_size, num_leaf_nodes * BVH_NODE_LEAF_SIZE);
   }
   else {
@@ -313,16 +361,18 @@ void BVH2::pack_nodes(const BVHNode *root)
   pack.root_index = (root->is_leaf()) ? -1 : 0;
 }
 
-void BVH2::refit_nodes()
+float BVH2::refit_nodes()
 {
-  assert(!params.top_level);
-
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
-  refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
+  float sah_cost = 0.0f;
+  refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility, sah_cost);
+
+  const float area = bbox.safe_area();
+  return (area > 0.0f) ? sah_cost / area : 0.0f;
 }
 
-void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
+void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility, float &sah_cost)
 {
   if (leaf) {
     /* refit leaf node */
@@ -331,7 +381,15 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     const int c0 = data[0].x;
     const int c1 = data[0].y;
 
-    refit_primitives(c0, c1, bbox, visibility);
+    if (c0 < 0) {
+      /* Object instance in the top level BVH. */
+      refit_primitives(~c0, ~c0 + 1, bbox, visibility);
+      sah_cost += bbox.safe_area() * params.cost(0, 1);
+    }
+    else {
+      refit_primitives(c0, c1, bbox, visibility);
+      sah_cost += bbox.safe_area() * params.cost(0, c1 - c0);
+    }
 
     /* TODO(sergey): De-duplicate with pack_leaf(). */
     float4 leaf_data[BVH_NODE_LEAF_SIZE];
@@ -352,8 +410,8 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     BoundBox bbox0 = BoundBox::empty, bbox1 = BoundBox::empty;
     uint visibility0 = 0, visibility1 = 0;
 
-    refit_node((c0 < 0) ? -c0 - 1 : c0, (c0 < 0), bbox0, visibility0);
-    refit_node((c1 < 0) ? -c1 - 1 : c1, (c1 < 0), bbox1, visibility1);
+    refit_node((c0 < 0) ? -c0 - 1 : c0, (c0 < 0), bbox0, visibility0, sah_cost);
+    refit_node((c1 < 0) ? -c1 - 1 : c1, (c1 < 0), bbox1, visibility1, sah_cost);
 
     if (is_unaligned) {
       Transform aligned_space = transform_identity();
@@ -367,6 +425,7 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     bbox.grow(bbox0);
     bbox.grow(bbox1);
     visibility = visibility0 | visibility1;
+    sah_cost += bbox.safe_area() * params.cost(2, 0);
   }
 }
 
@@ -389,8 +448,7 @@ void BVH2::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility
       if (pack.prim_type[prim] & PRIMITIVE_ALL_CURVE) {
         /* Curves. */
         const Hair *hair = static_cast<const Hair *>(ob->get_geometry());
-        int prim_offset = (params.top_level) ? hair->prim_offset : 0;
-        Hair::Curve curve = hair->get_curve(pidx - prim_offset);
+        Hair::Curve curve = hair->get_curve(pidx);
         int k = PRIMITIVE_UNPACK_SEGMENT(pack.prim_type[prim]);
 
         curve.bounds_grow(k, &hair->get_curve_keys()[0], &hair->get_curve_radius()[0], bbox);
@@ -412,8 +470,7 @@ void BVH2::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility
       else {
         /* Triangles. */
         const Mesh *mesh = static_cast<const Mesh *>(ob->get_geometry());
-        int prim_offset = (params.top_level) ? mesh->prim_offset : 0;
-        Mesh::Triangle triangle = mesh->get_triangle(pidx - prim_offset);
+        Mesh::Triangle triangle = mesh->get_triangle(pidx);
         const float3 *vpos = &mesh->verts[0];
 
         triangle.bounds_grow(vpos, bbox);
@@ -514,6 +571,7 @@ void BVH2::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 
   /* track offsets of instanced BVH data in global array */
   size_t prim_offset = pack.prim_index.size();
+  top_level_prims_size = prim_offset;
   size_t nodes_offset = nodes_size;
   size_t nodes_leaf_offset = leaf_nodes_size;
 
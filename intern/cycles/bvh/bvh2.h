@@ -51,6 +51,15 @@ class BVH2 : public BVH {
   PackedBVH pack;
 
  protected:
+  /* Surface area heuristic cost of the first refit after a build, refits that make the tree much
+   * worse than this rebuild it instead. Zero if there was no refit since the last build. */
+  float refit_sah_cost;
+
+  /* Size of the top level part of the packed arrays, before instance BVHs are merged into it. */
+  size_t top_level_prims_size;
+  size_t top_level_nodes_size;
+  size_t top_level_leaf_nodes_size;
+
   /* constructor */
   friend class BVH;
   BVH2(const BVHParams &params,
@@ -90,9 +99,9 @@ class BVH2 : public BVH {
                            uint visibility0,
                            uint visibility1);
 
-  /* refit */
-  void refit_nodes();
-  void refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility);
+  /* refit, returns the surface area heuristic cost of the refitted tree */
+  float refit_nodes();
+  void refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility, float &sah_cost);
 
   /* Refit range of primitives. */
   void refit_primitives(int start, int end, BoundBox &bbox, uint &visibility);
@@ -1026,6 +1026,29 @@ void CUDADevice::mem_copy_to(device_memory &mem)
   }
 }
 
+void CUDADevice::mem_copy_to_range(device_memory &mem, size_t offset, size_t size)
+{
+  /* Partial copies are only done for existing global memory and buffers, which do not need to be
+   * reallocated. Textures and memory not yet on the device get a full copy. */
+  if (!mem.device_pointer || mem.type == MEM_TEXTURE || mem.type == MEM_PIXELS) {
+    mem_copy_to(mem);
+    return;
+  }
+
+  if (!mem.host_pointer || size == 0) {
+    return;
+  }
+
+  assert(offset + size <= mem.memory_size());
+
+  thread_scoped_lock lock(cuda_mem_map_mutex);
+  if (!cuda_mem_map[&mem].use_mapped_host || mem.host_pointer != mem.shared_pointer) {
+    const CUDAContextScope scope(this);
+    cuda_assert(cuMemcpyHtoD(
+        (CUdeviceptr)mem.device_pointer + offset, (char *)mem.host_pointer + offset, size));
+  }
+}
+
 void CUDADevice::mem_copy_from(device_memory &mem, int y, int w, int h, int elem)
 {
   if (mem.type == MEM_PIXELS && !background) {
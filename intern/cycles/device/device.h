@@ -431,9 +431,21 @@ class Device {
 
 #ifdef WITH_NETWORK
   /* networking */
-  void server_run();
+  /* Serve the given number of client connections, or keep serving when zero. */
+  void server_run(int port, int num_connections = 0);
 #endif
 
+  /* tile stealing */
+  virtual bool tiles_can_be_stolen() const
+  {
+    return info.type == DEVICE_CPU;
+  }
+  /* Devices that can get their tiles stolen don't steal tiles themselves. */
+  virtual bool can_steal_tile() const
+  {
+    return !tiles_can_be_stolen();
+  }
+
   /* multi device */
   virtual void map_tile(Device * /*sub_device*/, RenderTile & /*tile*/)
   {
@@ -489,6 +501,12 @@ class Device {
 
   virtual void mem_alloc(device_memory &mem) = 0;
   virtual void mem_copy_to(device_memory &mem) = 0;
+  /* Copy a byte range of memory that was already copied before, devices that can not
+   * copy partially copy all memory. */
+  virtual void mem_copy_to_range(device_memory &mem, size_t /*offset*/, size_t /*size*/)
+  {
+    mem_copy_to(mem);
+  }
   virtual void mem_copy_from(device_memory &mem, int y, int w, int h, int elem) = 0;
   virtual void mem_zero(device_memory &mem) = 0;
   virtual void mem_free(device_memory &mem) = 0;
@@ -432,6 +432,17 @@ class CPUDevice : public Device {
     }
   }
 
+  virtual void mem_copy_to_range(device_memory &mem,
+                                 size_t /*offset*/,
+                                 size_t /*size*/) override
+  {
+    if (!mem.device_pointer || mem.type == MEM_TEXTURE) {
+      mem_copy_to(mem);
+    }
+
+    /* Otherwise copy is no-op, the kernel reads host memory directly. */
+  }
+
   virtual void mem_copy_from(
       device_memory & /*mem*/, int /*y*/, int /*w*/, int /*h*/, int /*elem*/) override
   {
@@ -1625,7 +1636,11 @@ int2 CPUSplitKernel::split_kernel_global_size(device_memory & /*kg*/,
                                               device_memory & /*data*/,
                                               DeviceTask & /*task*/)
 {
-  return make_int2(1, 1);
+  /* Number of paths each thread keeps in flight. Enough for paths hitting the same shader to be
+   * evaluated together after sorting. The state of this many paths is several megabytes, so it
+   * does not fit in the cache of a core, sorting only makes the shader code and data coherent.
+   * It is a single shader sort block, so all paths are sorted together. */
+  return make_int2(32, 32);
 }
 
 uint64_t CPUSplitKernel::state_buffer_size(device_memory &kernel_globals,
@@ -136,6 +136,13 @@ void device_memory::device_copy_to()
   }
 }
 
+void device_memory::device_copy_to(size_t offset, size_t size)
+{
+  if (host_pointer) {
+    device->mem_copy_to_range(*this, offset, size);
+  }
+}
+
 void device_memory::device_copy_from(int y, int w, int h, int elem)
 {
   assert(type != MEM_TEXTURE && type != MEM_READ_ONLY && type != MEM_GLOBAL);
@@ -231,6 +238,10 @@ device_texture::device_texture(Device *device,
       data_type = TYPE_UINT16;
       data_elements = 1;
       break;
+    case IMAGE_DATA_TYPE_TEXTURE_CACHE:
+      data_type = TYPE_UINT64;
+      data_elements = 2;
+      break;
     case IMAGE_DATA_NUM_TYPES:
       assert(0);
       return;
@@ -254,6 +254,7 @@ class device_memory {
   void device_alloc();
   void device_free();
   void device_copy_to();
+  void device_copy_to(size_t offset, size_t size);
   void device_copy_from(int y, int w, int h, int elem);
   void device_zero();
 
@@ -338,6 +339,8 @@ template<typename T> class device_vector : public device_memory {
     data_elements = device_type_traits<T>::num_elements;
     modified = true;
     need_realloc_ = true;
+    modified_begin = 0;
+    modified_end = 0;
 
     assert(data_elements > 0);
   }
@@ -461,6 +464,24 @@ template<typename T> class device_vector : public device_memory {
     modified = true;
   }
 
+  /* Tag a range of elements as modified. Unless the whole vector is tagged as
+   * modified, only the range spanning all tagged elements is copied to the device. */
+  void tag_modified(size_t offset, size_t size)
+  {
+    if (size == 0) {
+      return;
+    }
+
+    if (modified_end == modified_begin) {
+      modified_begin = offset;
+      modified_end = offset + size;
+    }
+    else {
+      modified_begin = (offset < modified_begin) ? offset : modified_begin;
+      modified_end = (offset + size > modified_end) ? offset + size : modified_end;
+    }
+  }
+
   void tag_realloc()
   {
     need_realloc_ = true;
@@ -492,17 +513,24 @@ template<typename T> class device_vector : public device_memory {
 
   void copy_to_device_if_modified()
   {
-    if (!modified) {
-      return;
+    if (modified) {
+      copy_to_device();
+    }
+    else if (modified_end > modified_begin) {
+      assert(modified_end <= data_size);
+      device_copy_to(sizeof(T) * modified_begin, sizeof(T) * (modified_end - modified_begin));
     }
 
-    copy_to_device();
+    modified_begin = 0;
+    modified_end = 0;
   }
 
   void clear_modified()
   {
     modified = false;
     need_realloc_ = false;
+    modified_begin = 0;
+    modified_end = 0;
   }
 
   void copy_from_device()
@@ -533,6 +561,10 @@ template<typename T> class device_vector : public device_memory {
   {
     return width * ((height == 0) ? 1 : height) * ((depth == 0) ? 1 : depth);
   }
+
+  /* Range of elements tagged as modified, empty if begin and end are equal. */
+  size_t modified_begin;
+  size_t modified_end;
 };
 
 /* Pixel Memory
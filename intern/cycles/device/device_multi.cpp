@@ -132,9 +132,22 @@ class MultiDevice : public Device {
     vector<string> servers = discovery.get_server_list();
 
     foreach (string &server, servers) {
-      Device *device = device_network_create(info, stats, profiler, server.c_str());
-      if (device)
-        devices.push_back(SubDevice(device));
+      DeviceInfo network_info;
+      network_info.type = DEVICE_NETWORK;
+      network_info.description = "Network Device " + server;
+      network_info.id = "NETWORK_" + server;
+      network_info.denoisers = DENOISER_NONE;
+
+      devices.emplace_back();
+      SubDevice *sub = &devices.back();
+      sub->device = device_network_create(network_info, sub->stats, profiler, server.c_str());
+
+      /* Skip servers that can not be connected to. */
+      if (!sub->device->error_message().empty()) {
+        VLOG(1) << sub->device->error_message();
+        delete sub->device;
+        devices.pop_back();
+      }
     }
 #endif
   }
@@ -436,6 +449,30 @@ class MultiDevice : public Device {
     stats.mem_alloc(mem.device_size - existing_size);
   }
 
+  void mem_copy_to_range(device_memory &mem, size_t offset, size_t size) override
+  {
+    device_ptr existing_key = mem.device_pointer;
+
+    if (!existing_key || (strcmp(mem.name, "RenderBuffers") == 0 && use_denoising)) {
+      mem_copy_to(mem);
+      return;
+    }
+
+    /* Memory is already allocated, so only the owner device of each peer island needs to copy
+     * the range. Pointers on other devices in the island stay the same. */
+    foreach (const vector<SubDevice *> &island, peer_islands) {
+      SubDevice *owner_sub = find_suitable_mem_device(existing_key, island);
+      mem.device = owner_sub->device;
+      mem.device_pointer = owner_sub->ptr_map[existing_key];
+
+      owner_sub->device->mem_copy_to_range(mem, offset, size);
+      owner_sub->ptr_map[existing_key] = mem.device_pointer;
+    }
+
+    mem.device = this;
+    mem.device_pointer = existing_key;
+  }
+
   void mem_copy_from(device_memory &mem, int y, int w, int h, int elem) override
   {
     device_ptr key = mem.device_pointer;
@@ -20,6 +20,8 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_set.h"
+#include "util/util_thread.h"
 
 #if defined(WITH_NETWORK)
 
@@ -50,20 +52,64 @@ class NetworkDevice : public Device {
 
   thread_mutex rpc_lock;
 
+  /* While a task runs, requests from the server are handled in the task thread, so that
+   * multiple network devices can render at the same time. The receive thread is the only one
+   * reading from the socket then, it queues requests for the task thread and reads replies to
+   * memory copies of other threads. Those can not wait for the task thread, which may be
+   * blocked on the session for as long as they hold its tile lock, as when mapping neighbor
+   * tiles for denoising. */
+  thread *task_thread;
+  thread *receive_thread;
+
+  /* Request from the server, with everything sent along with it. */
+  struct ServerRequest {
+    string name;
+    uint tile_types = 0;
+    RenderTile tile;
+    /* Samples rendered so far, sent along with a stolen tile. */
+    vector<uint8_t> stolen_data;
+  };
+
+  /* Serializes receiving, and protects the state shared with the receive thread. */
+  thread_mutex receive_mutex;
+  thread_condition_variable receive_cond;
+  bool receiving;
+  list<ServerRequest> requests;
+  /* Memory waiting for the reply to mem_copy_from, only one copy is waited for at a time. */
+  thread_mutex copy_from_mutex;
+  device_memory *copy_from_mem;
+
+  /* Tiles that are being rendered by the server, only accessed from the task thread. */
+  TileList the_tiles;
+
+  /* Memory for which the host side was sent along with a stolen tile, and so does not have to
+   * be copied back from the server when the tile moves to another device. */
+  set<device_ptr> host_synced_pointers;
+
   virtual bool show_samples() const
   {
     return false;
   }
 
   NetworkDevice(DeviceInfo &info, Stats &stats, Profiler &profiler, const char *address)
-      : Device(info, stats, profiler, true), socket(io_service)
+      : Device(info, stats, profiler, true),
+        socket(io_service),
+        task_thread(NULL),
+        receive_thread(NULL),
+        receiving(false),
+        copy_from_mem(NULL)
   {
     error_func = NetworkError();
+
+    string host;
+    int port;
+    network_address_split(address, host, port);
+
     stringstream portstr;
-    portstr << SERVER_PORT;
+    portstr << port;
 
     tcp::resolver resolver(io_service);
-    tcp::resolver::query query(address, portstr.str());
+    tcp::resolver::query query(host, portstr.str());
     tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
     tcp::resolver::iterator end;
 
@@ -73,14 +119,24 @@ class NetworkDevice : public Device {
       socket.connect(*endpoint_iterator++, error);
     }
 
-    if (error)
+    if (error) {
       error_func.network_error(error.message());
+      set_error(string_printf("Failed to connect to render server %s: %s",
+                              address,
+                              error.message().c_str()));
+    }
+    else {
+      /* Requests and replies are small and latency sensitive. */
+      socket.set_option(tcp::no_delay(true));
+    }
 
     mem_counter = 0;
   }
 
   ~NetworkDevice()
   {
+    task_wait();
+
     RPCSend snd(socket, &error_func, "stop");
     snd.write();
   }
@@ -90,8 +146,26 @@ class NetworkDevice : public Device {
     return BVH_LAYOUT_BVH2;
   }
 
+  /* Tiles rendered on a server can be stolen by other devices. The server itself can only
+   * steal a tile when it has none left in flight, since otherwise the task thread could end up
+   * waiting for one of its own tiles, which it is the only one to receive. */
+  bool tiles_can_be_stolen() const override
+  {
+    return true;
+  }
+
+  bool can_steal_tile() const override
+  {
+    return the_tiles.empty();
+  }
+
   void mem_alloc(device_memory &mem)
   {
+    if (mem.type == MEM_TEXTURE) {
+      texture_error();
+      return;
+    }
+
     if (mem.name) {
       VLOG(1) << "Buffer allocate: " << mem.name << ", "
               << string_human_readable_number(mem.memory_size()) << " bytes. ("
@@ -109,21 +183,43 @@ class NetworkDevice : public Device {
 
   void mem_copy_to(device_memory &mem)
   {
+    if (mem.type == MEM_TEXTURE) {
+      texture_error();
+      return;
+    }
+
+    if (!mem.device_pointer) {
+      mem_alloc(mem);
+    }
+
     thread_scoped_lock lock(rpc_lock);
 
+    host_synced_pointers.erase(mem.device_pointer);
+
     RPCSend snd(socket, &error_func, "mem_copy_to");
 
     snd.add(mem);
     snd.write();
-    snd.write_buffer(mem.host_pointer, mem.memory_size());
+    snd.write_buffer(mem.host_pointer, mem.memory_size(), true);
   }
 
   void mem_copy_from(device_memory &mem, int y, int w, int h, int elem)
   {
+    thread_scoped_lock copy_lock(copy_from_mutex);
+    thread_scoped_lock receive_lock(receive_mutex);
     thread_scoped_lock lock(rpc_lock);
 
+    if (host_synced_pointers.find(mem.device_pointer) != host_synced_pointers.end()) {
+      return;
+    }
+
     size_t data_size = mem.memory_size();
 
+    /* Set before sending, the receive thread may get the reply right away. */
+    if (receiving) {
+      copy_from_mem = &mem;
+    }
+
     RPCSend snd(socket, &error_func, "mem_copy_from");
 
     snd.add(mem);
@@ -133,14 +229,30 @@ class NetworkDevice : public Device {
     snd.add(elem);
     snd.write();
 
+    lock.unlock();
+
+    if (receiving) {
+      while (copy_from_mem && receiving) {
+        receive_cond.wait(receive_lock);
+      }
+      copy_from_mem = NULL;
+      return;
+    }
+
     RPCReceive rcv(socket, &error_func);
     rcv.read_buffer(mem.host_pointer, data_size);
   }
 
   void mem_zero(device_memory &mem)
   {
+    if (!mem.device_pointer) {
+      mem_alloc(mem);
+    }
+
     thread_scoped_lock lock(rpc_lock);
 
+    host_synced_pointers.erase(mem.device_pointer);
+
     RPCSend snd(socket, &error_func, "mem_zero");
 
     snd.add(mem);
@@ -152,6 +264,8 @@ class NetworkDevice : public Device {
     if (mem.device_pointer) {
       thread_scoped_lock lock(rpc_lock);
 
+      host_synced_pointers.erase(mem.device_pointer);
+
       RPCSend snd(socket, &error_func, "mem_free");
 
       snd.add(mem);
@@ -172,7 +286,7 @@ class NetworkDevice : public Device {
     snd.add(name_string);
     snd.add(size);
     snd.write();
-    snd.write_buffer(host, size);
+    snd.write_buffer(host, size, true);
   }
 
   bool load_kernels(const DeviceRequestedFeatures &requested_features)
@@ -180,24 +294,27 @@ class NetworkDevice : public Device {
     if (error_func.have_error())
       return false;
 
+    /* Kernels are loaded before tasks, so there is no receive thread. */
+    thread_scoped_lock receive_lock(receive_mutex);
+    assert(!receiving);
     thread_scoped_lock lock(rpc_lock);
 
     RPCSend snd(socket, &error_func, "load_kernels");
-    snd.add(requested_features.experimental);
-    snd.add(requested_features.max_closure);
-    snd.add(requested_features.max_nodes_group);
-    snd.add(requested_features.nodes_features);
+    snd.add(requested_features);
     snd.write();
 
-    bool result;
+    bool result = false;
     RPCReceive rcv(socket, &error_func);
     rcv.read(result);
 
-    return result;
+    return result && !error_func.have_error();
   }
 
   void task_add(DeviceTask &task)
   {
+    /* Wait for a previous task, there is only one task thread. */
+    task_wait();
+
     thread_scoped_lock lock(rpc_lock);
 
     the_task = task;
@@ -205,90 +322,226 @@ class NetworkDevice : public Device {
     RPCSend snd(socket, &error_func, "task_add");
     snd.add(task);
     snd.write();
+
+    /* The server handles the task while waiting for it, so start waiting right away. */
+    RPCSend snd_wait(socket, &error_func, "task_wait");
+    snd_wait.write();
+
+    lock.unlock();
+
+    {
+      thread_scoped_lock receive_lock(receive_mutex);
+      receiving = true;
+    }
+
+    receive_thread = new thread(function_bind(&NetworkDevice::receive_run, this));
+    task_thread = new thread(function_bind(&NetworkDevice::task_run, this));
   }
 
   void task_wait()
   {
-    thread_scoped_lock lock(rpc_lock);
+    if (task_thread) {
+      task_thread->join();
+      delete task_thread;
+      task_thread = NULL;
+    }
+
+    if (receive_thread) {
+      receive_thread->join();
+      delete receive_thread;
+      receive_thread = NULL;
+    }
+
+    if (error_func.have_error()) {
+      set_error("Network error: " + error_func.message());
+    }
+  }
 
-    RPCSend snd(socket, &error_func, "task_wait");
+  void task_cancel()
+  {
+    thread_scoped_lock lock(rpc_lock);
+    RPCSend snd(socket, &error_func, "task_cancel");
     snd.write();
+  }
 
-    lock.unlock();
+  int get_split_task_count(DeviceTask &)
+  {
+    return 1;
+  }
 
-    TileList the_tiles;
+ private:
+  /* Receive from the server until it finished the task and all memory copies requested
+   * before were answered. */
+  void receive_run()
+  {
+    thread_scoped_lock lock(receive_mutex, std::defer_lock);
+    bool task_done = false;
 
-    /* todo: run this threaded for connecting to multiple clients */
     for (;;) {
-      if (error_func.have_error())
+      RPCReceive rcv(socket, &error_func);
+
+      lock.lock();
+
+      if (error_func.have_error()) {
         break;
+      }
 
-      RenderTile tile;
+      if (rcv.name == "mem_copy_from") {
+        if (!copy_from_mem) {
+          error_func.network_error("Network receive error: unexpected memory copy");
+          break;
+        }
 
-      lock.lock();
-      RPCReceive rcv(socket, &error_func);
+        rcv.read_buffer(copy_from_mem->host_pointer, copy_from_mem->memory_size());
+        copy_from_mem = NULL;
+        receive_cond.notify_all();
+      }
+      else {
+        ServerRequest request;
+        request.name = rcv.name;
 
-      if (rcv.name == "acquire_tile") {
-        lock.unlock();
+        if (rcv.name == "acquire_tile") {
+          rcv.read(request.tile_types);
+        }
+        else if (rcv.name == "release_tile") {
+          rcv.read(request.tile);
+
+          /* The samples rendered so far are sent along with a stolen tile. */
+          if (request.tile.stealing_state == RenderTile::WAS_STOLEN) {
+            rcv.read_buffer(request.stolen_data);
+          }
+        }
+        else if (rcv.name == "task_wait_done") {
+          task_done = true;
+        }
+        else {
+          error_func.network_error("Network receive error: unexpected RPC \"" + rcv.name +
+                                   "\"");
+          break;
+        }
+
+        requests.push_back(request);
+        receive_cond.notify_all();
+      }
 
-        /* todo: watch out for recursive calls! */
-        if (the_task.acquire_tile(this, tile)) { /* write return as bool */
+      /* Stop unless the reply to a memory copy is still to come. This is checked along with
+       * clearing the receiving flag, so later copies receive their reply themselves. */
+      if (task_done && !copy_from_mem) {
+        break;
+      }
+
+      lock.unlock();
+    }
+
+    receiving = false;
+    receive_cond.notify_all();
+  }
+
+  /* Handle requests from the server until it finished the task. */
+  void task_run()
+  {
+    for (;;) {
+      ServerRequest request;
+
+      {
+        thread_scoped_lock lock(receive_mutex);
+        while (requests.empty() && receiving) {
+          receive_cond.wait(lock);
+        }
+        if (requests.empty()) {
+          break;
+        }
+        request = requests.front();
+        requests.pop_front();
+      }
+
+      if (request.name == "acquire_tile") {
+        /* Ask for a tile to be stolen before acquiring a new one, since the server may only
+         * give up tiles that are in flight when it receives the reply. */
+        bool steal = tile_steal_requested();
+
+        RenderTile tile;
+
+        if (the_task.acquire_tile(this, tile, request.tile_types)) {
           the_tiles.push_back(tile);
 
-          lock.lock();
+          thread_scoped_lock lock(rpc_lock);
           RPCSend snd(socket, &error_func, "acquire_tile");
+          snd.add(steal);
           snd.add(tile);
           snd.write();
-          lock.unlock();
         }
         else {
-          lock.lock();
+          thread_scoped_lock lock(rpc_lock);
           RPCSend snd(socket, &error_func, "acquire_tile_none");
+          snd.add(steal);
           snd.write();
-          lock.unlock();
         }
       }
-      else if (rcv.name == "release_tile") {
-        rcv.read(tile);
-        lock.unlock();
+      else if (request.name == "release_tile") {
+        RenderTile &tile = request.tile;
 
         TileList::iterator it = tile_list_find(the_tiles, tile);
-        if (it != the_tiles.end()) {
-          tile.buffers = it->buffers;
-          the_tiles.erase(it);
+        if (it == the_tiles.end()) {
+          error_func.network_error("Network receive error: release of unknown tile");
+          break;
         }
 
-        assert(tile.buffers != NULL);
+        /* Release the tile as it was acquired, with the progress made on the server. */
+        RenderTile release_tile = *it;
+        release_tile.sample = tile.sample;
+        release_tile.stealing_state = tile.stealing_state;
+        the_tiles.erase(it);
 
-        the_task.release_tile(tile);
+        if (tile.stealing_state == RenderTile::WAS_STOLEN) {
+          /* Store the samples on the host, where the device that steals the tile will copy them
+           * from. */
+          device_vector<float> &buffer = release_tile.buffers->buffer;
 
-        lock.lock();
+          if (buffer.device == this && request.stolen_data.size() == buffer.memory_size()) {
+            memcpy(buffer.host_pointer, request.stolen_data.data(), buffer.memory_size());
+
+            thread_scoped_lock lock(rpc_lock);
+            host_synced_pointers.insert(release_tile.buffer);
+          }
+        }
+
+        the_task.release_tile(release_tile);
+
+        bool steal = tile_steal_requested();
+
+        thread_scoped_lock lock(rpc_lock);
         RPCSend snd(socket, &error_func, "release_tile");
+        snd.add(steal);
         snd.write();
-        lock.unlock();
       }
-      else if (rcv.name == "task_wait_done") {
-        lock.unlock();
+      else if (request.name == "task_wait_done") {
         break;
       }
-      else
-        lock.unlock();
     }
+
+    /* Tiles still in flight are lost when the connection fails. Release them without the
+     * samples of the server, so the session does not wait for them, in particular devices
+     * waiting to steal a tile. The render then fails with the error reported by task_wait(). */
+    foreach (RenderTile &tile, the_tiles) {
+      the_task.release_tile(tile);
+    }
+    the_tiles.clear();
   }
 
-  void task_cancel()
+  /* Test if another device is waiting to steal a tile, and if so let the server give up one of
+   * its tiles. */
+  bool tile_steal_requested()
   {
-    thread_scoped_lock lock(rpc_lock);
-    RPCSend snd(socket, &error_func, "task_cancel");
-    snd.write();
+    return !the_tiles.empty() && the_task.get_tile_stolen && the_task.get_tile_stolen();
   }
 
-  int get_split_task_count(DeviceTask &)
+  void texture_error()
   {
-    return 1;
+    /* Servers would need the texture info to look up images, which is not transferred. */
+    set_error("Image textures are not supported by render servers");
   }
 
- private:
   NetworkError error_func;
 };
 
@@ -333,7 +586,12 @@ class DeviceServer {
   }
 
   DeviceServer(Device *device_, tcp::socket &socket_)
-      : device(device_), socket(socket_), stop(false), blocked_waiting(false)
+      : device(device_),
+        socket(socket_),
+        num_tiles_in_flight(0),
+        tile_steal_requested(false),
+        stop(false),
+        blocked_waiting(false)
   {
     error_func = NetworkError();
   }
@@ -355,7 +613,8 @@ class DeviceServer {
     thread_scoped_lock lock(rpc_lock);
     RPCReceive rcv(socket, &error_func);
 
-    if (rcv.name == "stop")
+    /* Stop on errors, the connection is most likely lost. */
+    if (rcv.name == "stop" || have_error())
       stop = true;
     else
       process(rcv, lock);
@@ -466,30 +725,18 @@ class DeviceServer {
       size_t data_size = mem.memory_size();
       device_ptr client_pointer = mem.device_pointer;
 
-      if (client_pointer) {
-        /* Lookup existing host side data buffer. */
-        DataVector &data_v = data_vector_find(client_pointer);
-        mem.host_pointer = (void *)&data_v[0];
+      /* Lookup existing host side data buffer, the client allocates before copying. */
+      DataVector &data_v = data_vector_find(client_pointer);
+      mem.host_pointer = (data_size) ? (void *)&data_v[0] : 0;
 
-        /* Translate the client pointer to a real device pointer. */
-        mem.device_pointer = device_ptr_from_client_pointer(client_pointer);
-      }
-      else {
-        /* Allocate host side data buffer. */
-        DataVector &data_v = data_vector_insert(client_pointer, data_size);
-        mem.host_pointer = (data_size) ? (void *)&(data_v[0]) : 0;
-      }
+      /* Translate the client pointer to a real device pointer. */
+      mem.device_pointer = device_ptr_from_client_pointer(client_pointer);
 
       /* Copy data from network into memory buffer. */
       rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
 
       /* Copy the data from the memory buffer to the device buffer. */
       device->mem_copy_to(mem);
-
-      if (!client_pointer) {
-        /* Store a mapping to/from client_pointer and real device pointer. */
-        pointer_mapping_insert(client_pointer, mem.device_pointer);
-      }
     }
     else if (rcv.name == "mem_copy_from") {
       string name;
@@ -507,7 +754,7 @@ class DeviceServer {
 
       DataVector &data_v = data_vector_find(client_pointer);
 
-      mem.host_pointer = (device_ptr) & (data_v[0]);
+      mem.host_pointer = (void *)&data_v[0];
 
       device->mem_copy_from(mem, y, w, h, elem);
 
@@ -515,7 +762,7 @@ class DeviceServer {
 
       RPCSend snd(socket, &error_func, "mem_copy_from");
       snd.write();
-      snd.write_buffer((uint8_t *)mem.host_pointer, data_size);
+      snd.write_buffer(mem.host_pointer, data_size);
       lock.unlock();
     }
     else if (rcv.name == "mem_zero") {
@@ -527,27 +774,15 @@ class DeviceServer {
       size_t data_size = mem.memory_size();
       device_ptr client_pointer = mem.device_pointer;
 
-      if (client_pointer) {
-        /* Lookup existing host side data buffer. */
-        DataVector &data_v = data_vector_find(client_pointer);
-        mem.host_pointer = (void *)&data_v[0];
+      /* Lookup existing host side data buffer, the client allocates before zeroing. */
+      DataVector &data_v = data_vector_find(client_pointer);
+      mem.host_pointer = (data_size) ? (void *)&data_v[0] : 0;
 
-        /* Translate the client pointer to a real device pointer. */
-        mem.device_pointer = device_ptr_from_client_pointer(client_pointer);
-      }
-      else {
-        /* Allocate host side data buffer. */
-        DataVector &data_v = data_vector_insert(client_pointer, data_size);
-        mem.host_pointer = (void *) ? (device_ptr) & (data_v[0]) : 0;
-      }
+      /* Translate the client pointer to a real device pointer. */
+      mem.device_pointer = device_ptr_from_client_pointer(client_pointer);
 
       /* Zero memory. */
       device->mem_zero(mem);
-
-      if (!client_pointer) {
-        /* Store a mapping to/from client_pointer and real device pointer. */
-        pointer_mapping_insert(client_pointer, mem.device_pointer);
-      }
     }
     else if (rcv.name == "mem_free") {
       string name;
@@ -570,17 +805,14 @@ class DeviceServer {
       rcv.read(size);
 
       vector<char> host_vector(size);
-      rcv.read_buffer(&host_vector[0], size);
+      rcv.read_buffer(host_vector.data(), size);
       lock.unlock();
 
       device->const_copy_to(name_string.c_str(), &host_vector[0], size);
     }
     else if (rcv.name == "load_kernels") {
       DeviceRequestedFeatures requested_features;
-      rcv.read(requested_features.experimental);
-      rcv.read(requested_features.max_closure);
-      rcv.read(requested_features.max_nodes_group);
-      rcv.read(requested_features.nodes_features);
+      rcv.read(requested_features);
 
       bool result;
       result = device->load_kernels(requested_features);
@@ -610,12 +842,13 @@ class DeviceServer {
       if (task.shader_output)
         task.shader_output = device_ptr_from_client_pointer(task.shader_output);
 
-      task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2);
+      task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2, _3);
       task.release_tile = function_bind(&DeviceServer::task_release_tile, this, _1);
-      task.update_progress_sample = function_bind(&DeviceServer::task_update_progress_sample,
-                                                  this);
+      task.update_progress_sample = function_bind(
+          &DeviceServer::task_update_progress_sample, this, _1, _2);
       task.update_tile_sample = function_bind(&DeviceServer::task_update_tile_sample, this, _1);
       task.get_cancel = function_bind(&DeviceServer::task_get_cancel, this);
+      task.get_tile_stolen = function_bind(&DeviceServer::task_get_tile_stolen, this);
 
       device->task_add(task);
     }
@@ -635,39 +868,43 @@ class DeviceServer {
       lock.unlock();
       device->task_cancel();
     }
-    else if (rcv.name == "acquire_tile") {
-      AcquireEntry entry;
-      entry.name = rcv.name;
-      rcv.read(entry.tile);
-      acquire_queue.push_back(entry);
-      lock.unlock();
-    }
-    else if (rcv.name == "acquire_tile_none") {
-      AcquireEntry entry;
-      entry.name = rcv.name;
-      acquire_queue.push_back(entry);
-      lock.unlock();
-    }
-    else if (rcv.name == "release_tile") {
+    else if (rcv.name == "acquire_tile" || rcv.name == "acquire_tile_none" ||
+             rcv.name == "release_tile") {
       AcquireEntry entry;
       entry.name = rcv.name;
+
+      /* Replies to tile requests tell if a tile should be given up for another device. */
+      bool steal = false;
+      rcv.read(steal);
+      if (steal) {
+        tile_steal_requested = true;
+      }
+
+      if (rcv.name == "acquire_tile") {
+        rcv.read(entry.tile);
+      }
+
       acquire_queue.push_back(entry);
       lock.unlock();
     }
     else {
-      cout << "Error: unexpected RPC receive call \"" + rcv.name + "\"\n";
+      network_error("Unexpected RPC receive call \"" + rcv.name + "\"");
       lock.unlock();
     }
   }
 
-  bool task_acquire_tile(Device *, RenderTile &tile)
+  bool task_acquire_tile(Device *, RenderTile &tile, uint tile_types)
   {
     thread_scoped_lock acquire_lock(acquire_mutex);
 
     bool result = false;
 
-    RPCSend snd(socket, &error_func, "acquire_tile");
-    snd.write();
+    {
+      thread_scoped_lock lock(rpc_lock);
+      RPCSend snd(socket, &error_func, "acquire_tile");
+      snd.add(tile_types);
+      snd.write();
+    }
 
     do {
       if (blocked_waiting)
@@ -686,6 +923,8 @@ class DeviceServer {
           if (tile.buffer)
             tile.buffer = ptr_map[tile.buffer];
 
+          num_tiles_in_flight++;
+
           result = true;
           break;
         }
@@ -701,7 +940,7 @@ class DeviceServer {
     return result;
   }
 
-  void task_update_progress_sample()
+  void task_update_progress_sample(long, int)
   {
     ; /* skip */
   }
@@ -715,14 +954,38 @@ class DeviceServer {
   {
     thread_scoped_lock acquire_lock(acquire_mutex);
 
+    device_ptr real_buffer = tile.buffer;
+
     if (tile.buffer)
       tile.buffer = ptr_imap[tile.buffer];
 
+    /* A steal request only applies to tiles that were in flight when it was received. */
+    if (--num_tiles_in_flight == 0) {
+      tile_steal_requested = false;
+    }
+
     {
       thread_scoped_lock lock(rpc_lock);
       RPCSend snd(socket, &error_func, "release_tile");
       snd.add(tile);
       snd.write();
+
+      if (tile.stealing_state == RenderTile::WAS_STOLEN) {
+        /* Send the samples rendered so far, so the tile can continue on another device. */
+        DataVector &data_v = data_vector_find(tile.buffer);
+
+        network_device_memory mem(device);
+        mem.data_type = TYPE_FLOAT;
+        mem.data_elements = 1;
+        mem.data_size = mem.data_width = data_v.size() / sizeof(float);
+        mem.host_pointer = (void *)&data_v[0];
+        mem.device_pointer = real_buffer;
+
+        device->mem_copy_from(mem, 0, mem.data_width, 1, sizeof(float));
+
+        snd.write_buffer(mem.host_pointer, data_v.size());
+      }
+
       lock.unlock();
     }
 
@@ -745,7 +1008,7 @@ class DeviceServer {
           cout << "Error: unexpected release RPC receive call \"" + entry.name + "\"\n";
         }
       }
-    } while (acquire_queue.empty() && !stop);
+    } while (acquire_queue.empty() && !stop && !have_error());
   }
 
   bool task_get_cancel()
@@ -753,6 +1016,13 @@ class DeviceServer {
     return false;
   }
 
+  bool task_get_tile_stolen()
+  {
+    /* Only one tile is given up for every request. */
+    bool expected = true;
+    return tile_steal_requested.compare_exchange_strong(expected, false);
+  }
+
   /* properties */
   Device *device;
   tcp::socket &socket;
@@ -770,8 +1040,12 @@ class DeviceServer {
   thread_mutex acquire_mutex;
   list<AcquireEntry> acquire_queue;
 
-  bool stop;
-  bool blocked_waiting;
+  /* Tile stealing. */
+  int num_tiles_in_flight;
+  std::atomic<bool> tile_steal_requested;
+
+  std::atomic<bool> stop;
+  std::atomic<bool> blocked_waiting;
 
  private:
   NetworkError error_func;
@@ -779,19 +1053,21 @@ class DeviceServer {
   /* todo: free memory and device (osl) on network error */
 };
 
-void Device::server_run()
+void Device::server_run(int port, int num_connections)
 {
   try {
     /* starts thread that responds to discovery requests */
-    ServerDiscovery discovery;
+    ServerDiscovery discovery(false, port);
 
-    for (;;) {
+    for (int connection = 0; num_connections == 0 || connection < num_connections;
+         connection++) {
       /* accept connection */
       boost::asio::io_service io_service;
-      tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), SERVER_PORT));
+      tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
 
       tcp::socket socket(io_service);
       acceptor.accept(socket);
+      socket.set_option(tcp::no_delay(true));
 
       string remote_address = socket.remote_endpoint().address().to_string();
       printf("Connected to remote client at: %s\n", remote_address.c_str());
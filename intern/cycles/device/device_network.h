@@ -33,10 +33,15 @@
 #  include <iostream>
 #  include <sstream>
 
+#  include <zlib.h>
+
+#  include "device/device.h"
+
 #  include "render/buffers.h"
 
 #  include "util/util_foreach.h"
 #  include "util/util_list.h"
+#  include "util/util_logging.h"
 #  include "util/util_map.h"
 #  include "util/util_param.h"
 #  include "util/util_string.h"
@@ -56,6 +61,41 @@ static const int DISCOVER_PORT = 5121;
 static const string DISCOVER_REQUEST_MSG = "REQUEST_RENDER_SERVER_IP";
 static const string DISCOVER_REPLY_MSG = "REPLY_RENDER_SERVER_IP";
 
+/* Every RPC starts with a fixed size binary header, which is followed by the serialized
+ * arguments. Client and server are expected to run on machines with the same endianness,
+ * same as the binary archives used for the arguments. */
+static const uint32_t RPC_MAGIC = 0x43435250; /* "PRCC" */
+static const uint32_t RPC_VERSION = 1;
+
+/* Buffers of at least this size are compressed before they are sent, when requested. */
+static const size_t RPC_COMPRESS_MIN_SIZE = 64 * 1024;
+
+struct RPCHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t size;
+};
+
+struct RPCBufferHeader {
+  uint64_t size;
+  /* Zero if the buffer is sent uncompressed. */
+  uint64_t compressed_size;
+};
+
+/* Split a server address of the form "host" or "host:port". */
+static inline void network_address_split(const string &address, string &host, int &port)
+{
+  size_t colon = address.rfind(':');
+  if (colon == string::npos) {
+    host = address;
+    port = SERVER_PORT;
+  }
+  else {
+    host = address.substr(0, colon);
+    port = atoi(address.substr(colon + 1).c_str());
+  }
+}
+
 #  if 0
 typedef boost::archive::text_oarchive o_archive;
 typedef boost::archive::text_iarchive i_archive;
@@ -95,13 +135,19 @@ class NetworkError {
 
   void network_error(const string &message)
   {
+    VLOG(1) << "Network error: " << message;
     error = message;
     error_count += 1;
   }
 
   bool have_error()
   {
-    return true ? error_count > 0 : false;
+    return error_count > 0;
+  }
+
+  const string &message()
+  {
+    return error;
   }
 
  private:
@@ -118,7 +164,7 @@ class RPCSend {
   {
     archive &name_;
     error_func = e;
-    fprintf(stderr, "rpc send %s\n", name.c_str());
+    VLOG(3) << "RPC send " << name;
   }
 
   ~RPCSend()
@@ -130,7 +176,6 @@ class RPCSend {
     archive &mem.data_type &mem.data_elements &mem.data_size;
     archive &mem.data_width &mem.data_height &mem.data_depth &mem.device_pointer;
     archive &mem.type &string(mem.name);
-    archive &mem.interpolation &mem.extension;
     archive &mem.device_pointer;
   }
 
@@ -145,56 +190,88 @@ class RPCSend {
     archive &type &task.x &task.y &task.w &task.h;
     archive &task.rgba_byte &task.rgba_half &task.buffer &task.sample &task.num_samples;
     archive &task.offset &task.stride;
-    archive &task.shader_input &task.shader_output &task.shader_eval_type;
+    archive &task.shader_input &task.shader_output &task.shader_eval_type &task.shader_filter;
     archive &task.shader_x &task.shader_w;
-    archive &task.need_finish_queue;
+    archive &task.tile_types &task.pass_stride &task.frame_stride &task.target_pass_stride;
+    archive &task.pass_denoising_data &task.pass_denoising_clean;
+    archive &task.need_finish_queue &task.integrator_branched;
+    archive &task.adaptive_sampling.use &task.adaptive_sampling.adaptive_step;
+    archive &task.adaptive_sampling.min_samples;
+  }
+
+  void add(const DeviceRequestedFeatures &features)
+  {
+    archive &features.experimental &features.max_nodes_group &features.nodes_features;
+    archive &features.use_hair &features.use_hair_thick;
+    archive &features.use_object_motion &features.use_camera_motion;
+    archive &features.use_baking &features.use_subsurface &features.use_volume;
+    archive &features.use_integrator_branched &features.use_patch_evaluation;
+    archive &features.use_transparent &features.use_shadow_tricks &features.use_principled;
+    archive &features.use_denoising &features.use_shader_raytrace;
+    archive &features.use_true_displacement &features.use_background_light;
   }
 
   void add(const RenderTile &tile)
   {
-    archive &tile.x &tile.y &tile.w &tile.h;
+    int task = (int)tile.task;
+    int stealing_state = (int)tile.stealing_state;
+    archive &task &tile.x &tile.y &tile.w &tile.h;
     archive &tile.start_sample &tile.num_samples &tile.sample;
-    archive &tile.resolution &tile.offset &tile.stride;
-    archive &tile.buffer;
+    archive &tile.resolution &tile.offset &tile.stride &tile.tile_index;
+    archive &tile.buffer &stealing_state;
   }
 
   void write()
   {
-    boost::system::error_code error;
-
     /* get string from stream */
     string archive_str = archive_stream.str();
 
     /* first send fixed size header with size of following data */
-    ostringstream header_stream;
-    header_stream << setw(8) << hex << archive_str.size();
-    string header_str = header_stream.str();
+    RPCHeader header;
+    header.magic = RPC_MAGIC;
+    header.version = RPC_VERSION;
+    header.size = archive_str.size();
 
-    boost::asio::write(
-        socket, boost::asio::buffer(header_str), boost::asio::transfer_all(), error);
-
-    if (error.value())
-      error_func->network_error(error.message());
+    write_raw(&header, sizeof(header));
 
     /* then send actual data */
-    boost::asio::write(
-        socket, boost::asio::buffer(archive_str), boost::asio::transfer_all(), error);
-
-    if (error.value())
-      error_func->network_error(error.message());
+    write_raw(archive_str.data(), archive_str.size());
 
     sent = true;
   }
 
-  void write_buffer(void *buffer, size_t size)
+  /* Send a buffer following the RPC, optionally compressed, which is worth it for scene data
+   * but not for render results that are sent back. */
+  void write_buffer(const void *buffer, size_t size, bool compress = false)
   {
-    boost::system::error_code error;
+    RPCBufferHeader header;
+    header.size = size;
+    header.compressed_size = 0;
+
+    vector<uint8_t> compressed;
+
+    if (compress && size >= RPC_COMPRESS_MIN_SIZE) {
+      uLongf compressed_size = compressBound(size);
+      compressed.resize(compressed_size);
+
+      if (compress2(&compressed[0],
+                    &compressed_size,
+                    (const Bytef *)buffer,
+                    size,
+                    Z_BEST_SPEED) == Z_OK &&
+          compressed_size < size) {
+        header.compressed_size = compressed_size;
+      }
+    }
 
-    boost::asio::write(
-        socket, boost::asio::buffer(buffer, size), boost::asio::transfer_all(), error);
+    write_raw(&header, sizeof(header));
 
-    if (error.value())
-      error_func->network_error(error.message());
+    if (header.compressed_size) {
+      write_raw(&compressed[0], header.compressed_size);
+    }
+    else {
+      write_raw(buffer, size);
+    }
   }
 
  protected:
@@ -204,6 +281,17 @@ class RPCSend {
   o_archive archive;
   bool sent;
   NetworkError *error_func;
+
+ private:
+  void write_raw(const void *data, size_t size)
+  {
+    boost::system::error_code error;
+
+    boost::asio::write(socket, boost::asio::buffer(data, size), boost::asio::transfer_all(), error);
+
+    if (error.value())
+      error_func->network_error(error.message());
+  }
 };
 
 /* Remote procedure call Receive */
@@ -214,51 +302,43 @@ class RPCReceive {
       : socket(socket_), archive_stream(NULL), archive(NULL)
   {
     error_func = e;
-    /* read head with fixed size */
-    vector<char> header(8);
-    boost::system::error_code error;
-    size_t len = boost::asio::read(socket, boost::asio::buffer(header), error);
 
-    if (error.value()) {
-      error_func->network_error(error.message());
-    }
+    /* read header with fixed size */
+    RPCHeader header;
 
-    /* verify if we got something */
-    if (len == header.size()) {
-      /* decode header */
-      string header_str(&header[0], header.size());
-      istringstream header_stream(header_str);
+    if (!read_raw(&header, sizeof(header))) {
+      error_func->network_error("Network receive error: invalid header size");
+      return;
+    }
 
-      size_t data_size;
+    /* verify it is an RPC from a matching client or server */
+    if (header.magic != RPC_MAGIC) {
+      error_func->network_error("Network receive error: invalid header");
+      return;
+    }
 
-      if ((header_stream >> hex >> data_size)) {
+    if (header.version != RPC_VERSION) {
+      error_func->network_error(
+          string_printf("Network receive error: protocol version %u does not match %u",
+                        header.version,
+                        RPC_VERSION));
+      return;
+    }
 
-        vector<char> data(data_size);
-        size_t len = boost::asio::read(socket, boost::asio::buffer(data), error);
+    vector<char> data(header.size);
 
-        if (error.value())
-          error_func->network_error(error.message());
+    if (!read_raw(data.data(), data.size())) {
+      error_func->network_error("Network receive error: data size doesn't match header");
+      return;
+    }
 
-        if (len == data_size) {
-          archive_str = (data.size()) ? string(&data[0], data.size()) : string("");
+    archive_str = (data.size()) ? string(&data[0], data.size()) : string("");
 
-          archive_stream = new istringstream(archive_str);
-          archive = new i_archive(*archive_stream);
+    archive_stream = new istringstream(archive_str);
+    archive = new i_archive(*archive_stream);
 
-          *archive &name;
-          fprintf(stderr, "rpc receive %s\n", name.c_str());
-        }
-        else {
-          error_func->network_error("Network receive error: data size doesn't match header");
-        }
-      }
-      else {
-        error_func->network_error("Network receive error: can't decode data size from header");
-      }
-    }
-    else {
-      error_func->network_error("Network receive error: invalid header size");
-    }
+    *archive &name;
+    VLOG(3) << "RPC receive " << name;
   }
 
   ~RPCReceive()
@@ -269,10 +349,12 @@ class RPCReceive {
 
   void read(network_device_memory &mem, string &name)
   {
+    if (!archive)
+      return;
+
     *archive &mem.data_type &mem.data_elements &mem.data_size;
     *archive &mem.data_width &mem.data_height &mem.data_depth &mem.device_pointer;
     *archive &mem.type &name;
-    *archive &mem.interpolation &mem.extension;
     *archive &mem.device_pointer;
 
     mem.name = name.c_str();
@@ -286,43 +368,93 @@ class RPCReceive {
 
   template<typename T> void read(T &data)
   {
-    *archive &data;
+    if (archive)
+      *archive &data;
   }
 
-  void read_buffer(void *buffer, size_t size)
+  /* Receive a buffer sent with RPCSend::write_buffer(). */
+  bool read_buffer(void *buffer, size_t size)
   {
-    boost::system::error_code error;
-    size_t len = boost::asio::read(socket, boost::asio::buffer(buffer, size), error);
+    RPCBufferHeader header;
 
-    if (error.value()) {
-      error_func->network_error(error.message());
+    if (!read_buffer_header(header)) {
+      return false;
     }
 
-    if (len != size)
-      cout << "Network receive error: buffer size doesn't match expected size\n";
+    if (header.size != size) {
+      /* Skip the data, to keep the stream in sync with the sender. */
+      vector<uint8_t> data((header.compressed_size) ? header.compressed_size : header.size);
+      read_raw(data.data(), data.size());
+      error_func->network_error("Network receive error: buffer size doesn't match expected size");
+      return false;
+    }
+
+    return read_buffer_data(header, buffer);
+  }
+
+  /* Receive a buffer of which the size is not known in advance. */
+  bool read_buffer(vector<uint8_t> &buffer)
+  {
+    RPCBufferHeader header;
+
+    if (!read_buffer_header(header)) {
+      return false;
+    }
+
+    buffer.resize(header.size);
+    return read_buffer_data(header, buffer.data());
   }
 
   void read(DeviceTask &task)
   {
+    if (!archive)
+      return;
+
     int type;
 
     *archive &type &task.x &task.y &task.w &task.h;
     *archive &task.rgba_byte &task.rgba_half &task.buffer &task.sample &task.num_samples;
     *archive &task.offset &task.stride;
-    *archive &task.shader_input &task.shader_output &task.shader_eval_type;
+    *archive &task.shader_input &task.shader_output &task.shader_eval_type &task.shader_filter;
     *archive &task.shader_x &task.shader_w;
-    *archive &task.need_finish_queue;
+    *archive &task.tile_types &task.pass_stride &task.frame_stride &task.target_pass_stride;
+    *archive &task.pass_denoising_data &task.pass_denoising_clean;
+    *archive &task.need_finish_queue &task.integrator_branched;
+    *archive &task.adaptive_sampling.use &task.adaptive_sampling.adaptive_step;
+    *archive &task.adaptive_sampling.min_samples;
 
     task.type = (DeviceTask::Type)type;
   }
 
+  void read(DeviceRequestedFeatures &features)
+  {
+    if (!archive)
+      return;
+
+    *archive &features.experimental &features.max_nodes_group &features.nodes_features;
+    *archive &features.use_hair &features.use_hair_thick;
+    *archive &features.use_object_motion &features.use_camera_motion;
+    *archive &features.use_baking &features.use_subsurface &features.use_volume;
+    *archive &features.use_integrator_branched &features.use_patch_evaluation;
+    *archive &features.use_transparent &features.use_shadow_tricks &features.use_principled;
+    *archive &features.use_denoising &features.use_shader_raytrace;
+    *archive &features.use_true_displacement &features.use_background_light;
+  }
+
   void read(RenderTile &tile)
   {
-    *archive &tile.x &tile.y &tile.w &tile.h;
+    if (!archive)
+      return;
+
+    int task, stealing_state;
+
+    *archive &task &tile.x &tile.y &tile.w &tile.h;
     *archive &tile.start_sample &tile.num_samples &tile.sample;
-    *archive &tile.resolution &tile.offset &tile.stride;
-    *archive &tile.buffer;
+    *archive &tile.resolution &tile.offset &tile.stride &tile.tile_index;
+    *archive &tile.buffer &stealing_state;
 
+    tile.task = (RenderTile::Task)task;
+    tile.stealing_state = (RenderTile::StealingState)stealing_state;
     tile.buffers = NULL;
   }
 
@@ -334,14 +466,67 @@ class RPCReceive {
   istringstream *archive_stream;
   i_archive *archive;
   NetworkError *error_func;
+
+ private:
+  bool read_raw(void *data, size_t size)
+  {
+    boost::system::error_code error;
+    size_t len = boost::asio::read(socket, boost::asio::buffer(data, size), error);
+
+    if (error.value()) {
+      error_func->network_error(error.message());
+    }
+
+    return len == size;
+  }
+
+  bool read_buffer_header(RPCBufferHeader &header)
+  {
+    if (!read_raw(&header, sizeof(header))) {
+      error_func->network_error("Network receive error: invalid buffer header size");
+      return false;
+    }
+    return true;
+  }
+
+  bool read_buffer_data(const RPCBufferHeader &header, void *buffer)
+  {
+    const size_t size = header.size;
+
+    if (header.compressed_size == 0) {
+      if (!read_raw(buffer, size)) {
+        error_func->network_error("Network receive error: incomplete buffer");
+        return false;
+      }
+      return true;
+    }
+
+    vector<uint8_t> compressed(header.compressed_size);
+
+    if (!read_raw(compressed.data(), compressed.size())) {
+      error_func->network_error("Network receive error: incomplete buffer");
+      return false;
+    }
+
+    uLongf uncompressed_size = size;
+
+    if (uncompress((Bytef *)buffer, &uncompressed_size, compressed.data(), compressed.size()) !=
+            Z_OK ||
+        uncompressed_size != size) {
+      error_func->network_error("Network receive error: failed to decompress buffer");
+      return false;
+    }
+
+    return true;
+  }
 };
 
 /* Server auto discovery */
 
 class ServerDiscovery {
  public:
-  explicit ServerDiscovery(bool discover = false)
-      : listen_socket(io_service), collect_servers(false)
+  explicit ServerDiscovery(bool discover = false, int port = SERVER_PORT)
+      : listen_socket(io_service), server_port(port), collect_servers(false)
   {
     /* setup listen socket */
     listen_endpoint.address(boost::asio::ip::address_v4::any());
@@ -402,8 +587,13 @@ class ServerDiscovery {
 
       /* handle incoming message */
       if (collect_servers) {
-        if (msg == DISCOVER_REPLY_MSG) {
-          string address = receive_endpoint.address().to_string();
+        /* Replies contain the port the server listens on, so multiple servers can run on the
+         * same host. */
+        if (string_startswith(msg, DISCOVER_REPLY_MSG.c_str())) {
+          int port = atoi(msg.c_str() + DISCOVER_REPLY_MSG.size());
+          string address = string_printf("%s:%d",
+                                         receive_endpoint.address().to_string().c_str(),
+                                         (port) ? port : SERVER_PORT);
 
           mutex.lock();
 
@@ -419,7 +609,7 @@ class ServerDiscovery {
       else {
         /* reply to request */
         if (msg == DISCOVER_REQUEST_MSG)
-          broadcast_message(DISCOVER_REPLY_MSG);
+          broadcast_message(string_printf("%s %d", DISCOVER_REPLY_MSG.c_str(), server_port));
       }
     }
 
@@ -467,6 +657,9 @@ class ServerDiscovery {
   char receive_buffer[256];
   boost::asio::ip::udp::endpoint receive_endpoint;
 
+  /* port of the render server, sent along with replies */
+  int server_port;
+
   // os, version, devices, status, host name, group name, ip as far as fields go
   struct ServerInfo {
     string cycles_version;
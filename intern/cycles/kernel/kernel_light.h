@@ -15,6 +15,7 @@
  */
 
 #include "kernel_light_background.h"
+#include "kernel_light_tree.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -171,7 +172,7 @@ ccl_device_inline bool lamp_light_sample(
     }
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= light_select_lamp_pdf(kg, lamp, P);
 
   return (ls->pdf > 0.0f);
 }
@@ -328,7 +329,7 @@ ccl_device bool lamp_light_eval(
     return false;
   }
 
-  ls->pdf *= kernel_data.integrator.pdf_lights;
+  ls->pdf *= light_select_lamp_pdf(kg, lamp, P);
 
   return true;
 }
@@ -365,12 +366,11 @@ ccl_device_inline bool triangle_world_space_vertices(
   return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg,
+ccl_device_inline float triangle_light_pdf_area(const float pdf,
                                                 const float3 Ng,
                                                 const float3 I,
                                                 float t)
 {
-  float pdf = kernel_data.integrator.pdf_triangles;
   float cos_pi = fabsf(dot(Ng, I));
 
   if (cos_pi == 0.0f)
@@ -388,6 +388,11 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
   float3 V[3];
   bool has_motion = triangle_world_space_vertices(kg, sd->object, sd->prim, sd->time, V);
 
+  /* sd contains the point on the light source
+   * calculate Px, the point that we're shading */
+  const float3 Px = sd->P + sd->I * t;
+  const float pdf_triangles = light_select_triangle_pdf(kg, sd->object, Px);
+
   const float3 e0 = V[1] - V[0];
   const float3 e1 = V[2] - V[0];
   const float3 e2 = V[2] - V[1];
@@ -396,9 +401,6 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
   const float distance_to_plane = fabsf(dot(N, sd->I * t)) / dot(N, N);
 
   if (longest_edge_squared > distance_to_plane * distance_to_plane) {
-    /* sd contains the point on the light source
-     * calculate Px, the point that we're shading */
-    const float3 Px = sd->P + sd->I * t;
     const float3 v0_p = V[0] - Px;
     const float3 v1_p = V[1] - Px;
     const float3 v2_p = V[2] - Px;
@@ -426,12 +428,12 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
       else {
         area = 0.5f * len(N);
       }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = area * pdf_triangles;
       return pdf / solid_angle;
     }
   }
   else {
-    float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+    float pdf = triangle_light_pdf_area(pdf_triangles, sd->Ng, sd->I, t);
     if (has_motion) {
       const float area = 0.5f * len(N);
       if (UNLIKELY(area == 0.0f)) {
@@ -579,7 +581,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
         triangle_world_space_vertices(kg, object, prim, -1.0f, V);
         area = triangle_area(V[0], V[1], V[2]);
       }
-      const float pdf = area * kernel_data.integrator.pdf_triangles;
+      const float pdf = area * light_select_triangle_pdf(kg, object, P);
       ls->pdf = pdf / solid_angle;
     }
   }
@@ -601,7 +603,8 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
     ls->P = u * V[0] + v * V[1] + t * V[2];
     /* compute incoming direction, distance and pdf */
     ls->D = normalize_len(ls->P - P, &ls->t);
-    ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
+    ls->pdf = triangle_light_pdf_area(
+        light_select_triangle_pdf(kg, object, P), ls->Ng, -ls->D, ls->t);
     if (has_motion && area != 0.0f) {
       /* scale the PDF.
        * area = the area the sample was taken from
@@ -617,15 +620,20 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg,
 
 /* Light Distribution */
 
-ccl_device int light_distribution_sample(KernelGlobals *kg, float *randu)
+ccl_device int light_distribution_sample_range(KernelGlobals *kg,
+                                               int begin,
+                                               int end,
+                                               float *randu)
 {
   /* This is basically std::upper_bound as used by PBRT, to find a point light or
    * triangle to emit from, proportional to area. a good improvement would be to
    * also sample proportional to power, though it's not so well defined with
    * arbitrary shaders. */
-  int first = 0;
-  int len = kernel_data.integrator.num_distribution + 1;
-  float r = *randu;
+  int first = begin;
+  int len = end - begin + 1;
+  const float distr_begin = kernel_tex_fetch(__light_distribution, begin).totarea;
+  const float distr_end = kernel_tex_fetch(__light_distribution, end).totarea;
+  float r = distr_begin + *randu * (distr_end - distr_begin);
 
   do {
     int half_len = len >> 1;
@@ -642,7 +650,7 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float *randu)
 
   /* Clamping should not be needed but float rounding errors seem to
    * make this fail on rare occasions. */
-  int index = clamp(first - 1, 0, kernel_data.integrator.num_distribution - 1);
+  int index = clamp(first - 1, begin, end - 1);
 
   /* Rescale to reuse random number. this helps the 2D samples within
    * each area light be stratified as well. */
@@ -653,6 +661,11 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float *randu)
   return index;
 }
 
+ccl_device int light_distribution_sample(KernelGlobals *kg, float *randu)
+{
+  return light_distribution_sample_range(kg, 0, kernel_data.integrator.num_distribution, randu);
+}
+
 /* Generic Light */
 
 ccl_device_inline bool light_select_reached_max_bounces(KernelGlobals *kg, int index, int bounce)
@@ -660,6 +673,68 @@ ccl_device_inline bool light_select_reached_max_bounces(KernelGlobals *kg, int i
   return (bounce > kernel_tex_fetch(__lights, index).max_bounces);
 }
 
+ccl_device bool light_tree_light_sample(KernelGlobals *kg,
+                                        float randu,
+                                        float randv,
+                                        float time,
+                                        float3 P,
+                                        int bounce,
+                                        LightSample *ls)
+{
+  /* Pick the tree of mesh lights, lamps or distant lamps. */
+  const float pdf_triangles = kernel_data.integrator.light_tree_pdf_triangles;
+  const float pdf_lamps = kernel_data.integrator.light_tree_pdf_lamps;
+  int root;
+
+  if (randu < pdf_triangles) {
+    root = kernel_data.integrator.light_tree_root_triangles;
+    randu = randu / pdf_triangles;
+  }
+  else if (randu < pdf_triangles + pdf_lamps) {
+    root = kernel_data.integrator.light_tree_root_lamps;
+    randu = (randu - pdf_triangles) / pdf_lamps;
+  }
+  else {
+    root = kernel_data.integrator.light_tree_root_distant;
+    randu = (randu - pdf_triangles - pdf_lamps) / kernel_data.integrator.light_tree_pdf_distant;
+  }
+
+  if (root == -1) {
+    return false;
+  }
+
+  const int leaf = light_tree_sample(kg, root, P, &randu);
+  if (leaf == -1) {
+    return false;
+  }
+
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, leaf);
+
+  if (knode->flag & LIGHT_TREE_MESH) {
+    /* Pick a triangle of the object proportional to its area. */
+    int index = light_distribution_sample_range(
+        kg, knode->distribution_begin, knode->distribution_end, &randu);
+
+    const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(
+        __light_distribution, index);
+    int prim = kdistribution->prim;
+    int object = kdistribution->mesh_light.object_id;
+    int shader_flag = kdistribution->mesh_light.shader_flag;
+
+    triangle_light_sample(kg, prim, object, randu, randv, time, ls, P);
+    ls->shader |= shader_flag;
+    return (ls->pdf > 0.0f);
+  }
+
+  int lamp = knode->emitter;
+
+  if (UNLIKELY(light_select_reached_max_bounces(kg, lamp, bounce))) {
+    return false;
+  }
+
+  return lamp_light_sample(kg, lamp, randu, randv, P, ls);
+}
+
 ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       int lamp,
                                       float randu,
@@ -669,6 +744,10 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       int bounce,
                                       LightSample *ls)
 {
+  if (lamp < 0 && kernel_data.integrator.use_light_tree) {
+    return light_tree_light_sample(kg, randu, randv, time, P, bounce, ls);
+  }
+
   if (lamp < 0) {
     /* sample index */
     int index = light_distribution_sample(kg, &randu);
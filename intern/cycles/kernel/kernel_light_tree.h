@@ -0,0 +1,166 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Lights are picked by traversing a tree built over their bounds and emission directions,
+ * choosing each child with a probability proportional to the estimated contribution of its
+ * lights to the shading point. Based on "Importance Sampling of Many Lights with Adaptive
+ * Tree Splitting" by Conty Estevez and Kulla, without the splitting. */
+
+ccl_device float light_tree_node_importance(const ccl_global KernelLightTreeNode *knode,
+                                            const float3 P)
+{
+  if (knode->flag & LIGHT_TREE_DISTANT) {
+    /* Distant lights are picked uniformly, the energy is the number of lights. */
+    return knode->energy;
+  }
+
+  const float3 bbox_min = make_float3(knode->bbox_min[0], knode->bbox_min[1], knode->bbox_min[2]);
+  const float3 bbox_max = make_float3(knode->bbox_max[0], knode->bbox_max[1], knode->bbox_max[2]);
+  const float3 centroid = 0.5f * (bbox_min + bbox_max);
+  const float radius_squared = 0.25f * len_squared(bbox_max - bbox_min);
+
+  float distance;
+  const float3 D = normalize_len(P - centroid, &distance);
+  const float distance_squared = distance * distance;
+
+  float cos_theta_prime = 1.0f;
+  if (knode->theta_o < M_PI_F && distance_squared > radius_squared) {
+    /* Smallest angle between the emission directions of the node and the shading point,
+     * taking into account the angle the bounds cover as seen from it. */
+    const float3 axis = make_float3(knode->axis[0], knode->axis[1], knode->axis[2]);
+    const float theta = safe_acosf(dot(axis, D));
+    const float theta_u = safe_asinf(sqrtf(radius_squared) / distance);
+    const float theta_prime = max(theta - knode->theta_o - theta_u, 0.0f);
+
+    if (theta_prime >= knode->theta_e) {
+      return 0.0f;
+    }
+    cos_theta_prime = cosf(theta_prime);
+  }
+
+  /* Don't let the importance grow unbounded inside the node. */
+  return knode->energy * cos_theta_prime / max(max(distance_squared, radius_squared), 1e-8f);
+}
+
+/* Traverse the tree from the root to a leaf, picking children proportional to their importance.
+ * Returns -1 when no light in the tree can contribute. */
+ccl_device int light_tree_sample(KernelGlobals *kg, int index, const float3 P, float *randu)
+{
+  float r = *randu;
+
+  while (true) {
+    const int child = kernel_tex_fetch(__light_tree_nodes, index).child;
+    if (child == -1) {
+      break;
+    }
+
+    const float importance_left = light_tree_node_importance(
+        &kernel_tex_fetch(__light_tree_nodes, child), P);
+    const float importance_right = light_tree_node_importance(
+        &kernel_tex_fetch(__light_tree_nodes, child + 1), P);
+    const float importance_total = importance_left + importance_right;
+
+    if (!(importance_total > 0.0f)) {
+      return -1;
+    }
+
+    /* Rescale to reuse random number for the next level and the sampling of the light. */
+    const float pdf_left = importance_left / importance_total;
+    if (r < pdf_left) {
+      index = child;
+      r = r / pdf_left;
+    }
+    else {
+      index = child + 1;
+      r = (r - pdf_left) / (1.0f - pdf_left);
+    }
+  }
+
+  *randu = min(r, 1.0f);
+  return index;
+}
+
+/* Probability of picking the leaf from the root of its tree, matching light_tree_sample. */
+ccl_device float light_tree_leaf_pdf(KernelGlobals *kg, int index, const float3 P)
+{
+  float pdf = 1.0f;
+
+  while (true) {
+    const int parent = kernel_tex_fetch(__light_tree_nodes, index).parent;
+    if (parent == -1) {
+      break;
+    }
+
+    const int child = kernel_tex_fetch(__light_tree_nodes, parent).child;
+    const float importance_left = light_tree_node_importance(
+        &kernel_tex_fetch(__light_tree_nodes, child), P);
+    const float importance_right = light_tree_node_importance(
+        &kernel_tex_fetch(__light_tree_nodes, child + 1), P);
+    const float importance_total = importance_left + importance_right;
+
+    if (!(importance_total > 0.0f)) {
+      return 0.0f;
+    }
+
+    pdf *= ((index == child) ? importance_left : importance_right) / importance_total;
+    index = parent;
+  }
+
+  return pdf;
+}
+
+/* Probability of picking a lamp, from the shading point P. */
+ccl_device float light_select_lamp_pdf(KernelGlobals *kg, int lamp, const float3 P)
+{
+  if (kernel_data.integrator.use_light_tree) {
+    const int leaf = kernel_tex_fetch(__light_tree_leaf_map,
+                                      kernel_data.integrator.light_tree_lamp_offset + lamp);
+    if (!(kernel_tex_fetch(__light_tree_nodes, leaf).flag & LIGHT_TREE_DISTANT)) {
+      return kernel_data.integrator.light_tree_pdf_lamps * light_tree_leaf_pdf(kg, leaf, P);
+    }
+  }
+
+  /* Distant lamps have the same probability with and without the tree. */
+  return kernel_data.integrator.pdf_lights;
+}
+
+/* Probability of picking an emissive triangle of the object, per unit of area. */
+ccl_device float light_select_triangle_pdf(KernelGlobals *kg, int object, const float3 P)
+{
+  if (kernel_data.integrator.use_light_tree) {
+    const int leaf = kernel_tex_fetch(__light_tree_leaf_map, object);
+    if (leaf == -1) {
+      return 0.0f;
+    }
+
+    /* Triangles within the object are picked proportional to their area, while the energy used
+     * to pick the leaf is also weighted by emission. */
+    const float area = kernel_tex_fetch(__light_tree_nodes, leaf).area;
+    if (area == 0.0f) {
+      return 0.0f;
+    }
+    return kernel_data.integrator.light_tree_pdf_triangles * light_tree_leaf_pdf(kg, leaf, P) /
+           area;
+  }
+
+  return kernel_data.integrator.pdf_triangles;
+}
+
+CCL_NAMESPACE_END
@@ -1387,6 +1387,16 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
+  /* light tree */
+  int use_light_tree;
+  int light_tree_root_triangles;
+  int light_tree_root_lamps;
+  int light_tree_root_distant;
+  float light_tree_pdf_triangles;
+  float light_tree_pdf_lamps;
+  float light_tree_pdf_distant;
+  int light_tree_lamp_offset;
+
   int pad1, pad2;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
@@ -1549,6 +1559,42 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+/* Light Tree */
+
+typedef enum LightTreeNodeFlag {
+  /* Leaf with the emissive triangles of an object. */
+  LIGHT_TREE_MESH = (1 << 0),
+  /* Leaf with a single lamp. */
+  LIGHT_TREE_LAMP = (1 << 1),
+  /* Node of the tree of distant and background lamps, which are picked uniformly. */
+  LIGHT_TREE_DISTANT = (1 << 2),
+} LightTreeNodeFlag;
+
+typedef struct KernelLightTreeNode {
+  float bbox_min[3];
+  /* Total power of the emitters below the node. */
+  float energy;
+  float bbox_max[3];
+  /* Bounds of the emission directions: the angle around the axis containing all the
+   * normals, and the angle around a normal in which light is emitted. */
+  float theta_o;
+  float axis[3];
+  float theta_e;
+  /* Index of the first child, the second child follows it. -1 for leaves. */
+  int child;
+  int parent;
+  int flag;
+  /* Object or lamp of leaves. */
+  int emitter;
+  /* Range of the triangles of mesh leaves in the light distribution. */
+  int distribution_begin;
+  int distribution_end;
+  /* Total area of the triangles of mesh leaves, which are picked by area within the leaf. */
+  float area;
+  int pad1;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
   int index;
   float age;
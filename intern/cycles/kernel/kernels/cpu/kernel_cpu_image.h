@@ -25,6 +25,19 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Texture cache lookup, implemented once in kernel_texture_cache.cpp for all instruction sets.
+ * Coordinates and derivatives are in image space with the origin at the bottom left. */
+void kernel_tex_image_cache_lookup(const TextureCacheHandle *cache,
+                                   uint interpolation,
+                                   uint extension,
+                                   float x,
+                                   float y,
+                                   float dxdx,
+                                   float dydx,
+                                   float dxdy,
+                                   float dydy,
+                                   float result[4]);
+
 /* Make template functions private so symbols don't conflict between kernels with different
  * instruction sets. */
 namespace {
@@ -584,6 +597,23 @@ template<typename T> struct NanoVDBInterpolator {
 
 #undef SET_CUBIC_SPLINE_WEIGHTS
 
+ccl_device float4 kernel_tex_image_cache(
+    const TextureInfo &info, float x, float y, float2 dx, float2 dy)
+{
+  float result[4];
+  kernel_tex_image_cache_lookup((const TextureCacheHandle *)info.data,
+                                info.interpolation,
+                                info.extension,
+                                x,
+                                y,
+                                dx.x,
+                                dx.y,
+                                dy.x,
+                                dy.y,
+                                result);
+  return make_float4(result[0], result[1], result[2], result[3]);
+}
+
 ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
 {
   const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
@@ -605,6 +635,8 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
       return TextureInterpolator<ushort4>::interp(info, x, y);
     case IMAGE_DATA_TYPE_FLOAT4:
       return TextureInterpolator<float4>::interp(info, x, y);
+    case IMAGE_DATA_TYPE_TEXTURE_CACHE:
+      return kernel_tex_image_cache(info, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f));
     default:
       assert(0);
       return make_float4(
@@ -612,6 +644,20 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
   }
 }
 
+/* Lookup with texture coordinate derivatives, used to pick the mipmap level of images in the
+ * texture cache. Other images are always looked up at full resolution. */
+ccl_device float4 kernel_tex_image_interp_derivatives(
+    KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy)
+{
+  const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
+
+  if (info.data_type == IMAGE_DATA_TYPE_TEXTURE_CACHE) {
+    return kernel_tex_image_cache(info, x, y, dx, dy);
+  }
+
+  return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals *kg,
                                              int id,
                                              float3 P,
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CPU kernel texture cache lookups
+ *
+ * Images in the texture cache are looked up through the OpenImageIO texture
+ * system, which loads tiles of the mipmap level matching the derivatives on
+ * first access. This is compiled once and not for every instruction set, so
+ * the kernel does not depend on OpenImageIO headers. */
+
+#include "util/util_texture.h"
+
+#include <OpenImageIO/texture.h>
+
+CCL_NAMESPACE_BEGIN
+
+OIIO_NAMESPACE_USING
+
+void kernel_tex_image_cache_lookup(const TextureCacheHandle *cache,
+                                   uint interpolation,
+                                   uint extension,
+                                   float x,
+                                   float y,
+                                   float dxdx,
+                                   float dydx,
+                                   float dxdy,
+                                   float dydy,
+                                   float result[4])
+{
+  TextureSystem *ts = (TextureSystem *)cache->texture_system;
+  TextureSystem::TextureHandle *handle = (TextureSystem::TextureHandle *)cache->handle;
+
+  TextureOpt options;
+
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      options.interpmode = TextureOpt::InterpClosest;
+      break;
+    case INTERPOLATION_CUBIC:
+    case INTERPOLATION_SMART:
+      options.interpmode = TextureOpt::InterpBicubic;
+      break;
+    default:
+      options.interpmode = TextureOpt::InterpBilinear;
+      break;
+  }
+
+  switch (extension) {
+    case EXTENSION_EXTEND:
+      options.swrap = options.twrap = TextureOpt::WrapClamp;
+      break;
+    case EXTENSION_CLIP:
+      options.swrap = options.twrap = TextureOpt::WrapBlack;
+      break;
+    default:
+      options.swrap = options.twrap = TextureOpt::WrapPeriodic;
+      break;
+  }
+
+  /* Opaque alpha for images without alpha channel, matching images loaded into memory. */
+  options.fill = 1.0f;
+
+  /* Image origin is at the top left in OpenImageIO. */
+  if (handle &&
+      ts->texture(handle, NULL, options, x, 1.0f - y, dxdx, -dydx, dxdy, -dydy, 4, result)) {
+    return;
+  }
+
+  /* This might be slow, but prevents error messages from accumulating. */
+  ts->geterror();
+
+  result[0] = TEX_IMAGE_MISSING_R;
+  result[1] = TEX_IMAGE_MISSING_G;
+  result[2] = TEX_IMAGE_MISSING_B;
+  result[3] = TEX_IMAGE_MISSING_A;
+}
+
+CCL_NAMESPACE_END
@@ -54,7 +54,6 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
   }
   ccl_barrier(CCL_LOCAL_MEM_FENCE);
 
-  /* skip sorting for cpu split kernel */
 #  ifdef __KERNEL_OPENCL__
 
   /* bitonic sort */
@@ -77,6 +76,33 @@ ccl_device void kernel_shader_sort(KernelGlobals *kg, ccl_local_param ShaderSort
       }
     }
   }
+#  else
+  /* A single thread handles the whole block on the CPU. Merge sort it, which keeps paths with
+   * the same shader in the order of their pixels. */
+  const uint num_values = (qsize - offset < SHADER_SORT_BLOCK_SIZE) ? qsize - offset :
+                                                                  SHADER_SORT_BLOCK_SIZE;
+  ushort *local_index_sorted = &locals->local_index_sorted[0];
+
+  for (uint width = 1; width < num_values; width <<= 1) {
+    for (uint begin = 0; begin < num_values; begin += 2 * width) {
+      const uint middle = (begin + width < num_values) ? begin + width : num_values;
+      const uint end = (begin + 2 * width < num_values) ? begin + 2 * width : num_values;
+      uint i = begin, j = middle;
+
+      for (uint k = begin; k < end; k++) {
+        if (i < middle && (j >= end || local_value[local_index[i]] <= local_value[local_index[j]])) {
+          local_index_sorted[k] = local_index[i++];
+        }
+        else {
+          local_index_sorted[k] = local_index[j++];
+        }
+      }
+    }
+
+    for (uint k = 0; k < num_values; k++) {
+      local_index[k] = local_index_sorted[k];
+    }
+  }
 #  endif /* __KERNEL_OPENCL__ */
 
   /* copy to destination */
@@ -16,14 +16,19 @@
 
 CCL_NAMESPACE_BEGIN
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint flags)
+ccl_device float4 svm_image_texture_derivatives(
+    KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy, uint flags)
 {
   if (id == -1) {
     return make_float4(
         TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
   }
 
+#ifdef __KERNEL_CPU__
+  float4 r = kernel_tex_image_interp_derivatives(kg, id, x, y, dx, dy);
+#else
   float4 r = kernel_tex_image_interp(kg, id, x, y);
+#endif
   const float alpha = r.w;
 
   if ((flags & NODE_IMAGE_ALPHA_UNASSOCIATE) && alpha != 1.0f && alpha != 0.0f) {
@@ -38,6 +43,12 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
   return r;
 }
 
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint flags)
+{
+  return svm_image_texture_derivatives(
+      kg, id, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f), flags);
+}
+
 /* Remap coordinate from 0..1 box to -1..-1 */
 ccl_device_inline float3 texco_remap_square(float3 co)
 {
@@ -65,6 +76,20 @@ ccl_device void svm_node_tex_image(
     tex_co = make_float2(co.x, co.y);
   }
 
+  /* Texture coordinate derivatives for mipmap lookups in the texture cache. Only for flat
+   * projection, since sphere and tube mapping wrap around. */
+  float2 tex_dx = make_float2(0.0f, 0.0f);
+  float2 tex_dy = make_float2(0.0f, 0.0f);
+  if (flags & NODE_IMAGE_DERIVATIVES) {
+    uint4 data_node = read_node(kg, offset);
+    if (node.w == NODE_IMAGE_PROJ_FLAT) {
+      float3 co_dx = stack_load_float3(stack, data_node.x);
+      float3 co_dy = stack_load_float3(stack, data_node.y);
+      tex_dx = make_float2(co_dx.x - co.x, co_dx.y - co.y);
+      tex_dy = make_float2(co_dy.x - co.x, co_dy.y - co.y);
+    }
+  }
+
   /* TODO(lukas): Consider moving tile information out of the SVM node.
    * TextureInfo seems a reasonable candidate. */
   int id = -1;
@@ -108,7 +133,7 @@ ccl_device void svm_node_tex_image(
     id = -num_nodes;
   }
 
-  float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, flags);
+  float4 f = svm_image_texture_derivatives(kg, id, tex_co.x, tex_co.y, tex_dx, tex_dy, flags);
 
   if (stack_valid(out_offset))
     stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -618,6 +618,7 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
         for (size_t k = 0; k < size; k++) {
           attr_uchar4[offset + k] = data[k];
         }
+        attr_uchar4.tag_modified(offset, size);
       }
       attr_uchar4_offset += size;
     }
@@ -630,6 +631,7 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
         for (size_t k = 0; k < size; k++) {
           attr_float[offset + k] = data[k];
         }
+        attr_float.tag_modified(offset, size);
       }
       attr_float_offset += size;
     }
@@ -642,6 +644,7 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
         for (size_t k = 0; k < size; k++) {
           attr_float2[offset + k] = data[k];
         }
+        attr_float2.tag_modified(offset, size);
       }
       attr_float2_offset += size;
     }
@@ -654,6 +657,7 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
         for (size_t k = 0; k < size * 3; k++) {
           attr_float3[offset + k] = (&tfm->x)[k];
         }
+        attr_float3.tag_modified(offset, size * 3);
       }
       attr_float3_offset += size * 3;
     }
@@ -666,6 +670,7 @@ void GeometryManager::update_attribute_element_offset(Geometry *geom,
         for (size_t k = 0; k < size; k++) {
           attr_float3[offset + k] = data[k];
         }
+        attr_float3.tag_modified(offset, size);
       }
       attr_float3_offset += size;
     }
@@ -1068,27 +1073,50 @@ void GeometryManager::device_update_mesh(
     }
   }
 
+  const bool copy_all_mesh_data = dscene->tri_shader.need_realloc() ||
+                                  dscene->tri_vindex.need_realloc() ||
+                                  dscene->tri_vnormal.need_realloc() ||
+                                  dscene->tri_patch.need_realloc() ||
+                                  dscene->tri_patch_uv.need_realloc();
+
+  /* The mapping from triangle to primitive triangle array covers all triangles in the scene, so
+   * only build it when there are triangles to pack. */
+  bool pack_any_verts = copy_all_mesh_data;
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
+      Mesh *mesh = static_cast<Mesh *>(geom);
+      if (mesh->triangles_is_modified() || mesh->vert_patch_uv_is_modified()) {
+        pack_any_verts = true;
+        break;
+      }
+    }
+  }
+
   /* Create mapping from triangle to primitive triangle array. */
-  vector<uint> tri_prim_index(tri_size);
-  if (for_displacement) {
-    /* For displacement kernels we do some trickery to make them believe
-     * we've got all required data ready. However, that data is different
-     * from final render kernels since we don't have BVH yet, so can't
-     * really use same semantic of arrays.
-     */
-    foreach (Geometry *geom, scene->geometry) {
-      if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        for (size_t i = 0; i < mesh->num_triangles(); ++i) {
-          tri_prim_index[i + mesh->prim_offset] = 3 * (i + mesh->prim_offset);
+  vector<uint> tri_prim_index;
+  if (pack_any_verts) {
+    tri_prim_index.resize(tri_size);
+
+    if (for_displacement) {
+      /* For displacement kernels we do some trickery to make them believe
+       * we've got all required data ready. However, that data is different
+       * from final render kernels since we don't have BVH yet, so can't
+       * really use same semantic of arrays.
+       */
+      foreach (Geometry *geom, scene->geometry) {
+        if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
+          Mesh *mesh = static_cast<Mesh *>(geom);
+          for (size_t i = 0; i < mesh->num_triangles(); ++i) {
+            tri_prim_index[i + mesh->prim_offset] = 3 * (i + mesh->prim_offset);
+          }
         }
       }
     }
-  }
-  else {
-    for (size_t i = 0; i < dscene->prim_index.size(); ++i) {
-      if ((dscene->prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
-        tri_prim_index[dscene->prim_index[i]] = dscene->prim_tri_index[i];
+    else {
+      for (size_t i = 0; i < dscene->prim_index.size(); ++i) {
+        if ((dscene->prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
+          tri_prim_index[dscene->prim_index[i]] = dscene->prim_tri_index[i];
+        }
       }
     }
   }
@@ -1104,32 +1132,36 @@ void GeometryManager::device_update_mesh(
     uint *tri_patch = dscene->tri_patch.alloc(tri_size);
     float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
 
-    const bool copy_all_data = dscene->tri_shader.need_realloc() ||
-                               dscene->tri_vindex.need_realloc() ||
-                               dscene->tri_vnormal.need_realloc() ||
-                               dscene->tri_patch.need_realloc() ||
-                               dscene->tri_patch_uv.need_realloc();
-
+    /* Only the ranges of modified meshes are copied to the device, their offsets stay the same
+     * as long as the arrays do not need to be reallocated. */
     foreach (Geometry *geom, scene->geometry) {
       if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
         Mesh *mesh = static_cast<Mesh *>(geom);
+        const size_t num_triangles = mesh->num_triangles();
+        const size_t num_verts = mesh->verts.size();
 
         if (mesh->shader_is_modified() || mesh->smooth_is_modified() ||
-            mesh->triangles_is_modified() || copy_all_data) {
+            mesh->triangles_is_modified() || copy_all_mesh_data) {
           mesh->pack_shaders(scene, &tri_shader[mesh->prim_offset]);
+          dscene->tri_shader.tag_modified(mesh->prim_offset, num_triangles);
         }
 
-        if (mesh->verts_is_modified() || copy_all_data) {
+        if (mesh->verts_is_modified() || copy_all_mesh_data) {
           mesh->pack_normals(&vnormal[mesh->vert_offset]);
+          dscene->tri_vnormal.tag_modified(mesh->vert_offset, num_verts);
         }
 
-        if (mesh->triangles_is_modified() || mesh->vert_patch_uv_is_modified() || copy_all_data) {
+        if (mesh->triangles_is_modified() || mesh->vert_patch_uv_is_modified() ||
+            copy_all_mesh_data) {
           mesh->pack_verts(tri_prim_index,
                            &tri_vindex[mesh->prim_offset],
                            &tri_patch[mesh->prim_offset],
                            &tri_patch_uv[mesh->vert_offset],
                            mesh->vert_offset,
                            mesh->prim_offset);
+          dscene->tri_vindex.tag_modified(mesh->prim_offset, num_triangles);
+          dscene->tri_patch.tag_modified(mesh->prim_offset, num_triangles);
+          dscene->tri_patch_uv.tag_modified(mesh->vert_offset, num_verts);
         }
 
         if (progress.get_cancel())
@@ -1172,6 +1204,8 @@ void GeometryManager::device_update_mesh(
                           &curve_keys[hair->curvekey_offset],
                           &curves[hair->prim_offset],
                           hair->curvekey_offset);
+        dscene->curve_keys.tag_modified(hair->curvekey_offset, hair->get_curve_keys().size());
+        dscene->curves.tag_modified(hair->prim_offset, hair->num_curves());
         if (progress.get_cancel())
           return;
       }
@@ -1247,8 +1281,25 @@ void GeometryManager::device_update_bvh(Device *device,
 
   VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
 
+  const bool has_bvh2_layout = (bparams.bvh_layout == BVH_LAYOUT_BVH2);
+
+  /* The scene BVH is deleted when geometry or objects are added or removed, or the number of
+   * primitives changes, so an existing BVH can be refit. Objects that became invisible are
+   * removed from BVH2 on build, so it needs to be rebuilt when visibility changes. */
   const bool can_refit = scene->bvh != nullptr &&
-                         (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX);
+                         (bparams.bvh_layout == BVHLayout::BVH_LAYOUT_OPTIX ||
+                          (has_bvh2_layout && (update_flags & VISIBILITY_MODIFIED) == 0));
+
+  scoped_callback_timer timer([this, can_refit](double time) {
+    if (can_refit) {
+      bvh_stats.num_scene_refits++;
+      bvh_stats.scene_refit_time += time;
+    }
+    else {
+      bvh_stats.num_scene_builds++;
+      bvh_stats.scene_build_time += time;
+    }
+  });
 
   PackFlags pack_flags = PackFlags::PACK_NONE;
 
@@ -1271,11 +1322,16 @@ void GeometryManager::device_update_bvh(Device *device,
     return;
   }
 
-  const bool has_bvh2_layout = (bparams.bvh_layout == BVH_LAYOUT_BVH2);
-
   PackedBVH pack;
   if (has_bvh2_layout) {
-    pack = std::move(static_cast<BVH2 *>(bvh)->pack);
+    if (scene->params.background && !scene->params.persistent_data) {
+      /* The scene is freed after rendering, so it will never be refit. */
+      pack = std::move(static_cast<BVH2 *>(bvh)->pack);
+    }
+    else {
+      /* Copy the packed data, the BVH keeps it to be refit in the next update. */
+      pack = static_cast<BVH2 *>(bvh)->pack;
+    }
   }
   else {
     progress.set_status("Updating Scene BVH", "Packing BVH primitives");
@@ -1405,24 +1461,17 @@ void GeometryManager::device_update_bvh(Device *device,
   dscene->data.bvh.scene = 0;
 }
 
-/* Set of flags used to help determining what data has been modified or needs reallocation, so we
- * can decide which device data to free or update. */
+/* Set of flags used to help determining what data needs reallocation, so we can decide which
+ * device data to free. Modified data that does not need reallocation is tagged per geometry when
+ * packing, so only the modified ranges are copied to the device. */
 enum {
-  DEVICE_CURVE_DATA_MODIFIED = (1 << 0),
-  DEVICE_MESH_DATA_MODIFIED = (1 << 1),
-
-  ATTR_FLOAT_MODIFIED = (1 << 2),
-  ATTR_FLOAT2_MODIFIED = (1 << 3),
-  ATTR_FLOAT3_MODIFIED = (1 << 4),
-  ATTR_UCHAR4_MODIFIED = (1 << 5),
-
-  CURVE_DATA_NEED_REALLOC = (1 << 6),
-  MESH_DATA_NEED_REALLOC = (1 << 7),
+  CURVE_DATA_NEED_REALLOC = (1 << 0),
+  MESH_DATA_NEED_REALLOC = (1 << 1),
 
-  ATTR_FLOAT_NEEDS_REALLOC = (1 << 8),
-  ATTR_FLOAT2_NEEDS_REALLOC = (1 << 9),
-  ATTR_FLOAT3_NEEDS_REALLOC = (1 << 10),
-  ATTR_UCHAR4_NEEDS_REALLOC = (1 << 11),
+  ATTR_FLOAT_NEEDS_REALLOC = (1 << 2),
+  ATTR_FLOAT2_NEEDS_REALLOC = (1 << 3),
+  ATTR_FLOAT3_NEEDS_REALLOC = (1 << 4),
+  ATTR_UCHAR4_NEEDS_REALLOC = (1 << 5),
 
   ATTRS_NEED_REALLOC = (ATTR_FLOAT_NEEDS_REALLOC | ATTR_FLOAT2_NEEDS_REALLOC |
                         ATTR_FLOAT3_NEEDS_REALLOC | ATTR_UCHAR4_NEEDS_REALLOC),
@@ -1430,37 +1479,6 @@ enum {
   DEVICE_CURVE_DATA_NEEDS_REALLOC = (CURVE_DATA_NEED_REALLOC | ATTRS_NEED_REALLOC),
 };
 
-static void update_device_flags_attribute(uint32_t &device_update_flags,
-                                          const AttributeSet &attributes)
-{
-  foreach (const Attribute &attr, attributes.attributes) {
-    if (!attr.modified) {
-      continue;
-    }
-
-    AttrKernelDataType kernel_type = Attribute::kernel_type(attr);
-
-    switch (kernel_type) {
-      case AttrKernelDataType::FLOAT: {
-        device_update_flags |= ATTR_FLOAT_MODIFIED;
-        break;
-      }
-      case AttrKernelDataType::FLOAT2: {
-        device_update_flags |= ATTR_FLOAT2_MODIFIED;
-        break;
-      }
-      case AttrKernelDataType::FLOAT3: {
-        device_update_flags |= ATTR_FLOAT3_MODIFIED;
-        break;
-      }
-      case AttrKernelDataType::UCHAR4: {
-        device_update_flags |= ATTR_UCHAR4_MODIFIED;
-        break;
-      }
-    }
-  }
-}
-
 static void update_attribute_realloc_flags(uint32_t &device_update_flags,
                                            const AttributeSet &attributes)
 {
@@ -1555,13 +1573,6 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
       }
     }
 
-    /* only check for modified attributes if we do not need to reallocate them already */
-    if ((device_update_flags & ATTRS_NEED_REALLOC) == 0) {
-      update_device_flags_attribute(device_update_flags, geom->attributes);
-      /* don't check for subd_attributes, as if they were modified, we would need to reallocate
-       * anyway */
-    }
-
     /* Re-create volume mesh if we will rebuild or refit the BVH. Note we
      * should only do it in that case, otherwise the BVH and mesh can go
      * out of sync. */
@@ -1588,9 +1599,6 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
       if (hair->need_update_rebuild) {
         device_update_flags |= DEVICE_CURVE_DATA_NEEDS_REALLOC;
       }
-      else if (hair->is_modified()) {
-        device_update_flags |= DEVICE_CURVE_DATA_MODIFIED;
-      }
     }
 
     if (geom->is_mesh()) {
@@ -1599,9 +1607,6 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
       if (mesh->need_update_rebuild) {
         device_update_flags |= DEVICE_MESH_DATA_NEEDS_REALLOC;
       }
-      else if (mesh->is_modified()) {
-        device_update_flags |= DEVICE_MESH_DATA_MODIFIED;
-      }
     }
   }
 
@@ -1654,45 +1659,21 @@ void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Pro
     dscene->attributes_map.tag_realloc();
     dscene->attributes_float.tag_realloc();
   }
-  else if (device_update_flags & ATTR_FLOAT_MODIFIED) {
-    dscene->attributes_float.tag_modified();
-  }
 
   if (device_update_flags & ATTR_FLOAT2_NEEDS_REALLOC) {
     dscene->attributes_map.tag_realloc();
     dscene->attributes_float2.tag_realloc();
   }
-  else if (device_update_flags & ATTR_FLOAT2_MODIFIED) {
-    dscene->attributes_float2.tag_modified();
-  }
 
   if (device_update_flags & ATTR_FLOAT3_NEEDS_REALLOC) {
     dscene->attributes_map.tag_realloc();
     dscene->attributes_float3.tag_realloc();
   }
-  else if (device_update_flags & ATTR_FLOAT3_MODIFIED) {
-    dscene->attributes_float3.tag_modified();
-  }
 
   if (device_update_flags & ATTR_UCHAR4_NEEDS_REALLOC) {
     dscene->attributes_map.tag_realloc();
     dscene->attributes_uchar4.tag_realloc();
   }
-  else if (device_update_flags & ATTR_UCHAR4_MODIFIED) {
-    dscene->attributes_uchar4.tag_modified();
-  }
-
-  if (device_update_flags & DEVICE_MESH_DATA_MODIFIED) {
-    /* if anything else than vertices or shaders are modified, we would need to reallocate, so
-     * these are the only arrays that can be updated */
-    dscene->tri_vnormal.tag_modified();
-    dscene->tri_shader.tag_modified();
-  }
-
-  if (device_update_flags & DEVICE_CURVE_DATA_MODIFIED) {
-    dscene->curve_keys.tag_modified();
-    dscene->curves.tag_modified();
-  }
 
   need_flags_update = false;
 }
@@ -1979,7 +1960,8 @@ void GeometryManager::device_update(Device *device,
   bool need_update_scene_bvh = (scene->bvh == nullptr ||
                                 (update_flags & (TRANSFORM_MODIFIED | VISIBILITY_MODIFIED)) != 0);
   {
-    scoped_callback_timer timer([scene](double time) {
+    scoped_callback_timer timer([this, scene](double time) {
+      bvh_stats.object_time += time;
       if (scene->update_stats) {
         scene->update_stats->geometry.times.add_entry({"device_update (build object BVHs)", time});
       }
@@ -1990,6 +1972,14 @@ void GeometryManager::device_update(Device *device,
     foreach (Geometry *geom, scene->geometry) {
       if (geom->is_modified() || geom->need_update_bvh_for_offset) {
         need_update_scene_bvh = true;
+        if (geom->need_build_bvh(bvh_layout)) {
+          if (geom->bvh && !geom->need_update_rebuild) {
+            bvh_stats.num_object_refits++;
+          }
+          else {
+            bvh_stats.num_object_builds++;
+          }
+        }
         pool.push(function_bind(
             &Geometry::compute_bvh, geom, device, dscene, &scene->params, &progress, i, num_bvh));
         if (geom->need_build_bvh(bvh_layout)) {
@@ -2170,6 +2160,8 @@ void GeometryManager::collect_statistics(const Scene *scene, RenderStats *stats)
     stats->mesh.geometry.add_entry(
         NamedSizeEntry(string(geometry->name.c_str()), geometry->get_total_size_in_bytes()));
   }
+
+  stats->bvh = bvh_stats;
 }
 
 CCL_NAMESPACE_END
@@ -22,6 +22,7 @@
 #include "bvh/bvh_params.h"
 
 #include "render/attribute.h"
+#include "render/stats.h"
 
 #include "util/util_boundbox.h"
 #include "util/util_set.h"
@@ -223,6 +224,9 @@ class GeometryManager {
   /* Update Flags */
   bool need_flags_update;
 
+  /* BVH build and refit statistics, accumulated over all updates. */
+  BVHStats bvh_stats;
+
   /* Constructor/Destructor */
   GeometryManager();
   ~GeometryManager();
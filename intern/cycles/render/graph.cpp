@@ -383,6 +383,9 @@ void ShaderGraph::finalize(Scene *scene, bool do_bump, bool do_simplify, bool bu
     if (do_bump)
       bump_from_displacement(bump_in_object_space);
 
+    if (scene->image_manager->use_texture_cache())
+      refine_image_derivative_nodes();
+
     ShaderInput *surface_in = output()->input("Surface");
     ShaderInput *volume_in = output()->input("Volume");
 
@@ -954,6 +957,62 @@ void ShaderGraph::refine_bump_nodes()
   }
 }
 
+void ShaderGraph::refine_image_derivative_nodes()
+{
+  /* images looked up through the texture cache choose the mipmap level from the
+   * derivatives of the texture coordinate. like for bump mapping, we make 2 copies
+   * of the sub-graph defining the "Vector" input, with texture coordinates shifted
+   * by the ray differentials, and connect them to the "VectorDx" and "VectorDy"
+   * inputs. image nodes sharing the same texture coordinate share the copies. */
+
+  vector<ShaderNode *> image_nodes;
+
+  foreach (ShaderNode *node, nodes) {
+    if (node->type == ImageTextureNode::get_node_type() && node->bump == SHADER_BUMP_NONE &&
+        node->input("Vector")->link &&
+        ((ImageTextureNode *)node)->get_projection() != NODE_IMAGE_PROJ_BOX) {
+      image_nodes.push_back(node);
+    }
+  }
+
+  map<ShaderOutput *, ShaderOutput *> outputs_dx;
+  map<ShaderOutput *, ShaderOutput *> outputs_dy;
+
+  foreach (ShaderNode *node, image_nodes) {
+    ShaderInput *vector_in = node->input("Vector");
+    ShaderOutput *out = vector_in->link;
+
+    if (outputs_dx.find(out) == outputs_dx.end()) {
+      ShaderNodeSet nodes_vector;
+      ShaderNodeMap nodes_dx;
+      ShaderNodeMap nodes_dy;
+
+      /* find dependencies for the given input */
+      find_dependencies(nodes_vector, vector_in);
+
+      copy_nodes(nodes_vector, nodes_dx);
+      copy_nodes(nodes_vector, nodes_dy);
+
+      foreach (NodePair &pair, nodes_dx)
+        pair.second->bump = SHADER_BUMP_DX;
+      foreach (NodePair &pair, nodes_dy)
+        pair.second->bump = SHADER_BUMP_DY;
+
+      outputs_dx[out] = nodes_dx[out->parent]->output(out->name());
+      outputs_dy[out] = nodes_dy[out->parent]->output(out->name());
+
+      /* add generated nodes */
+      foreach (NodePair &pair, nodes_dx)
+        add(pair.second);
+      foreach (NodePair &pair, nodes_dy)
+        add(pair.second);
+    }
+
+    connect(outputs_dx[out], node->input("VectorDx"));
+    connect(outputs_dy[out], node->input("VectorDy"));
+  }
+}
+
 void ShaderGraph::bump_from_displacement(bool use_object_space)
 {
   /* generate bump mapping automatically from displacement. bump mapping is
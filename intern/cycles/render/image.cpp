@@ -36,6 +36,8 @@
 #  include <OSL/oslexec.h>
 #endif
 
+#include <OpenImageIO/texture.h>
+
 CCL_NAMESPACE_BEGIN
 
 namespace {
@@ -77,6 +79,8 @@ const char *name_from_type(ImageDataType type)
       return "nanovdb_float";
     case IMAGE_DATA_TYPE_NANOVDB_FLOAT3:
       return "nanovdb_float3";
+    case IMAGE_DATA_TYPE_TEXTURE_CACHE:
+      return "texture_cache";
     case IMAGE_DATA_NUM_TYPES:
       assert(!"System enumerator type, should never be used");
       return "";
@@ -300,6 +304,7 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update_ = true;
   osl_texture_system = NULL;
+  texture_cache = NULL;
   animation_frame = 0;
 
   /* Set image limits */
@@ -311,6 +316,10 @@ ImageManager::~ImageManager()
 {
   for (size_t slot = 0; slot < images.size(); slot++)
     assert(!images[slot]);
+
+  if (texture_cache) {
+    TextureSystem::destroy((TextureSystem *)texture_cache);
+  }
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -318,6 +327,28 @@ void ImageManager::set_osl_texture_system(void *texture_system)
   osl_texture_system = texture_system;
 }
 
+void ImageManager::texture_cache_init(int max_memory_MB)
+{
+  assert(texture_cache == NULL);
+
+  /* Not shared with other sessions like the OSL texture system, so that the memory
+   * budget applies to this render only. */
+  TextureSystem *ts = TextureSystem::create(false);
+
+  /* Tile and mipmap images that are not pre-converted to .tx files on load. */
+  ts->attribute("automip", 1);
+  ts->attribute("autotile", 64);
+  ts->attribute("gray_to_rgb", 1);
+  ts->attribute("max_memory_MB", (float)max_memory_MB);
+
+  texture_cache = ts;
+}
+
+bool ImageManager::use_texture_cache() const
+{
+  return texture_cache != NULL;
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
   if (frame != animation_frame) {
@@ -486,6 +517,21 @@ static bool image_associate_alpha(ImageManager::Image *img)
            img->params.alpha_type == IMAGE_ALPHA_CHANNEL_PACKED);
 }
 
+bool ImageManager::image_use_texture_cache(Image *img)
+{
+  if (!texture_cache || img->loader->osl_filepath().empty()) {
+    return false;
+  }
+
+  /* Only 2D images with no conversion on load that texture lookups can not do. sRGB is
+   * converted to linear by the shader, like for 8 bit images stored as sRGB. */
+  const ImageMetaData &metadata = img->metadata;
+  return metadata.channels > 0 && metadata.depth == 1 && !metadata.use_transform_3d &&
+         (metadata.colorspace == u_colorspace_raw ||
+          metadata.colorspace == u_colorspace_srgb) &&
+         (image_associate_alpha(img) || metadata.channels == 1 || metadata.channels == 3);
+}
+
 template<TypeDesc::BASETYPE FileFormat, typename StorageType>
 bool ImageManager::file_load_image(Image *img, int texture_limit)
 {
@@ -657,6 +703,10 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   load_image_metadata(img);
   ImageDataType type = img->metadata.type;
 
+  if (image_use_texture_cache(img)) {
+    type = IMAGE_DATA_TYPE_TEXTURE_CACHE;
+  }
+
   /* Name for debugging. */
   img->mem_name = string_printf("__tex_image_%s_%03d", name_from_type(type), slot);
 
@@ -673,7 +723,18 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
   /* Create new texture. */
-  if (type == IMAGE_DATA_TYPE_FLOAT4) {
+  if (type == IMAGE_DATA_TYPE_TEXTURE_CACHE) {
+    /* Pixels are loaded by the texture cache on first access, only store the handle. */
+    TextureSystem *ts = (TextureSystem *)texture_cache;
+    TextureSystem::TextureHandle *handle = ts->get_texture_handle(img->loader->osl_filepath());
+
+    thread_scoped_lock device_lock(device_mutex);
+    TextureCacheHandle *cache = (TextureCacheHandle *)img->mem->alloc(1, 1);
+
+    cache->texture_system = (uint64_t)ts;
+    cache->handle = (uint64_t)handle;
+  }
+  else if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
@@ -794,6 +855,10 @@ void ImageManager::device_free_image(Device *, int slot)
 #endif
   }
 
+  if (img->mem && img->mem->info.data_type == IMAGE_DATA_TYPE_TEXTURE_CACHE) {
+    ((TextureSystem *)texture_cache)->invalidate(img->loader->osl_filepath());
+  }
+
   if (img->mem) {
     thread_scoped_lock device_lock(device_mutex);
     delete img->mem;
@@ -884,12 +949,39 @@ void ImageManager::device_free(Device *device)
   images.clear();
 }
 
+static uint64_t texture_cache_stat(TextureSystem *ts, const char *name)
+{
+  /* Statistics are a mix of 32 and 64 bit integers depending on the OpenImageIO version. */
+  long long value = 0;
+  if (ts->getattribute(name, TypeDesc::INT64, &value)) {
+    return value;
+  }
+
+  int int_value = 0;
+  if (ts->getattribute(name, TypeDesc::INT, &int_value)) {
+    return int_value;
+  }
+
+  return 0;
+}
+
 void ImageManager::collect_statistics(RenderStats *stats)
 {
   foreach (const Image *image, images) {
     stats->image.textures.add_entry(
         NamedSizeEntry(image->loader->name(), image->mem->memory_size()));
   }
+
+  if (texture_cache) {
+    TextureSystem *ts = (TextureSystem *)texture_cache;
+    TextureCacheStats &cache = stats->image.texture_cache;
+
+    cache.enabled = true;
+    cache.lookups = texture_cache_stat(ts, "stat:find_tile_calls");
+    cache.misses = texture_cache_stat(ts, "stat:find_tile_cache_misses");
+    cache.bytes_read = texture_cache_stat(ts, "stat:bytes_read");
+    cache.memory_used = texture_cache_stat(ts, "stat:cache_memory_used");
+  }
 }
 
 void ImageManager::tag_update()
@@ -194,6 +194,11 @@ class ImageManager {
   void set_osl_texture_system(void *texture_system);
   bool set_animation_frame_update(int frame);
 
+  /* Load image files on demand by tile and mip level through a texture cache with
+   * the given memory budget, instead of loading them fully into device memory. */
+  void texture_cache_init(int max_memory_MB);
+  bool use_texture_cache() const;
+
   void collect_statistics(RenderStats *stats);
 
   void tag_update();
@@ -228,12 +233,14 @@ class ImageManager {
 
   vector<Image *> images;
   void *osl_texture_system;
+  void *texture_cache;
 
   int add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(int slot);
   void remove_image_user(int slot);
 
   void load_image_metadata(Image *img);
+  bool image_use_texture_cache(Image *img);
 
   template<TypeDesc::BASETYPE FileFormat, typename StorageType>
   bool file_load_image(Image *img, int texture_limit);
@@ -20,6 +20,7 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/integrator.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
@@ -338,6 +339,11 @@ void LightManager::device_update_distribution(Device *,
   KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
   float totarea = 0.0f;
 
+  /* Emitters of the light tree, each tree is sampled with a fixed probability. */
+  vector<LightTreeEmitter> tree_triangles;
+  vector<LightTreeEmitter> tree_lamps;
+  vector<LightTreeEmitter> tree_distant;
+
   /* triangles */
   size_t offset = 0;
   int j = 0;
@@ -374,6 +380,11 @@ void LightManager::device_update_distribution(Device *,
       use_light_visibility = true;
     }
 
+    LightTreeEmitter object_emitter;
+    object_emitter.flag = LIGHT_TREE_MESH;
+    object_emitter.emitter = object_id;
+    object_emitter.distribution_begin = offset;
+
     size_t mesh_num_triangles = mesh->num_triangles();
     for (size_t i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->get_shader()[i];
@@ -402,10 +413,30 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        const float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        /* Emission is only known for constant emission shaders, others are weighted as if they
+         * had a strength of one. */
+        const KernelShader &kshader = dscene->shaders[shader->id];
+        const float emission = (kshader.flags & SD_HAS_CONSTANT_EMISSION) ?
+                                   fabsf(average(make_float3(kshader.constant_emission[0],
+                                                             kshader.constant_emission[1],
+                                                             kshader.constant_emission[2]))) :
+                                   1.0f;
+        object_emitter.energy += emission * area;
+        object_emitter.area += area;
+        object_emitter.bounds.grow(p1);
+        object_emitter.bounds.grow(p2);
+        object_emitter.bounds.grow(p3);
       }
     }
 
+    object_emitter.distribution_end = offset;
+    if (object_emitter.bounds.valid()) {
+      tree_triangles.push_back(object_emitter);
+    }
+
     j++;
   }
 
@@ -440,6 +471,42 @@ void LightManager::device_update_distribution(Device *,
       background_mis |= light->use_mis;
     }
 
+    LightTreeEmitter lamp_emitter;
+    lamp_emitter.flag = LIGHT_TREE_LAMP;
+    lamp_emitter.emitter = light_index;
+
+    if (light->light_type == LIGHT_DISTANT || light->light_type == LIGHT_BACKGROUND) {
+      /* Picked uniformly, there is no position to bound. */
+      lamp_emitter.flag |= LIGHT_TREE_DISTANT;
+      lamp_emitter.bounds = BoundBox(zero_float3());
+      lamp_emitter.energy = 1.0f;
+      tree_distant.push_back(lamp_emitter);
+    }
+    else {
+      lamp_emitter.energy = fabsf(average(light->strength));
+
+      if (light->light_type == LIGHT_AREA) {
+        const float3 axisu = light->axisu * (light->sizeu * light->size * 0.5f);
+        const float3 axisv = light->axisv * (light->sizev * light->size * 0.5f);
+        lamp_emitter.bounds.grow(light->co - axisu - axisv);
+        lamp_emitter.bounds.grow(light->co - axisu + axisv);
+        lamp_emitter.bounds.grow(light->co + axisu - axisv);
+        lamp_emitter.bounds.grow(light->co + axisu + axisv);
+        lamp_emitter.axis = safe_normalize(light->dir);
+        lamp_emitter.theta_o = 0.0f;
+      }
+      else {
+        lamp_emitter.bounds.grow(light->co, light->size);
+        if (light->light_type == LIGHT_SPOT) {
+          lamp_emitter.axis = safe_normalize(light->dir);
+          lamp_emitter.theta_o = 0.0f;
+          lamp_emitter.theta_e = min(light->spot_angle * 0.5f, M_PI_2_F);
+        }
+      }
+
+      tree_lamps.push_back(lamp_emitter);
+    }
+
     light_index++;
     offset++;
   }
@@ -490,6 +557,9 @@ void LightManager::device_update_distribution(Device *,
 
     kintegrator->use_lamp_mis = use_lamp_mis;
 
+    /* Light tree */
+    device_update_tree(dscene, scene, tree_triangles, tree_lamps, tree_distant);
+
     /* bit of an ugly hack to compensate for emitting triangles influencing
      * amount of samples we get for this pass */
     kfilm->pass_shadow_scale = 1.0f;
@@ -526,6 +596,10 @@ void LightManager::device_update_distribution(Device *,
     kintegrator->pdf_triangles = 0.0f;
     kintegrator->pdf_lights = 0.0f;
     kintegrator->use_lamp_mis = false;
+    kintegrator->use_light_tree = false;
+
+    dscene->light_tree_nodes.free();
+    dscene->light_tree_leaf_map.free();
 
     kbackground->num_portals = 0;
     kbackground->portal_offset = 0;
@@ -537,6 +611,76 @@ void LightManager::device_update_distribution(Device *,
   }
 }
 
+void LightManager::device_update_tree(DeviceScene *dscene,
+                                      Scene *scene,
+                                      vector<LightTreeEmitter> &triangles,
+                                      vector<LightTreeEmitter> &lamps,
+                                      vector<LightTreeEmitter> &distant)
+{
+  KernelIntegrator *kintegrator = &dscene->data.integrator;
+
+  /* Lamps sampled one by one by the branched path integrator use the same probability for
+   * every lamp, which the tree does not give. */
+  const Integrator *integrator = scene->integrator;
+  const bool sample_all_lights = integrator->get_method() == Integrator::BRANCHED_PATH &&
+                                 (integrator->get_sample_all_lights_direct() ||
+                                  integrator->get_sample_all_lights_indirect());
+
+  kintegrator->use_light_tree = integrator->get_use_light_tree() && !sample_all_lights;
+
+  if (!kintegrator->use_light_tree) {
+    dscene->light_tree_nodes.free();
+    dscene->light_tree_leaf_map.free();
+    return;
+  }
+
+  /* Same split between triangles and lamps as the light distribution, with the probability of
+   * each distant lamp unchanged. */
+  const size_t num_lights = lamps.size() + distant.size();
+  const float pdf_triangles = (triangles.empty()) ? 0.0f : (num_lights) ? 0.5f : 1.0f;
+  const float pdf_lights = 1.0f - pdf_triangles;
+
+  vector<KernelLightTreeNode> nodes;
+  kintegrator->light_tree_root_triangles = LightTree(triangles).build(nodes);
+  kintegrator->light_tree_root_lamps = LightTree(lamps).build(nodes);
+  kintegrator->light_tree_root_distant = LightTree(distant).build(nodes);
+  kintegrator->light_tree_pdf_triangles = pdf_triangles;
+  kintegrator->light_tree_pdf_lamps = (num_lights) ? pdf_lights * lamps.size() / num_lights :
+                                                     0.0f;
+  kintegrator->light_tree_pdf_distant = (num_lights) ?
+                                            pdf_lights * distant.size() / num_lights :
+                                            0.0f;
+
+  /* Leaves of the objects followed by the leaves of the lamps, to compute the probability of
+   * emitters hit by rays. */
+  const size_t num_objects = scene->objects.size();
+  kintegrator->light_tree_lamp_offset = num_objects;
+
+  int *leaf_map = dscene->light_tree_leaf_map.alloc(num_objects + num_lights);
+  for (size_t i = 0; i < num_objects + num_lights; i++) {
+    leaf_map[i] = -1;
+  }
+
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const KernelLightTreeNode &knode = nodes[i];
+    if (knode.flag & LIGHT_TREE_MESH) {
+      leaf_map[knode.emitter] = i;
+    }
+    else if (knode.flag & LIGHT_TREE_LAMP) {
+      leaf_map[num_objects + knode.emitter] = i;
+    }
+  }
+
+  KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(nodes.size());
+  std::copy(nodes.begin(), nodes.end(), knodes);
+
+  VLOG(1) << "Light tree with " << nodes.size() << " nodes for " << triangles.size()
+          << " mesh lights and " << num_lights << " lamps.";
+
+  dscene->light_tree_nodes.copy_to_device();
+  dscene->light_tree_leaf_map.copy_to_device();
+}
+
 static void background_cdf(
     int start, int end, int res_x, int res_y, const vector<float3> *pixels, float2 *cond_cdf)
 {
@@ -1026,6 +1170,8 @@ void LightManager::device_update(Device *device,
 void LightManager::device_free(Device *, DeviceScene *dscene, const bool free_background)
 {
   dscene->light_distribution.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_leaf_map.free();
   dscene->lights.free();
   if (free_background) {
     dscene->light_background_marginal_cdf.free();
@@ -38,6 +38,7 @@ class Object;
 class Progress;
 class Scene;
 class Shader;
+struct LightTreeEmitter;
 
 class Light : public Node {
  public:
@@ -101,6 +102,7 @@ class LightManager {
     OBJECT_MANAGER = (1 << 5),
     SHADER_COMPILED = (1 << 6),
     SHADER_MODIFIED = (1 << 7),
+    INTEGRATOR_MODIFIED = (1 << 8),
 
     /* tag everything in the manager for an update */
     UPDATE_ALL = ~0u,
@@ -143,6 +145,11 @@ class LightManager {
                                   DeviceScene *dscene,
                                   Scene *scene,
                                   Progress &progress);
+  void device_update_tree(DeviceScene *dscene,
+                          Scene *scene,
+                          vector<LightTreeEmitter> &triangles,
+                          vector<LightTreeEmitter> &lamps,
+                          vector<LightTreeEmitter> &distant);
   void device_update_background(Device *device,
                                 DeviceScene *dscene,
                                 Scene *scene,
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Grow the cone of normals given by axis and theta_o to also contain another cone. */
+static void light_tree_cone_union(float3 &axis,
+                                  float &theta_o,
+                                  const float3 other_axis,
+                                  const float other_theta_o)
+{
+  float3 axis_a = axis, axis_b = other_axis;
+  float theta_a = theta_o, theta_b = other_theta_o;
+  if (theta_b > theta_a) {
+    swap(axis_a, axis_b);
+    swap(theta_a, theta_b);
+  }
+
+  const float theta_d = safe_acosf(dot(axis_a, axis_b));
+  if (min(theta_d + theta_b, M_PI_F) <= theta_a) {
+    /* The wider cone already contains the other one. */
+    axis = axis_a;
+    theta_o = theta_a;
+    return;
+  }
+
+  const float theta_union = 0.5f * (theta_a + theta_d + theta_b);
+  if (theta_union >= M_PI_F) {
+    axis = axis_a;
+    theta_o = M_PI_F;
+    return;
+  }
+
+  /* Rotate the axis of the wider cone towards the other one. */
+  const float theta_r = theta_union - theta_a;
+  float3 ortho = axis_b - axis_a * dot(axis_a, axis_b);
+  if (len_squared(ortho) < 1e-12f) {
+    float3 unused;
+    make_orthonormals(axis_a, &ortho, &unused);
+  }
+  else {
+    ortho = normalize(ortho);
+  }
+
+  axis = normalize(axis_a * cosf(theta_r) + ortho * sinf(theta_r));
+  theta_o = theta_union;
+}
+
+LightTree::LightTree(vector<LightTreeEmitter> &emitters) : emitters_(emitters)
+{
+}
+
+int LightTree::build(vector<KernelLightTreeNode> &nodes)
+{
+  if (emitters_.empty()) {
+    return -1;
+  }
+
+  const int root = nodes.size();
+  nodes.resize(root + 1);
+  build_node(nodes, root, -1, 0, emitters_.size());
+  return root;
+}
+
+void LightTree::build_node(
+    vector<KernelLightTreeNode> &nodes, int index, int parent, int begin, int end)
+{
+  const LightTreeEmitter &first = emitters_[begin];
+
+  BoundBox bounds = BoundBox::empty;
+  BoundBox centroid_bounds = BoundBox::empty;
+  float3 axis = first.axis;
+  float theta_o = first.theta_o;
+  float theta_e = first.theta_e;
+  float energy = 0.0f;
+
+  for (int i = begin; i < end; i++) {
+    const LightTreeEmitter &emitter = emitters_[i];
+    bounds.grow(emitter.bounds);
+    centroid_bounds.grow(emitter.bounds.center());
+    energy += emitter.energy;
+    if (i != begin) {
+      light_tree_cone_union(axis, theta_o, emitter.axis, emitter.theta_o);
+      theta_e = max(theta_e, emitter.theta_e);
+    }
+  }
+
+  KernelLightTreeNode knode = {};
+
+  knode.bbox_min[0] = bounds.min.x;
+  knode.bbox_min[1] = bounds.min.y;
+  knode.bbox_min[2] = bounds.min.z;
+  knode.bbox_max[0] = bounds.max.x;
+  knode.bbox_max[1] = bounds.max.y;
+  knode.bbox_max[2] = bounds.max.z;
+  knode.energy = energy;
+  knode.axis[0] = axis.x;
+  knode.axis[1] = axis.y;
+  knode.axis[2] = axis.z;
+  knode.theta_o = theta_o;
+  knode.theta_e = theta_e;
+  knode.parent = parent;
+  knode.child = -1;
+  knode.emitter = -1;
+  /* All emitters of a tree are either distant or local. */
+  knode.flag = first.flag & LIGHT_TREE_DISTANT;
+
+  if (end - begin == 1) {
+    knode.flag = first.flag;
+    knode.emitter = first.emitter;
+    knode.distribution_begin = first.distribution_begin;
+    knode.distribution_end = first.distribution_end;
+    knode.area = first.area;
+    nodes[index] = knode;
+    return;
+  }
+
+  /* Split at the median of the centroids along the largest axis. */
+  const float3 size = centroid_bounds.size();
+  const int split_axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z) ? 1 : 2;
+  const int middle = (begin + end) / 2;
+
+  std::nth_element(emitters_.begin() + begin,
+                   emitters_.begin() + middle,
+                   emitters_.begin() + end,
+                   [split_axis](const LightTreeEmitter &a, const LightTreeEmitter &b) {
+                     return a.bounds.center()[split_axis] < b.bounds.center()[split_axis];
+                   });
+
+  const int child = nodes.size();
+  knode.child = child;
+  nodes[index] = knode;
+  nodes.resize(child + 2);
+
+  build_node(nodes, child, index, begin, middle);
+  build_node(nodes, child + 1, index, middle, end);
+}
+
+CCL_NAMESPACE_END
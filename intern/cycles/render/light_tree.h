@@ -0,0 +1,76 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Emitter stored in a leaf of the light tree: a lamp, or the emissive triangles of an object. */
+struct LightTreeEmitter {
+  BoundBox bounds;
+  float3 axis;
+  float theta_o;
+  float theta_e;
+  float energy;
+  float area;
+
+  int flag;
+  int emitter;
+  int distribution_begin;
+  int distribution_end;
+
+  LightTreeEmitter()
+      : bounds(BoundBox::empty),
+        axis(make_float3(0.0f, 0.0f, 1.0f)),
+        theta_o(M_PI_F),
+        theta_e(M_PI_2_F),
+        energy(0.0f),
+        area(0.0f),
+        flag(0),
+        emitter(-1),
+        distribution_begin(0),
+        distribution_end(0)
+  {
+  }
+};
+
+/* Bounding volume hierarchy over emitters, used to pick lights by their estimated contribution
+ * to a shading point. Nodes are split at the median of the centroids along their largest axis,
+ * which keeps the tree balanced for the traversal in the kernel. */
+class LightTree {
+ public:
+  explicit LightTree(vector<LightTreeEmitter> &emitters);
+
+  /* Append the nodes of the tree, returning the index of its root or -1 without emitters.
+   * Children of a node are always stored next to each other. */
+  int build(vector<KernelLightTreeNode> &nodes);
+
+ protected:
+  void build_node(vector<KernelLightTreeNode> &nodes, int index, int parent, int begin, int end);
+
+  vector<LightTreeEmitter> &emitters_;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
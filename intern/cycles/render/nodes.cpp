@@ -251,6 +251,9 @@ NODE_DEFINE(ImageTextureNode)
   SOCKET_BOOLEAN(animated, "Animated", false);
 
   SOCKET_IN_POINT(vector, "Vector", zero_float3(), SocketType::LINK_TEXTURE_UV);
+  /* Shifted by ray differentials, for mipmap lookups in the texture cache. */
+  SOCKET_IN_POINT(vector_dx, "VectorDx", zero_float3(), SocketType::SVM_INTERNAL);
+  SOCKET_IN_POINT(vector_dy, "VectorDy", zero_float3(), SocketType::SVM_INTERNAL);
 
   SOCKET_OUT_COLOR(color, "Color");
   SOCKET_OUT_FLOAT(alpha, "Alpha");
@@ -403,6 +406,18 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
       num_nodes = divide_up(handle.num_tiles(), 2);
     }
 
+    /* Texture coordinates shifted by ray differentials, see refine_image_derivative_nodes(). */
+    ShaderInput *vector_dx_in = input("VectorDx");
+    ShaderInput *vector_dy_in = input("VectorDy");
+    int vector_dx_offset = SVM_STACK_INVALID;
+    int vector_dy_offset = SVM_STACK_INVALID;
+
+    if (vector_dx_in->link && vector_dy_in->link) {
+      flags |= NODE_IMAGE_DERIVATIVES;
+      vector_dx_offset = tex_mapping.compile_begin(compiler, vector_dx_in);
+      vector_dy_offset = tex_mapping.compile_begin(compiler, vector_dy_in);
+    }
+
     compiler.add_node(NODE_TEX_IMAGE,
                       num_nodes,
                       compiler.encode_uchar4(vector_offset,
@@ -411,6 +426,12 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
                                              flags),
                       projection);
 
+    if (flags & NODE_IMAGE_DERIVATIVES) {
+      compiler.add_node(vector_dx_offset, vector_dy_offset, 0, 0);
+      tex_mapping.compile_end(compiler, vector_dy_in, vector_dy_offset);
+      tex_mapping.compile_end(compiler, vector_dx_in, vector_dx_offset);
+    }
+
     if (num_nodes > 0) {
       for (int i = 0; i < num_nodes; i++) {
         int4 node;
@@ -79,6 +79,8 @@ DeviceScene::DeviceScene(Device *device)
       lights(device, "__lights", MEM_GLOBAL),
       light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_GLOBAL),
       light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_GLOBAL),
+      light_tree_nodes(device, "__light_tree_nodes", MEM_GLOBAL),
+      light_tree_leaf_map(device, "__light_tree_leaf_map", MEM_GLOBAL),
       particles(device, "__particles", MEM_GLOBAL),
       svm_nodes(device, "__svm_nodes", MEM_GLOBAL),
       shaders(device, "__shaders", MEM_GLOBAL),
@@ -117,6 +119,11 @@ Scene::Scene(const SceneParams &params_, Device *device)
   geometry_manager = new GeometryManager();
   object_manager = new ObjectManager();
   image_manager = new ImageManager(device->info);
+
+  /* The texture cache is looked up by the CPU kernel, OSL has its own texture system. */
+  if (params.use_texture_cache && device->info.type == DEVICE_CPU && !shader_manager->use_osl()) {
+    image_manager->texture_cache_init(params.texture_cache_size);
+  }
   particle_system_manager = new ParticleSystemManager();
   bake_manager = new BakeManager();
   procedural_manager = new ProceduralManager();
@@ -116,6 +116,8 @@ class DeviceScene {
   device_vector<KernelLight> lights;
   device_vector<float2> light_background_marginal_cdf;
   device_vector<float2> light_background_conditional_cdf;
+  device_vector<KernelLightTreeNode> light_tree_nodes;
+  device_vector<int> light_tree_leaf_map;
 
   /* particles */
   device_vector<KernelParticle> particles;
@@ -180,7 +182,14 @@ class SceneParams {
   CurveShapeType hair_shape;
   int texture_limit;
 
+  /* Load image files on demand through a tiled and mipmapped texture cache, with
+   * a memory budget in megabytes. Only supported for SVM on the CPU. */
+  bool use_texture_cache;
+  int texture_cache_size;
+
   bool background;
+  /* Scene is kept after rendering to render again, for example the next frame. */
+  bool persistent_data;
 
   SceneParams()
   {
@@ -193,7 +202,10 @@ class SceneParams {
     hair_subdivisions = 3;
     hair_shape = CURVE_RIBBON;
     texture_limit = 0;
+    use_texture_cache = false;
+    texture_cache_size = 4096;
     background = true;
+    persistent_data = false;
   }
 
   bool modified(const SceneParams &params)
@@ -204,7 +216,9 @@ class SceneParams {
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
              hair_subdivisions == params.hair_subdivisions && hair_shape == params.hair_shape &&
-             texture_limit == params.texture_limit);
+             texture_limit == params.texture_limit &&
+             use_texture_cache == params.use_texture_cache &&
+             texture_cache_size == params.texture_cache_size);
   }
 
   int curve_subdivisions()
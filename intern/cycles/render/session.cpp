@@ -386,7 +386,7 @@ bool Session::steal_tile(RenderTile &rtile, Device *tile_device, thread_scoped_l
 {
   /* Devices that can get their tiles stolen don't steal tiles themselves.
    * Additionally, if there are no stealable tiles in flight, give up here. */
-  if (tile_device->info.type == DEVICE_CPU || stealable_tiles == 0) {
+  if (!tile_device->can_steal_tile() || stealable_tiles == 0) {
     return false;
   }
 
@@ -486,7 +486,7 @@ bool Session::acquire_tile(RenderTile &rtile, Device *tile_device, uint tile_typ
     rtile.task = RenderTile::DENOISE;
   }
   else {
-    if (tile_device->info.type == DEVICE_CPU) {
+    if (tile_device->tiles_can_be_stolen()) {
       stealable_tiles++;
       rtile.stealing_state = RenderTile::CAN_BE_STOLEN;
     }
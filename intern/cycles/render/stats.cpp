@@ -238,6 +238,32 @@ string MeshStats::full_report(int indent_level)
   return result;
 }
 
+/* Texture cache statistics. */
+
+TextureCacheStats::TextureCacheStats()
+    : enabled(false), lookups(0), misses(0), bytes_read(0), memory_used(0)
+{
+}
+
+string TextureCacheStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const double hit_rate = (lookups > 0) ? 100.0 * (lookups - misses) / lookups : 0.0;
+  string result = "";
+  result += string_printf("%sTile lookups: %s, misses: %s (%.2f%% hits)\n",
+                          indent.c_str(),
+                          string_human_readable_number(lookups).c_str(),
+                          string_human_readable_number(misses).c_str(),
+                          hit_rate);
+  result += string_printf("%sRead from disk: %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(bytes_read).c_str());
+  result += string_printf("%sMemory used: %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(memory_used).c_str());
+  return result;
+}
+
 /* Image statistics. */
 
 ImageStats::ImageStats()
@@ -249,6 +275,42 @@ string ImageStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Textures:\n" + textures.full_report(indent_level + 1);
+  if (texture_cache.enabled) {
+    result += indent + "Texture Cache:\n" + texture_cache.full_report(indent_level + 1);
+  }
+  return result;
+}
+
+/* BVH statistics. */
+
+BVHStats::BVHStats()
+    : num_object_builds(0),
+      num_object_refits(0),
+      object_time(0.0),
+      num_scene_builds(0),
+      num_scene_refits(0),
+      scene_build_time(0.0),
+      scene_refit_time(0.0)
+{
+}
+
+string BVHStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  string result = "";
+  result += string_printf("%sObject BVHs: %d builds, %d refits, %fs\n",
+                          indent.c_str(),
+                          num_object_builds,
+                          num_object_refits,
+                          object_time);
+  result += string_printf("%sScene BVH builds: %d, %fs\n",
+                          indent.c_str(),
+                          num_scene_builds,
+                          scene_build_time);
+  result += string_printf("%sScene BVH refits: %d, %fs\n",
+                          indent.c_str(),
+                          num_scene_refits,
+                          scene_refit_time);
   return result;
 }
 
@@ -334,6 +396,7 @@ string RenderStats::full_report()
   string result = "";
   result += "Mesh statistics:\n" + mesh.full_report(1);
   result += "Image statistics:\n" + image.full_report(1);
+  result += "BVH statistics:\n" + bvh.full_report(1);
   if (has_profiling) {
     result += "Kernel statistics:\n" + kernel.full_report(1);
     result += "Shader statistics:\n" + shaders.full_report(1);
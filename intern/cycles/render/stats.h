@@ -163,6 +163,23 @@ class MeshStats {
 };
 
 /* Statistics about images held in memory. */
+class TextureCacheStats {
+ public:
+  TextureCacheStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  bool enabled;
+
+  /* Number of tile lookups, and how many of those had to read the tile from disk. */
+  uint64_t lookups;
+  uint64_t misses;
+
+  uint64_t bytes_read;
+  size_t memory_used;
+};
+
 class ImageStats {
  public:
   ImageStats();
@@ -171,6 +188,28 @@ class ImageStats {
   string full_report(int indent_level = 0);
 
   NamedSizeStats textures;
+  TextureCacheStats texture_cache;
+};
+
+/* Statistics about BVH builds and refits, accumulated over all updates of the scene. */
+class BVHStats {
+ public:
+  BVHStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  /* Number of object BVHs of instanced geometry built from scratch or refit, and time spent
+   * updating them. */
+  int num_object_builds;
+  int num_object_refits;
+  double object_time;
+
+  /* Number of times the scene BVH was built from scratch or refit, and time spent on each. */
+  int num_scene_builds;
+  int num_scene_refits;
+  double scene_build_time;
+  double scene_refit_time;
 };
 
 /* Render process statistics. */
@@ -188,6 +227,7 @@ class RenderStats {
 
   MeshStats mesh;
   ImageStats image;
+  BVHStats bvh;
   NamedNestedSampleStats kernel;
   NamedSampleCountStats shaders;
   NamedSampleCountStats objects;
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2011-2021 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+#include "device/device_intern.h"
+
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/film.h"
+#include "render/graph.h"
+#include "render/mesh.h"
+#include "render/nodes.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/session.h"
+#include "render/shader.h"
+
+#include "util/util_profiling.h"
+#include "util/util_stats.h"
+#include "util/util_string.h"
+#include "util/util_task.h"
+#include "util/util_thread.h"
+#include "util/util_time.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int WIDTH = 64;
+const int HEIGHT = 64;
+const int SAMPLES = 16;
+
+/* Quad lit by a colored background, with enough small tiles for servers to steal. */
+void scene_create(Scene *scene)
+{
+  Camera *camera = scene->camera;
+  camera->set_full_width(WIDTH);
+  camera->set_full_height(HEIGHT);
+  camera->compute_auto_viewplane();
+
+  Mesh *mesh = new Mesh();
+  scene->geometry.push_back(mesh);
+
+  array<Node *> used_shaders;
+  used_shaders.push_back_slow(scene->default_surface);
+  mesh->set_used_shaders(used_shaders);
+
+  mesh->reserve_mesh(4, 2);
+  mesh->add_vertex(make_float3(-1.0f, -1.0f, 2.0f));
+  mesh->add_vertex(make_float3(1.0f, -1.0f, 2.5f));
+  mesh->add_vertex(make_float3(1.0f, 1.0f, 2.5f));
+  mesh->add_vertex(make_float3(-1.0f, 1.0f, 2.0f));
+  mesh->add_triangle(0, 1, 2, 0, false);
+  mesh->add_triangle(0, 2, 3, 0, false);
+
+  Object *object = new Object();
+  object->set_geometry(mesh);
+  object->set_tfm(transform_identity());
+  scene->objects.push_back(object);
+
+  ShaderGraph *graph = new ShaderGraph();
+  BackgroundNode *background = graph->create_node<BackgroundNode>();
+  background->set_color(make_float3(0.8f, 0.6f, 0.4f));
+  background->set_strength(1.0f);
+  graph->add(background);
+  graph->connect(background->output("Background"), graph->output()->input("Surface"));
+
+  Shader *shader = scene->default_background;
+  shader->set_graph(graph);
+  shader->tag_update(scene);
+}
+
+vector<float> render(const DeviceInfo &device_info)
+{
+  SessionParams session_params;
+  session_params.device = device_info;
+  session_params.background = true;
+  session_params.samples = SAMPLES;
+  session_params.tile_size = make_int2(8, 8);
+
+  Session session(session_params);
+  EXPECT_FALSE(session.progress.get_error()) << session.progress.get_error_message();
+
+  SceneParams scene_params;
+  session.scene = new Scene(scene_params, session.device);
+  scene_create(session.scene);
+
+  vector<float> pixels(WIDTH * HEIGHT * 4, 0.0f);
+  session.write_render_tile_cb = [&](RenderTile &rtile) {
+    vector<float> tile_pixels(rtile.w * rtile.h * 4);
+    if (!rtile.buffers->copy_from_device() ||
+        !rtile.buffers->get_pass_rect("Combined", 1.0f, rtile.sample, 4, tile_pixels.data())) {
+      return;
+    }
+    for (int y = 0; y < rtile.h; y++) {
+      memcpy(&pixels[((rtile.y + y) * WIDTH + rtile.x) * 4],
+             &tile_pixels[y * rtile.w * 4],
+             sizeof(float) * rtile.w * 4);
+    }
+  };
+
+  BufferParams buffer_params;
+  buffer_params.width = WIDTH;
+  buffer_params.height = HEIGHT;
+  buffer_params.full_width = WIDTH;
+  buffer_params.full_height = HEIGHT;
+  Pass::add(PASS_COMBINED, buffer_params.passes, "Combined");
+  session.scene->film->tag_passes_update(session.scene, buffer_params.passes);
+
+  session.reset(buffer_params, SAMPLES);
+  session.start();
+  session.wait();
+
+  EXPECT_FALSE(session.progress.get_error()) << session.progress.get_error_message();
+
+  return pixels;
+}
+
+/* Render server on localhost, serving a single connection in its own thread. */
+struct LocalServer {
+  LocalServer(DeviceInfo info, int port) : port(port), done(false)
+  {
+    device = Device::create(info, stats, profiler, true);
+    server_thread = new thread([this]() {
+      device->server_run(this->port, 1);
+      done = true;
+    });
+  }
+
+  ~LocalServer()
+  {
+    server_thread->join();
+    delete server_thread;
+    delete device;
+  }
+
+  /* Wait for the client to disconnect, or disconnect an unused server so it stops. */
+  bool wait_disconnected()
+  {
+    for (int i = 0; i < 100 && !done; i++) {
+      time_sleep(0.1);
+    }
+    if (done) {
+      return true;
+    }
+
+    DeviceInfo network_info;
+    network_info.type = DEVICE_NETWORK;
+    Stats client_stats;
+    Profiler client_profiler;
+    const string address = string_printf("127.0.0.1:%d", port);
+    delete device_network_create(network_info, client_stats, client_profiler, address.c_str());
+    return false;
+  }
+
+  int port;
+  std::atomic<bool> done;
+  Stats stats;
+  Profiler profiler;
+  Device *device;
+  thread *server_thread;
+};
+
+}  // namespace
+
+/* Render on the local CPU along with two servers on localhost, which are found by the discovery
+ * of the multi device. Tiles are distributed over all devices and stolen from the servers, and
+ * the image must match a render on the CPU only. */
+TEST(device_network, localhost_servers)
+{
+  TaskScheduler::init(0);
+
+  vector<DeviceInfo> cpu_devices = Device::available_devices(DEVICE_MASK_CPU);
+  ASSERT_FALSE(cpu_devices.empty());
+  const DeviceInfo cpu_info = cpu_devices.front();
+
+  const vector<float> reference = render(cpu_info);
+
+  {
+    LocalServer server_a(cpu_info, 5130);
+    LocalServer server_b(cpu_info, 5131);
+    time_sleep(0.5);
+
+    DeviceInfo multi_info = cpu_info;
+    multi_info.id = "MULTI";
+    multi_info.multi_devices.push_back(cpu_info);
+
+    const vector<float> result = render(multi_info);
+
+    EXPECT_TRUE(server_a.wait_disconnected()) << "Server was not used for rendering";
+    EXPECT_TRUE(server_b.wait_disconnected()) << "Server was not used for rendering";
+
+    ASSERT_EQ(result.size(), reference.size());
+    for (size_t i = 0; i < result.size(); i++) {
+      ASSERT_NEAR(result[i], reference[i], 1e-4f) << "Pixel component " << i;
+    }
+  }
+
+  TaskScheduler::exit();
+}
+
+CCL_NAMESPACE_END
@@ -59,7 +59,7 @@ void DebugFlags::CPU::reset()
 
   bvh_layout = BVH_LAYOUT_AUTO;
 
-  split_kernel = false;
+  split_kernel = (getenv("CYCLES_CPU_SPLIT_KERNEL") != NULL);
 }
 
 DebugFlags::CUDA::CUDA() : adaptive_compile(false), split_kernel(false)
@@ -80,7 +80,8 @@ class DebugFlags {
      */
     BVHLayout bvh_layout;
 
-    /* Whether split kernel is used */
+    /* Whether split kernel is used, rendering batches of paths in wavefront order with their
+     * shaders sorted. Can be enabled with the CYCLES_CPU_SPLIT_KERNEL environment variable. */
     bool split_kernel;
   };
 
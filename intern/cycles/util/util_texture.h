@@ -50,6 +50,7 @@ typedef enum ImageDataType {
   IMAGE_DATA_TYPE_USHORT = 7,
   IMAGE_DATA_TYPE_NANOVDB_FLOAT = 8,
   IMAGE_DATA_TYPE_NANOVDB_FLOAT3 = 9,
+  IMAGE_DATA_TYPE_TEXTURE_CACHE = 10,
 
   IMAGE_DATA_NUM_TYPES
 } ImageDataType;
@@ -96,6 +97,14 @@ typedef struct TextureInfo {
   Transform transform_3d;
 } TextureInfo;
 
+/* Data of images that are loaded on demand through the texture cache on the CPU.
+ * Instead of pixels the texture memory holds the texture system and the handle
+ * of the image file in it. */
+typedef struct TextureCacheHandle {
+  uint64_t texture_system;
+  uint64_t handle;
+} TextureCacheHandle;
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_TEXTURE_H__ */
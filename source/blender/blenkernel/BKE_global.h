@@ -154,7 +154,8 @@ enum {
   G_DEBUG_XR = (1 << 19),                    /* XR/OpenXR messages */
   G_DEBUG_XR_TIME = (1 << 20),               /* XR/OpenXR timing messages */
 
-  G_DEBUG_GHOST = (1 << 21), /* Debug GHOST module. */
+  G_DEBUG_GHOST = (1 << 21),       /* Debug GHOST module. */
+  G_DEBUG_SCULPT_TIME = (1 << 22), /* sculpt stroke timing statistics */
 };
 
 #define G_DEBUG_ALL \
@@ -606,6 +606,10 @@ typedef struct SculptSession {
   /* This flag prevents PBVH from being freed when creating the vp_handle for texture paint. */
   bool building_vp_handle;
 
+  /* Set by operations which only modify vertex data before tagging the object for a geometry
+   * update: the PBVH is refit instead of rebuilt when the object is evaluated again. */
+  bool refit_pbvh_on_update;
+
   /**
    * ID data is older than sculpt-mode data.
    * Set #Main.is_memfile_undo_flush_needed when enabling.
@@ -193,11 +193,30 @@ bool BKE_pbvh_node_find_nearest_to_ray(PBVH *pbvh,
 
 /* Drawing */
 
+/* Resolution of the grid that vertices of mesh nodes are clustered on, for the simplified draw
+ * buffers used when nodes are far enough from the view. */
+#define PBVH_LOD_GRID_RES 16
+
+typedef struct PBVHLodParams {
+  /* Row of the object to clip space matrix that gives the W coordinate, to get the size of a
+   * pixel at a point like #ED_view3d_pixel_size. */
+  float persmat_w[4];
+  /* Size of a pixel in object space at a W coordinate of 1. */
+  float pixel_size;
+  /* Largest error in pixels for which simplified buffers are drawn. */
+  float error_max;
+} PBVHLodParams;
+
+bool BKE_pbvh_lod_use(const float bb_min[3], const float bb_max[3], const PBVHLodParams *params);
+
 void BKE_pbvh_draw_cb(PBVH *pbvh,
                       bool update_only_visible,
                       PBVHFrustumPlanes *update_frustum,
                       PBVHFrustumPlanes *draw_frustum,
-                      void (*draw_fn)(void *user_data, struct GPU_PBVH_Buffers *buffers),
+                      const PBVHLodParams *lod_params,
+                      void (*draw_fn)(void *user_data,
+                                      struct GPU_PBVH_Buffers *buffers,
+                                      bool use_lod),
                       void *user_data);
 
 void BKE_pbvh_draw_debug_cb(
@@ -301,9 +320,11 @@ void BKE_pbvh_bmesh_after_stroke(PBVH *pbvh);
 /* Update Bounding Box/Redraw and clear flags */
 
 void BKE_pbvh_update_bounds(PBVH *pbvh, int flags);
+bool BKE_pbvh_refit_mesh(PBVH *pbvh, const struct Mesh *mesh);
 void BKE_pbvh_update_vertex_data(PBVH *pbvh, int flags);
 void BKE_pbvh_update_visibility(PBVH *pbvh);
 void BKE_pbvh_update_normals(PBVH *pbvh, struct SubdivCCG *subdiv_ccg);
+double BKE_pbvh_normals_update_time_take(PBVH *pbvh);
 void BKE_pbvh_redraw_BB(PBVH *pbvh, float bb_min[3], float bb_max[3]);
 void BKE_pbvh_get_grid_updates(PBVH *pbvh, bool clear, void ***r_gridfaces, int *r_totface);
 void BKE_pbvh_grids_update(PBVH *pbvh,
@@ -153,6 +153,8 @@ void BKE_scene_graph_evaluated_ensure(struct Depsgraph *depsgraph, struct Main *
 
 void BKE_scene_graph_update_for_newframe(struct Depsgraph *depsgraph);
 void BKE_scene_graph_update_for_newframe_ex(struct Depsgraph *depsgraph, const bool clear_recalc);
+void BKE_scene_graph_update_for_evaluated_newframe(struct Depsgraph *depsgraph,
+                                                   const bool clear_recalc);
 
 void BKE_scene_view_layer_graph_evaluated_ensure(struct Main *bmain,
                                                  struct Scene *scene,
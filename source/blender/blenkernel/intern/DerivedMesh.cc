@@ -1898,6 +1898,97 @@ static void mesh_runtime_check_normals_valid(const Mesh *mesh)
   BLI_assert(!(mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL));
 }
 
+/**
+ * When the modifier stack only deforms the mesh, the evaluated mesh references the topology of
+ * the copy-on-write mesh. If that topology did not change since the last evaluation, the draw
+ * cache of the previous evaluated mesh can be kept, only refreshing the buffers depending on
+ * vertex positions instead of extracting everything again (armature or shape key playback).
+ */
+static bool mesh_eval_shares_topology(const Mesh *mesh_eval, const Mesh *mesh)
+{
+  return mesh_eval != mesh && mesh_eval->totvert == mesh->totvert &&
+         mesh_eval->totedge == mesh->totedge && mesh_eval->totloop == mesh->totloop &&
+         mesh_eval->totpoly == mesh->totpoly && mesh_eval->medge == mesh->medge &&
+         mesh_eval->mloop == mesh->mloop && mesh_eval->mpoly == mesh->mpoly;
+}
+
+/**
+ * Modifiers which don't change the topology can still replace other layers of the evaluated mesh,
+ * like UV Warp or Vertex Weight Edit. The draw cache only refreshes buffers depending on vertex
+ * positions and normals, so every other layer has to be the same array in both meshes.
+ */
+static bool mesh_eval_shares_custom_data(const Mesh *mesh_eval, const Mesh *mesh_eval_prev)
+{
+  const CustomData *domains[4][2] = {{&mesh_eval->vdata, &mesh_eval_prev->vdata},
+                                     {&mesh_eval->edata, &mesh_eval_prev->edata},
+                                     {&mesh_eval->ldata, &mesh_eval_prev->ldata},
+                                     {&mesh_eval->pdata, &mesh_eval_prev->pdata}};
+  for (const CustomData **domain : domains) {
+    const CustomData *data = domain[0];
+    const CustomData *data_prev = domain[1];
+    if (data->totlayer != data_prev->totlayer) {
+      return false;
+    }
+    for (int j = 0; j < data->totlayer; j++) {
+      const CustomDataLayer *layer = &data->layers[j];
+      const CustomDataLayer *layer_prev = &data_prev->layers[j];
+      if (layer->type != layer_prev->type) {
+        return false;
+      }
+      if (ELEM(layer->type, CD_MVERT, CD_NORMAL)) {
+        continue;
+      }
+      if (layer->data != layer_prev->data) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Take the evaluated mesh out of the object when its draw cache is a candidate for reuse, so it
+ * is not freed with the other derived caches. See #mesh_eval_batch_cache_reuse.
+ */
+static Mesh *mesh_eval_detach_for_batch_cache_reuse(Object *ob)
+{
+  ID *data_eval = ob->runtime.data_eval;
+  if (data_eval == nullptr || !ob->runtime.is_data_eval_owned || GS(data_eval->name) != ID_ME ||
+      ob->runtime.data_orig == nullptr) {
+    return nullptr;
+  }
+  Mesh *mesh_eval_prev = (Mesh *)data_eval;
+  const Mesh *mesh = (const Mesh *)ob->runtime.data_orig;
+  if (mesh_eval_prev->runtime.batch_cache == nullptr ||
+      mesh_eval_prev->runtime.subdiv_ccg != nullptr ||
+      (mesh->id.recalc & ID_RECALC_COPY_ON_WRITE) ||
+      !mesh_eval_shares_topology(mesh_eval_prev, mesh)) {
+    return nullptr;
+  }
+  ob->runtime.data_eval = nullptr;
+  return mesh_eval_prev;
+}
+
+/**
+ * Move the draw cache of the previous evaluated mesh to the new one when both reference the same
+ * topology and layers other than positions, and free the previous evaluated mesh.
+ */
+static void mesh_eval_batch_cache_reuse(Mesh *mesh_eval_prev,
+                                        Mesh *mesh_eval,
+                                        const Mesh *mesh,
+                                        const bool is_mesh_eval_owned)
+{
+  if (is_mesh_eval_owned && mesh_eval->runtime.batch_cache == nullptr &&
+      mesh_eval_shares_topology(mesh_eval, mesh) &&
+      mesh_eval_shares_topology(mesh_eval_prev, mesh) &&
+      mesh_eval_shares_custom_data(mesh_eval, mesh_eval_prev)) {
+    mesh_eval->runtime.batch_cache = mesh_eval_prev->runtime.batch_cache;
+    mesh_eval_prev->runtime.batch_cache = nullptr;
+    BKE_mesh_batch_cache_dirty_tag(mesh_eval, BKE_MESH_BATCH_DIRTY_DEFORM);
+  }
+  BKE_mesh_eval_delete(mesh_eval_prev);
+}
+
 static void mesh_build_data(struct Depsgraph *depsgraph,
                             Scene *scene,
                             Object *ob,
@@ -1910,6 +2001,7 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
    * they aren't cleaned up properly on mode switch, causing crashes, e.g T58150. */
   BLI_assert(ob->id.tag & LIB_TAG_COPIED_ON_WRITE);
 
+  Mesh *mesh_eval_prev = mesh_eval_detach_for_batch_cache_reuse(ob);
   BKE_object_free_derived_caches(ob);
   if (DEG_is_active(depsgraph)) {
     BKE_sculpt_update_object_before_eval(ob);
@@ -1949,6 +2041,10 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
   const bool is_mesh_eval_owned = (mesh_eval != mesh->runtime.mesh_eval);
   BKE_object_eval_assign_data(ob, &mesh_eval->id, is_mesh_eval_owned);
 
+  if (mesh_eval_prev != nullptr) {
+    mesh_eval_batch_cache_reuse(mesh_eval_prev, mesh_eval, mesh, is_mesh_eval_owned);
+  }
+
   /* Add the final mesh as read-only non-owning component to the geometry set. */
   MeshComponent &mesh_component = geometry_set_eval->get_component_for_write<MeshComponent>();
   mesh_component.replace_mesh_but_keep_vertex_group_names(mesh_eval,
@@ -0,0 +1,286 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+
+#include "BKE_action.h"
+#include "BKE_anim_data.h"
+#include "BKE_appdir.h"
+#include "BKE_blender.h"
+#include "BKE_customdata.h"
+#include "BKE_fcurve.h"
+#include "BKE_global.h"
+#include "BKE_idtype.h"
+#include "BKE_image.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
+#include "BKE_modifier.h"
+#include "BKE_node.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_anim_types.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "ED_keyframing.h"
+
+#include "IMB_imbuf.h"
+
+#include "RNA_define.h"
+
+#include "CLG_log.h"
+
+namespace blender::bke::tests {
+
+/* Number of times the draw cache was tagged for deformation. */
+static int batch_cache_deform_tags = 0;
+
+static void batch_cache_dirty_tag(Mesh *UNUSED(me), eMeshBatchDirtyMode mode)
+{
+  if (mode == BKE_MESH_BATCH_DIRTY_DEFORM) {
+    batch_cache_deform_tags++;
+  }
+}
+
+static void batch_cache_free(Mesh *me)
+{
+  MEM_SAFE_FREE(me->runtime.batch_cache);
+}
+
+class MeshEvalBatchCacheTest : public testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Scene *scene = nullptr;
+  Depsgraph *depsgraph = nullptr;
+
+ public:
+  static void SetUpTestCase()
+  {
+    testing::Test::SetUpTestCase();
+
+    CLG_init();
+    BLI_threadapi_init();
+
+    DNA_sdna_current_init();
+    BKE_blender_globals_init();
+
+    BKE_idtype_init();
+    BKE_appdir_init();
+    IMB_init();
+    BKE_images_init();
+    BKE_modifier_init();
+    DEG_register_node_types();
+    RNA_init();
+    BKE_node_system_init();
+
+    G.background = true;
+    G.factory_startup = true;
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_blender_free();
+    RNA_exit();
+
+    DEG_free_node_types();
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+
+    BKE_blender_atexit();
+
+    BKE_tempdir_session_purge();
+    BKE_appdir_exit();
+    CLG_exit();
+
+    testing::Test::TearDownTestCase();
+  }
+
+ protected:
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    scene = BKE_scene_add(bmain, "Scene");
+    scene->r.cfra = 1;
+
+    /* The draw cache of evaluated meshes is replaced by a dummy allocation. */
+    BKE_mesh_batch_cache_dirty_tag_cb = batch_cache_dirty_tag;
+    BKE_mesh_batch_cache_free_cb = batch_cache_free;
+    batch_cache_deform_tags = 0;
+  }
+
+  void TearDown() override
+  {
+    if (depsgraph != nullptr) {
+      DEG_graph_free(depsgraph);
+    }
+    BKE_main_free(bmain);
+
+    BKE_mesh_batch_cache_dirty_tag_cb = nullptr;
+    BKE_mesh_batch_cache_free_cb = nullptr;
+  }
+
+  /* Grid of quads with a UV map, in a new object with a single modifier. The first property of
+   * the modifier is animated from frame 1 to 10. */
+  Object *object_add_animated(const ModifierType modifier_type,
+                              const char *rna_property,
+                              const float value_begin,
+                              const float value_end)
+  {
+    ViewLayer *view_layer = static_cast<ViewLayer *>(scene->view_layers.first);
+    Object *ob = BKE_object_add(bmain, view_layer, OB_MESH, "Object");
+    mesh_quad_grid_fill(static_cast<Mesh *>(ob->data), 8);
+
+    ModifierData *md = BKE_modifier_new(modifier_type);
+    BLI_addtail(&ob->modifiers, md);
+    BKE_modifier_unique_name(&ob->modifiers, md);
+
+    AnimData *adt = BKE_animdata_add_id(&ob->id);
+    adt->action = BKE_action_add(bmain, "Action");
+    FCurve *fcu = BKE_fcurve_create();
+    char rna_path[128];
+    BLI_snprintf(rna_path, sizeof(rna_path), "modifiers[\"%s\"].%s", md->name, rna_property);
+    fcu->rna_path = BLI_strdup(rna_path);
+    insert_vert_fcurve(fcu, 1.0f, value_begin, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+    insert_vert_fcurve(fcu, 10.0f, value_end, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+    BLI_addtail(&adt->action->curves, fcu);
+
+    return ob;
+  }
+
+  static void mesh_quad_grid_fill(Mesh *me, const int size)
+  {
+    const int row = size + 1;
+    me->totvert = row * row;
+    me->totloop = size * size * 4;
+    me->totpoly = size * size;
+    CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, nullptr, me->totvert);
+    CustomData_add_layer(&me->ldata, CD_MLOOP, CD_CALLOC, nullptr, me->totloop);
+    CustomData_add_layer(&me->ldata, CD_MLOOPUV, CD_CALLOC, nullptr, me->totloop);
+    CustomData_add_layer(&me->pdata, CD_MPOLY, CD_CALLOC, nullptr, me->totpoly);
+    BKE_mesh_update_customdata_pointers(me, false);
+
+    for (int y = 0; y <= size; y++) {
+      for (int x = 0; x <= size; x++) {
+        MVert *mv = &me->mvert[y * row + x];
+        mv->co[0] = (float)x / size;
+        mv->co[1] = (float)y / size;
+      }
+    }
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        const int poly_index = y * size + x;
+        const int v = y * row + x;
+        const int verts[4] = {v, v + 1, v + row + 1, v + row};
+        MPoly *mp = &me->mpoly[poly_index];
+        mp->loopstart = poly_index * 4;
+        mp->totloop = 4;
+        for (int i = 0; i < 4; i++) {
+          me->mloop[mp->loopstart + i].v = verts[i];
+          copy_v2_v2(me->mloopuv[mp->loopstart + i].uv, me->mvert[verts[i]].co);
+        }
+      }
+    }
+
+    BKE_mesh_calc_edges(me, false, false);
+    BKE_mesh_calc_normals(me);
+  }
+
+  void depsgraph_create()
+  {
+    ViewLayer *view_layer = static_cast<ViewLayer *>(scene->view_layers.first);
+    depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(depsgraph);
+    BKE_scene_graph_update_tagged(depsgraph, bmain);
+  }
+
+  void frame_change(const int frame)
+  {
+    scene->r.cfra = frame;
+    BKE_scene_graph_update_for_newframe(depsgraph);
+  }
+
+  Mesh *mesh_evaluated_get(Object *ob)
+  {
+    Object *ob_eval = DEG_get_evaluated_object(depsgraph, ob);
+    return BKE_object_get_evaluated_mesh(ob_eval);
+  }
+};
+
+/* Deforming modifiers only change vertex positions, so the draw cache is kept and only the
+ * buffers depending on positions are refreshed. */
+TEST_F(MeshEvalBatchCacheTest, deform_keeps_batch_cache)
+{
+  Object *ob = object_add_animated(eModifierType_Displace, "strength", 0.0f, 1.0f);
+  depsgraph_create();
+
+  Mesh *mesh_eval = mesh_evaluated_get(ob);
+  ASSERT_NE(mesh_eval, nullptr);
+  void *batch_cache = MEM_callocN(1, __func__);
+  mesh_eval->runtime.batch_cache = batch_cache;
+
+  frame_change(5);
+
+  mesh_eval = mesh_evaluated_get(ob);
+  ASSERT_NE(mesh_eval, nullptr);
+  EXPECT_EQ(mesh_eval->runtime.batch_cache, batch_cache);
+  EXPECT_EQ(batch_cache_deform_tags, 1);
+}
+
+/* Animated UV Warp keeps the topology, but replaces the UV map. Refreshing positions only would
+ * draw the UVs of the previous frame, so the draw cache has to be built again. */
+TEST_F(MeshEvalBatchCacheTest, uvwarp_discards_batch_cache)
+{
+  Object *ob = object_add_animated(eModifierType_UVWarp, "offset", 0.0f, 1.0f);
+  depsgraph_create();
+
+  Mesh *mesh_eval = mesh_evaluated_get(ob);
+  ASSERT_NE(mesh_eval, nullptr);
+  mesh_eval->runtime.batch_cache = MEM_callocN(1, __func__);
+  const MLoopUV *mloopuv_prev = static_cast<const MLoopUV *>(
+      CustomData_get_layer(&mesh_eval->ldata, CD_MLOOPUV));
+  const float uv_prev = mloopuv_prev[0].uv[0];
+
+  frame_change(5);
+
+  mesh_eval = mesh_evaluated_get(ob);
+  ASSERT_NE(mesh_eval, nullptr);
+  EXPECT_EQ(mesh_eval->runtime.batch_cache, nullptr);
+  EXPECT_EQ(batch_cache_deform_tags, 0);
+
+  const MLoopUV *mloopuv = static_cast<const MLoopUV *>(
+      CustomData_get_layer(&mesh_eval->ldata, CD_MLOOPUV));
+  EXPECT_NE(mloopuv[0].uv[0], uv_prev);
+}
+
+}  // namespace blender::bke::tests
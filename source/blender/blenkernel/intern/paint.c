@@ -1764,7 +1764,10 @@ void BKE_sculpt_update_object_before_eval(Object *ob)
       /* We free pbvh on changes, except in the middle of drawing a stroke
        * since it can't deal with changing PVBH node organization, we hope
        * topology does not change in the meantime .. weak. */
-      sculptsession_free_pbvh(ob);
+      if (!(ss->refit_pbvh_on_update && ss->pbvh &&
+            BKE_pbvh_refit_mesh(ss->pbvh, BKE_object_get_original_mesh(ob)))) {
+        sculptsession_free_pbvh(ob);
+      }
 
       BKE_sculptsession_free_deformMats(ob->sculpt);
 
@@ -1783,6 +1786,7 @@ void BKE_sculpt_update_object_before_eval(Object *ob)
 
       MEM_freeN(nodes);
     }
+    ss->refit_pbvh_on_update = false;
   }
 }
 
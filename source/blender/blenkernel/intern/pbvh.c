@@ -32,6 +32,7 @@
 #include "DNA_meshdata_types.h"
 
 #include "BKE_ccg.h"
+#include "BKE_global.h"
 #include "BKE_mesh.h" /* for BKE_mesh_calc_normals */
 #include "BKE_paint.h"
 #include "BKE_pbvh.h"
@@ -249,42 +250,74 @@ void pbvh_grow_nodes(PBVH *pbvh, int totnode)
   pbvh->totnode = totnode;
 }
 
+/* Claim a vertex for a leaf: the vertex is unique to the first leaf using it in build order,
+ * which keeps the result independent from the order the leaves are built by threads. */
+static void vert_owner_claim(int *vert_owner, const int vertex, const int leaf_index)
+{
+  int owner = vert_owner[vertex];
+  while (leaf_index < owner) {
+    const int prev = atomic_cas_int32(&vert_owner[vertex], owner, leaf_index);
+    if (prev == owner) {
+      break;
+    }
+    owner = prev;
+  }
+}
+
+/* Flat open addressing map from vertex to its index in the leaf, see #map_insert_vert. */
+typedef struct LeafVertMap {
+  int *keys;
+  int *values;
+  uint mask;
+} LeafVertMap;
+
 /* Add a vertex to the map, with a positive value for unique vertices and
  * a negative value for additional vertices */
-static int map_insert_vert(
-    PBVH *pbvh, GHash *map, unsigned int *face_verts, unsigned int *uniq_verts, int vertex)
+static int map_insert_vert(PBVH *pbvh,
+                           LeafVertMap *map,
+                           unsigned int *face_verts,
+                           unsigned int *uniq_verts,
+                           const int leaf_index,
+                           const int vertex)
 {
-  void *key, **value_p;
-
-  key = POINTER_FROM_INT(vertex);
-  if (!BLI_ghash_ensure_p(map, key, &value_p)) {
-    int value_i;
-    if (BLI_BITMAP_TEST(pbvh->vert_bitmap, vertex) == 0) {
-      BLI_BITMAP_ENABLE(pbvh->vert_bitmap, vertex);
-      value_i = *uniq_verts;
-      (*uniq_verts)++;
+  uint slot = ((uint)vertex * 2654435761u) & map->mask;
+  while (map->keys[slot] != -1) {
+    if (map->keys[slot] == vertex) {
+      return map->values[slot];
     }
-    else {
-      value_i = ~(*face_verts);
-      (*face_verts)++;
-    }
-    *value_p = POINTER_FROM_INT(value_i);
-    return value_i;
+    slot = (slot + 1) & map->mask;
   }
 
-  return POINTER_AS_INT(*value_p);
+  int value_i;
+  if (pbvh->vert_owner[vertex] == leaf_index) {
+    value_i = *uniq_verts;
+    (*uniq_verts)++;
+  }
+  else {
+    value_i = ~(*face_verts);
+    (*face_verts)++;
+  }
+  map->keys[slot] = vertex;
+  map->values[slot] = value_i;
+  return value_i;
 }
 
 /* Find vertices used by the faces in this node and update the draw buffers */
-static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
+static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node, const int leaf_index)
 {
   bool has_visible = false;
 
   node->uniq_verts = node->face_verts = 0;
   const int totface = node->totprim;
 
-  /* reserve size is rough guess */
-  GHash *map = BLI_ghash_int_new_ex("build_mesh_leaf_node gh", 2 * totface);
+  /* Keep the map at most half full. */
+  const uint map_size = power_of_2_max_u((uint)max_ii(totface, 1) * 3 * 2);
+  LeafVertMap map = {
+      .keys = MEM_malloc_arrayN(map_size, sizeof(int), "build_mesh_leaf_node keys"),
+      .values = MEM_malloc_arrayN(map_size, sizeof(int), "build_mesh_leaf_node values"),
+      .mask = map_size - 1,
+  };
+  copy_vn_i(map.keys, (int)map_size, -1);
 
   int(*face_vert_indices)[3] = MEM_mallocN(sizeof(int[3]) * totface, "bvh node face vert indices");
 
@@ -297,8 +330,12 @@ static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
   for (int i = 0; i < totface; i++) {
     const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
     for (int j = 0; j < 3; j++) {
-      face_vert_indices[i][j] = map_insert_vert(
-          pbvh, map, &node->face_verts, &node->uniq_verts, pbvh->mloop[lt->tri[j]].v);
+      face_vert_indices[i][j] = map_insert_vert(pbvh,
+                                                &map,
+                                                &node->face_verts,
+                                                &node->uniq_verts,
+                                                leaf_index,
+                                                pbvh->mloop[lt->tri[j]].v);
     }
 
     if (has_visible == false) {
@@ -313,16 +350,17 @@ static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
   node->vert_indices = vert_indices;
 
   /* Build the vertex list, unique verts first */
-  GHashIterator gh_iter;
-  GHASH_ITER (gh_iter, map) {
-    void *value = BLI_ghashIterator_getValue(&gh_iter);
-    int ndx = POINTER_AS_INT(value);
+  for (uint slot = 0; slot < map_size; slot++) {
+    if (map.keys[slot] == -1) {
+      continue;
+    }
+    int ndx = map.values[slot];
 
     if (ndx < 0) {
       ndx = -ndx + node->uniq_verts - 1;
     }
 
-    vert_indices[ndx] = POINTER_AS_INT(BLI_ghashIterator_getKey(&gh_iter));
+    vert_indices[ndx] = map.keys[slot];
   }
 
   for (int i = 0; i < totface; i++) {
@@ -339,16 +377,16 @@ static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
 
   BKE_pbvh_node_fully_hidden_set(node, !has_visible);
 
-  BLI_ghash_free(map, NULL, NULL);
+  MEM_freeN(map.keys);
+  MEM_freeN(map.values);
 }
 
-static void update_vb(PBVH *pbvh, PBVHNode *node, BBC *prim_bbc, int offset, int count)
+static void update_vb(PBVH *pbvh, BB *vb, BBC *prim_bbc, int offset, int count)
 {
-  BB_reset(&node->vb);
+  BB_reset(vb);
   for (int i = offset + count - 1; i >= offset; i--) {
-    BB_expand_with_bb(&node->vb, (BB *)(&prim_bbc[pbvh->prim_indices[i]]));
+    BB_expand_with_bb(vb, (BB *)(&prim_bbc[pbvh->prim_indices[i]]));
   }
-  node->orig_vb = node->vb;
 }
 
 /* Returns the number of visible quads in the nodes' grids. */
@@ -412,24 +450,6 @@ static void build_grid_leaf_node(PBVH *pbvh, PBVHNode *node)
   BKE_pbvh_node_mark_rebuild_draw(node);
 }
 
-static void build_leaf(PBVH *pbvh, int node_index, BBC *prim_bbc, int offset, int count)
-{
-  pbvh->nodes[node_index].flag |= PBVH_Leaf;
-
-  pbvh->nodes[node_index].prim_indices = pbvh->prim_indices + offset;
-  pbvh->nodes[node_index].totprim = count;
-
-  /* Still need vb for searches */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
-
-  if (pbvh->looptri) {
-    build_mesh_leaf_node(pbvh, pbvh->nodes + node_index);
-  }
-  else {
-    build_grid_leaf_node(pbvh, pbvh->nodes + node_index);
-  }
-}
-
 /* Return zero if all primitives in the node can be drawn with the
  * same material (including flat/smooth shading), non-zero otherwise */
 static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
@@ -464,6 +484,31 @@ static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
   return false;
 }
 
+/* Node of the tree while it is being built. The nodes are created by the build tasks and copied
+ * to #PBVH.nodes in depth first order once all tasks are done, see #build_flatten. */
+typedef struct PBVHBuildNode {
+  /* Both NULL for leaves. */
+  struct PBVHBuildNode *children[2];
+  BB vb;
+  int offset, count;
+} PBVHBuildNode;
+
+typedef struct PBVHBuildContext {
+  PBVH *pbvh;
+  BBC *prim_bbc;
+  TaskPool *task_pool;
+  /* Sub-trees with less primitives are built by the task of their parent. */
+  int task_min_count;
+} PBVHBuildContext;
+
+static void build_sub(PBVHBuildContext *ctx, PBVHBuildNode *node, BB *cb);
+
+static void build_sub_task_run(TaskPool *__restrict pool, void *taskdata)
+{
+  PBVHBuildContext *ctx = BLI_task_pool_user_data(pool);
+  build_sub(ctx, taskdata, NULL);
+}
+
 /* Recursively build a node in the tree
  *
  * vb is the voxel box around all of the primitives contained in
@@ -473,36 +518,37 @@ static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
  * contained in this node
  *
  * offset and start indicate a range in the array of primitive indices
+ *
+ * Children with enough primitives are built in separate tasks, each task only modifies its own
+ * range of primitive indices.
  */
 
-static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int offset, int count)
+static void build_sub(PBVHBuildContext *ctx, PBVHBuildNode *node, BB *cb)
 {
+  PBVH *pbvh = ctx->pbvh;
+  const int offset = node->offset;
+  const int count = node->count;
   int end;
   BB cb_backing;
 
+  /* Still need vb for searches */
+  update_vb(pbvh, &node->vb, ctx->prim_bbc, offset, count);
+
   /* Decide whether this is a leaf or not */
   const bool below_leaf_limit = count <= pbvh->leaf_limit;
   if (below_leaf_limit) {
     if (!leaf_needs_material_split(pbvh, offset, count)) {
-      build_leaf(pbvh, node_index, prim_bbc, offset, count);
       return;
     }
   }
 
-  /* Add two child nodes */
-  pbvh->nodes[node_index].children_offset = pbvh->totnode;
-  pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
-
-  /* Update parent node bounding box */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
-
   if (!below_leaf_limit) {
     /* Find axis with widest range of primitive centroids */
     if (!cb) {
       cb = &cb_backing;
       BB_reset(cb);
       for (int i = offset + count - 1; i >= offset; i--) {
-        BB_expand(cb, prim_bbc[pbvh->prim_indices[i]].bcentroid);
+        BB_expand(cb, ctx->prim_bbc[pbvh->prim_indices[i]].bcentroid);
       }
     }
     const int axis = BB_widest_axis(cb);
@@ -513,21 +559,108 @@ static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int off
                             offset + count - 1,
                             axis,
                             (cb->bmax[axis] + cb->bmin[axis]) * 0.5f,
-                            prim_bbc);
+                            ctx->prim_bbc);
   }
   else {
     /* Partition primitives by material */
     end = partition_indices_material(pbvh, offset, offset + count - 1);
   }
 
+  /* Add two child nodes */
+  for (int i = 0; i < 2; i++) {
+    PBVHBuildNode *child = MEM_callocN(sizeof(*child), __func__);
+    child->offset = (i == 0) ? offset : end;
+    child->count = (i == 0) ? end - offset : offset + count - end;
+    node->children[i] = child;
+  }
+
   /* Build children */
-  build_sub(pbvh, pbvh->nodes[node_index].children_offset, NULL, prim_bbc, offset, end - offset);
-  build_sub(pbvh,
-            pbvh->nodes[node_index].children_offset + 1,
-            NULL,
-            prim_bbc,
-            end,
-            offset + count - end);
+  for (int i = 0; i < 2; i++) {
+    PBVHBuildNode *child = node->children[i];
+    if (child->count >= ctx->task_min_count) {
+      BLI_task_pool_push(ctx->task_pool, build_sub_task_run, child, false, NULL);
+    }
+    else {
+      build_sub(ctx, child, NULL);
+    }
+  }
+}
+
+typedef struct PBVHBuildLeaves {
+  int *nodes;
+  int len, alloc_len;
+} PBVHBuildLeaves;
+
+/* Copy the built tree to #PBVH.nodes, in the same order a single threaded recursive build creates
+ * the nodes, and free it. Leaves are gathered in build order. */
+static void build_flatten(PBVH *pbvh,
+                          PBVHBuildNode *build_node,
+                          int node_index,
+                          PBVHBuildLeaves *leaves)
+{
+  PBVHNode *node = &pbvh->nodes[node_index];
+  node->vb = build_node->vb;
+  node->orig_vb = build_node->vb;
+
+  if (build_node->children[0] == NULL) {
+    node->flag |= PBVH_Leaf;
+    node->prim_indices = pbvh->prim_indices + build_node->offset;
+    node->totprim = build_node->count;
+
+    if (leaves->len == leaves->alloc_len) {
+      leaves->alloc_len = max_ii(leaves->alloc_len * 2, 64);
+      leaves->nodes = MEM_reallocN(leaves->nodes, sizeof(int) * leaves->alloc_len);
+    }
+    leaves->nodes[leaves->len++] = node_index;
+  }
+  else {
+    const int children_offset = pbvh->totnode;
+    node->children_offset = children_offset;
+    /* May reallocate the nodes, don't use `node` after this. */
+    pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
+
+    build_flatten(pbvh, build_node->children[0], children_offset, leaves);
+    build_flatten(pbvh, build_node->children[1], children_offset + 1, leaves);
+  }
+
+  MEM_freeN(build_node);
+}
+
+typedef struct PBVHBuildLeavesData {
+  PBVH *pbvh;
+  const int *leaves;
+} PBVHBuildLeavesData;
+
+static void build_vert_owner_task_cb(void *__restrict userdata,
+                                     const int n,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  const PBVHNode *node = &pbvh->nodes[data->leaves[n]];
+
+  for (int i = 0; i < node->totprim; i++) {
+    const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
+    for (int j = 0; j < 3; j++) {
+      vert_owner_claim(pbvh->vert_owner, pbvh->mloop[lt->tri[j]].v, n);
+    }
+  }
+}
+
+static void build_leaf_task_cb(void *__restrict userdata,
+                               const int n,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  PBVHNode *node = &pbvh->nodes[data->leaves[n]];
+
+  if (pbvh->looptri) {
+    build_mesh_leaf_node(pbvh, node, n);
+  }
+  else {
+    build_grid_leaf_node(pbvh, node);
+  }
 }
 
 static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
@@ -551,8 +684,120 @@ static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
     }
   }
 
+  /* Partition the primitives, building sub-trees in parallel. */
+  PBVHBuildContext ctx = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+      .task_min_count = pbvh->leaf_limit * 4,
+  };
+  ctx.task_pool = BLI_task_pool_create(&ctx, TASK_PRIORITY_HIGH);
+
+  PBVHBuildNode *root = MEM_callocN(sizeof(*root), __func__);
+  root->offset = 0;
+  root->count = totprim;
+  build_sub(&ctx, root, cb);
+
+  BLI_task_pool_work_and_wait(ctx.task_pool);
+  BLI_task_pool_free(ctx.task_pool);
+
   pbvh->totnode = 1;
-  build_sub(pbvh, 0, cb, prim_bbc, 0, totprim);
+  PBVHBuildLeaves leaves = {NULL};
+  build_flatten(pbvh, root, 0, &leaves);
+
+  /* Build the leaves in parallel, vertices are first assigned to the leaves owning them. */
+  PBVHBuildLeavesData data = {
+      .pbvh = pbvh,
+      .leaves = leaves.nodes,
+  };
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, leaves.len);
+
+  if (pbvh->looptri) {
+    copy_vn_i(pbvh->vert_owner, pbvh->totvert, INT_MAX);
+    BLI_task_parallel_range(0, leaves.len, &data, build_vert_owner_task_cb, &settings);
+  }
+  BLI_task_parallel_range(0, leaves.len, &data, build_leaf_task_cb, &settings);
+
+  MEM_freeN(leaves.nodes);
+}
+
+typedef struct PBVHBuildPrimBBCData {
+  PBVH *pbvh;
+  BBC *prim_bbc;
+} PBVHBuildPrimBBCData;
+
+static void build_mesh_prim_bbc_task_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  PBVHBuildPrimBBCData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  const MLoopTri *lt = &pbvh->looptri[i];
+  const int sides = 3;
+  BBC *bbc = data->prim_bbc + i;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < sides; j++) {
+    BB_expand((BB *)bbc, pbvh->verts[pbvh->mloop[lt->tri[j]].v].co);
+  }
+
+  BBC_update_centroid(bbc);
+
+  BB_expand(tls->userdata_chunk, bbc->bcentroid);
+}
+
+static void build_grids_prim_bbc_task_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict tls)
+{
+  PBVHBuildPrimBBCData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  const CCGKey *key = &pbvh->gridkey;
+  CCGElem *grid = pbvh->grids[i];
+  BBC *bbc = data->prim_bbc + i;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < key->grid_area; j++) {
+    BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+  }
+
+  BBC_update_centroid(bbc);
+
+  BB_expand(tls->userdata_chunk, bbc->bcentroid);
+}
+
+static void build_prim_bbc_reduce(const void *__restrict UNUSED(userdata),
+                                  void *__restrict chunk_join,
+                                  void *__restrict chunk)
+{
+  BB_expand_with_bb(chunk_join, chunk);
+}
+
+/* For each primitive, store the AABB and the AABB centroid, and compute the bounding box
+ * around all the centroids. */
+static void build_prim_bbc(PBVH *pbvh, BBC *prim_bbc, int totprim, BB *r_cb)
+{
+  PBVHBuildPrimBBCData data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+  };
+
+  BB_reset(r_cb);
+
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, totprim);
+  settings.min_iter_per_thread = 1024;
+  settings.userdata_chunk = r_cb;
+  settings.userdata_chunk_size = sizeof(*r_cb);
+  settings.func_reduce = build_prim_bbc_reduce;
+  BLI_task_parallel_range(0,
+                          totprim,
+                          &data,
+                          (pbvh->type == PBVH_FACES) ? build_mesh_prim_bbc_task_cb :
+                                                       build_grids_prim_bbc_task_cb,
+                          &settings);
 }
 
 /**
@@ -582,7 +827,7 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->mloop = mloop;
   pbvh->looptri = looptri;
   pbvh->verts = verts;
-  pbvh->vert_bitmap = BLI_BITMAP_NEW(totvert, "bvh->vert_bitmap");
+  pbvh->vert_owner = MEM_malloc_arrayN(totvert, sizeof(int), "bvh->vert_owner");
   pbvh->totvert = totvert;
   pbvh->leaf_limit = LEAF_LIMIT;
   pbvh->vdata = vdata;
@@ -592,33 +837,15 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->face_sets_color_seed = mesh->face_sets_color_seed;
   pbvh->face_sets_color_default = mesh->face_sets_color_default;
 
-  BB_reset(&cb);
-
-  /* For each face, store the AABB and the AABB centroid */
   prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
-
-  for (int i = 0; i < looptri_num; i++) {
-    const MLoopTri *lt = &looptri[i];
-    const int sides = 3;
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < sides; j++) {
-      BB_expand((BB *)bbc, verts[pbvh->mloop[lt->tri[j]].v].co);
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  build_prim_bbc(pbvh, prim_bbc, looptri_num, &cb);
 
   if (looptri_num) {
     pbvh_build(pbvh, &cb, prim_bbc, looptri_num);
   }
 
   MEM_freeN(prim_bbc);
-  MEM_freeN(pbvh->vert_bitmap);
+  MEM_SAFE_FREE(pbvh->vert_owner);
 }
 
 /* Do a full rebuild with on Grids data structure */
@@ -642,25 +869,8 @@ void BKE_pbvh_build_grids(PBVH *pbvh,
   pbvh->leaf_limit = max_ii(LEAF_LIMIT / (gridsize * gridsize), 1);
 
   BB cb;
-  BB_reset(&cb);
-
-  /* For each grid, store the AABB and the AABB centroid */
   BBC *prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
-
-  for (int i = 0; i < totgrid; i++) {
-    CCGElem *grid = grids[i];
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < gridsize * gridsize; j++) {
-      BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  build_prim_bbc(pbvh, prim_bbc, totgrid, &cb);
 
   if (totgrid) {
     pbvh_build(pbvh, &cb, prim_bbc, totgrid);
@@ -1429,6 +1639,30 @@ void BKE_pbvh_update_bounds(PBVH *pbvh, int flag)
   MEM_SAFE_FREE(nodes);
 }
 
+/**
+ * Keep the nodes of a PBVH built from \a mesh and only update their bounds and draw buffers,
+ * instead of building a new PBVH. Only valid when vertex data changed but topology did not.
+ *
+ * \return false when the PBVH does not reference the mesh data anymore and has to be rebuilt.
+ */
+bool BKE_pbvh_refit_mesh(PBVH *pbvh, const Mesh *mesh)
+{
+  if (pbvh->type != PBVH_FACES || pbvh->mesh != mesh || pbvh->mpoly != mesh->mpoly ||
+      pbvh->mloop != mesh->mloop || pbvh->totvert != mesh->totvert ||
+      (!pbvh->deformed && pbvh->verts != mesh->mvert)) {
+    return false;
+  }
+
+  for (int i = 0; i < pbvh->totnode; i++) {
+    if (pbvh->nodes[i].flag & PBVH_Leaf) {
+      BKE_pbvh_node_mark_update(&pbvh->nodes[i]);
+    }
+  }
+  BKE_pbvh_update_bounds(pbvh, PBVH_UpdateBB | PBVH_UpdateOriginalBB | PBVH_UpdateRedraw);
+
+  return true;
+}
+
 void BKE_pbvh_update_vertex_data(PBVH *pbvh, int flag)
 {
   if (!pbvh->nodes) {
@@ -2653,6 +2887,8 @@ void BKE_pbvh_update_normals(PBVH *pbvh, struct SubdivCCG *subdiv_ccg)
   PBVHNode **nodes;
   int totnode;
 
+  const double time = (G.debug & G_DEBUG_SCULPT_TIME) ? PIL_check_seconds_timer() : 0.0;
+
   BKE_pbvh_search_gather(
       pbvh, update_search_cb, POINTER_FROM_INT(PBVH_UpdateNormals), &nodes, &totnode);
 
@@ -2675,6 +2911,19 @@ void BKE_pbvh_update_normals(PBVH *pbvh, struct SubdivCCG *subdiv_ccg)
   }
 
   MEM_SAFE_FREE(nodes);
+
+  if (G.debug & G_DEBUG_SCULPT_TIME) {
+    pbvh->normals_update_time += PIL_check_seconds_timer() - time;
+  }
+}
+
+/* Time spent in #BKE_pbvh_update_normals since the previous call, in seconds. Only measured
+ * with `--debug-sculpt-time`, the updates usually happen when drawing. */
+double BKE_pbvh_normals_update_time_take(PBVH *pbvh)
+{
+  const double time = pbvh->normals_update_time;
+  pbvh->normals_update_time = 0.0;
+  return time;
 }
 
 void BKE_pbvh_face_sets_color_set(PBVH *pbvh, int seed, int color_default)
@@ -2703,11 +2952,42 @@ static bool pbvh_draw_search_cb(PBVHNode *node, void *data_v)
   return true;
 }
 
+/**
+ * Whether the simplified draw buffers of a node with the given bounds can be drawn, with the
+ * error of the simplification below the maximum number of pixels.
+ */
+bool BKE_pbvh_lod_use(const float bb_min[3], const float bb_max[3], const PBVHLodParams *params)
+{
+  /* Largest distance of a vertex to the vertex of its cluster. */
+  float size[3];
+  sub_v3_v3v3(size, bb_max, bb_min);
+  const float error = max_fff(size[0], size[1], size[2]) / PBVH_LOD_GRID_RES * (float)M_SQRT3;
+
+  /* Pixels get larger with the distance to the view, so use the closest corner. */
+  float w_min = FLT_MAX;
+  for (int i = 0; i < 8; i++) {
+    const float co[3] = {
+        (i & 1) ? bb_max[0] : bb_min[0],
+        (i & 2) ? bb_max[1] : bb_min[1],
+        (i & 4) ? bb_max[2] : bb_min[2],
+    };
+    w_min = min_ff(w_min, dot_v3v3(params->persmat_w, co) + params->persmat_w[3]);
+  }
+
+  /* Nodes crossing the view plane. */
+  if (w_min <= 0.0f) {
+    return false;
+  }
+
+  return error <= params->error_max * params->pixel_size * w_min;
+}
+
 void BKE_pbvh_draw_cb(PBVH *pbvh,
                       bool update_only_visible,
                       PBVHFrustumPlanes *update_frustum,
                       PBVHFrustumPlanes *draw_frustum,
-                      void (*draw_fn)(void *user_data, GPU_PBVH_Buffers *buffers),
+                      const PBVHLodParams *lod_params,
+                      void (*draw_fn)(void *user_data, GPU_PBVH_Buffers *buffers, bool use_lod),
                       void *user_data)
 {
   PBVHNode **nodes;
@@ -2739,10 +3019,15 @@ void BKE_pbvh_draw_cb(PBVH *pbvh,
   PBVHDrawSearchData draw_data = {.frustum = draw_frustum, .accum_update_flag = 0};
   BKE_pbvh_search_gather(pbvh, pbvh_draw_search_cb, &draw_data, &nodes, &totnode);
 
+  /* Only mesh nodes have simplified buffers selected by their error. */
+  const bool use_lod = lod_params && pbvh->type == PBVH_FACES;
+
   for (int i = 0; i < totnode; i++) {
     PBVHNode *node = nodes[i];
     if (!(node->flag & PBVH_FullyHidden)) {
-      draw_fn(user_data, node->draw_buffers);
+      draw_fn(user_data,
+              node->draw_buffers,
+              use_lod && BKE_pbvh_lod_use(node->vb.bmin, node->vb.bmax, lod_params));
     }
   }
 
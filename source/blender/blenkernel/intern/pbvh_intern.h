@@ -151,13 +151,17 @@ struct PBVH {
   BLI_bitmap **grid_hidden;
 
   /* Only used during BVH build and update,
-   * don't need to remain valid after */
-  BLI_bitmap *vert_bitmap;
+   * don't need to remain valid after.
+   * For each vertex, the first leaf in build order using it. */
+  int *vert_owner;
 
 #ifdef PERFCNTRS
   int perf_modified;
 #endif
 
+  /* Time spent updating normals since it was last taken, with `--debug-sculpt-time`. */
+  double normals_update_time;
+
   /* flag are verts/faces deformed */
   bool deformed;
   bool show_mask;
@@ -0,0 +1,90 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 by Blender Foundation.
+ */
+
+#include "testing/testing.h"
+
+#include "BKE_pbvh.h"
+
+namespace blender::bke::tests {
+
+/* Node of size 1, which has an error of 1 / PBVH_LOD_GRID_RES * sqrt(3), about 0.108. */
+static const float node_min[3] = {0.0f, 0.0f, 0.0f};
+static const float node_max[3] = {1.0f, 1.0f, 1.0f};
+
+static PBVHLodParams lod_params_ortho(const float pixel_size)
+{
+  PBVHLodParams params = {{0.0f, 0.0f, 0.0f, 1.0f}, pixel_size, 1.0f};
+  return params;
+}
+
+/* View looking down the negative Z axis from the origin, with W the distance to it. */
+static PBVHLodParams lod_params_persp(const float pixel_size)
+{
+  PBVHLodParams params = {{0.0f, 0.0f, -1.0f, 0.0f}, pixel_size, 1.0f};
+  return params;
+}
+
+TEST(pbvh_lod, ortho)
+{
+  PBVHLodParams params = lod_params_ortho(0.01f);
+  EXPECT_FALSE(BKE_pbvh_lod_use(node_min, node_max, &params));
+
+  params = lod_params_ortho(0.2f);
+  EXPECT_TRUE(BKE_pbvh_lod_use(node_min, node_max, &params));
+}
+
+TEST(pbvh_lod, error_max)
+{
+  PBVHLodParams params = lod_params_ortho(0.01f);
+  params.error_max = 20.0f;
+  EXPECT_TRUE(BKE_pbvh_lod_use(node_min, node_max, &params));
+
+  params.error_max = 5.0f;
+  EXPECT_FALSE(BKE_pbvh_lod_use(node_min, node_max, &params));
+}
+
+TEST(pbvh_lod, persp_distance)
+{
+  const PBVHLodParams params = lod_params_persp(0.001f);
+
+  /* Pixels at a distance of 99 have a size of 0.099. */
+  const float near_min[3] = {0.0f, 0.0f, -100.0f};
+  const float near_max[3] = {1.0f, 1.0f, -99.0f};
+  EXPECT_FALSE(BKE_pbvh_lod_use(near_min, near_max, &params));
+
+  /* Pixels at a distance of 199 have a size of 0.199. */
+  const float far_min[3] = {0.0f, 0.0f, -200.0f};
+  const float far_max[3] = {1.0f, 1.0f, -199.0f};
+  EXPECT_TRUE(BKE_pbvh_lod_use(far_min, far_max, &params));
+}
+
+TEST(pbvh_lod, persp_behind_view)
+{
+  const PBVHLodParams params = lod_params_persp(1.0f);
+
+  /* Nodes crossing or behind the view plane are always drawn at full resolution. */
+  const float crossing_min[3] = {0.0f, 0.0f, -0.5f};
+  const float crossing_max[3] = {1.0f, 1.0f, 0.5f};
+  EXPECT_FALSE(BKE_pbvh_lod_use(crossing_min, crossing_max, &params));
+
+  const float behind_min[3] = {0.0f, 0.0f, 10.0f};
+  const float behind_max[3] = {1.0f, 1.0f, 11.0f};
+  EXPECT_FALSE(BKE_pbvh_lod_use(behind_min, behind_max, &params));
+}
+
+}  // namespace blender::bke::tests
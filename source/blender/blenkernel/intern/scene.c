@@ -2712,8 +2712,9 @@ void BKE_scene_graph_evaluated_ensure(Depsgraph *depsgraph, Main *bmain)
   scene_graph_update_tagged(depsgraph, bmain, true);
 }
 
-/* applies changes right away, does all sets too */
-void BKE_scene_graph_update_for_newframe_ex(Depsgraph *depsgraph, const bool clear_recalc)
+static void scene_graph_update_for_newframe(Depsgraph *depsgraph,
+                                            const bool clear_recalc,
+                                            const bool is_frame_evaluated)
 {
   Scene *scene = DEG_get_input_scene(depsgraph);
   Main *bmain = DEG_get_bmain(depsgraph);
@@ -2735,7 +2736,7 @@ void BKE_scene_graph_update_for_newframe_ex(Depsgraph *depsgraph, const bool cle
      * NOTE: Only update for new frame on first iteration. Second iteration is for ensuring user
      * edits from callback are properly taken into account. Doing a time update on those would
      * lose any possible unkeyed changes made by the handler. */
-    if (pass == 0) {
+    if (pass == 0 && !is_frame_evaluated) {
       const float ctime = BKE_scene_frame_get(scene);
       DEG_evaluate_on_framechange(depsgraph, ctime);
     }
@@ -2783,6 +2784,21 @@ void BKE_scene_graph_update_for_newframe_ex(Depsgraph *depsgraph, const bool cle
   }
 }
 
+/* applies changes right away, does all sets too */
+void BKE_scene_graph_update_for_newframe_ex(Depsgraph *depsgraph, const bool clear_recalc)
+{
+  scene_graph_update_for_newframe(depsgraph, clear_recalc, false);
+}
+
+/* Same as above, for a dependency graph which was already evaluated at the current frame of its
+ * scene, for example ahead of time in another thread. Only changes done by the frame change
+ * handlers are evaluated. */
+void BKE_scene_graph_update_for_evaluated_newframe(Depsgraph *depsgraph, const bool clear_recalc)
+{
+  BLI_assert(DEG_get_ctime(depsgraph) == BKE_scene_frame_get(DEG_get_input_scene(depsgraph)));
+  scene_graph_update_for_newframe(depsgraph, clear_recalc, true);
+}
+
 void BKE_scene_graph_update_for_newframe(Depsgraph *depsgraph)
 {
   BKE_scene_graph_update_for_newframe_ex(depsgraph, true);
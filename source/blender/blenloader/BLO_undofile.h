@@ -57,6 +57,10 @@ typedef struct MemFileWriteData {
 
   /** Maps an ID session uuid to its first reference MemFileChunk, if existing. */
   struct GHash *id_session_uuid_mapping;
+
+  /** Reuse the reference chunks of IDs that were not tagged for update since the reference
+   * step, instead of writing them again. */
+  bool use_unchanged_id_chunks;
 } MemFileWriteData;
 
 typedef struct MemFileUndoData {
@@ -73,6 +77,9 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
 void BLO_memfile_write_finalize(MemFileWriteData *mem_data);
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size);
+bool BLO_memfile_chunks_reuse_id(MemFileWriteData *mem_data,
+                                 const void *id_address,
+                                 uint id_session_uuid);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
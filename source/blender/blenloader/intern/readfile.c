@@ -72,6 +72,7 @@
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_mmap.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "PIL_time.h"
@@ -190,6 +191,15 @@
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+/**
+ * Read the direct data of data-blocks which only reference their own data (meshes, images, ...)
+ * in parallel, after all data-block structs of the file have been read.
+ *
+ * \note This is only done for memory-mapped files and undo memfiles, where any thread can read
+ * data without moving a shared file position.
+ */
+#define USE_PARALLEL_DIRECT_LINK
+
 static CLG_LogRef LOG = {"blo.readfile"};
 static CLG_LogRef LOG_UNDO = {"blo.readfile.undo"};
 
@@ -1184,6 +1194,338 @@ static ssize_t fd_read_gzip_from_file(FileData *filedata,
   return readsize;
 }
 
+/* Frame based GZip file reading.
+ *
+ * Frames are located from their header without decompressing them, then decompressed in
+ * parallel ahead of sequential reading. Any frame can be decompressed on its own, so seeking is
+ * supported as well. */
+
+typedef enum eZlibFrameState {
+  ZLIB_FRAME_NONE = 0,
+  ZLIB_FRAME_PENDING,
+  ZLIB_FRAME_DONE,
+} eZlibFrameState;
+
+typedef struct ZlibFrame {
+  size_t member_offset;
+  size_t member_len;
+  off64_t data_offset;
+  size_t data_len;
+
+  /** Decompressed data, NULL when not decompressed or when decompression failed. */
+  char *data;
+  /** Protected by #ZlibFrameReader.mutex. */
+  eZlibFrameState state;
+} ZlibFrame;
+
+typedef struct ZlibFrameReader {
+  BLI_mmap_file *mmap_file;
+
+  ZlibFrame *frames;
+  int frames_len;
+  /** Frame read last, to detect sequential reading. */
+  int frame_current;
+  /**
+   * Frame read last before seeking to #frame_current. Reading data on demand seeks to a block
+   * and back, so frames around this position are kept decompressed as well.
+   */
+  int frame_previous;
+  /** Number of frames decompressed ahead of sequential reading. */
+  int read_ahead;
+
+  TaskPool *task_pool;
+  ThreadMutex mutex;
+  ThreadCondition done_condition;
+} ZlibFrameReader;
+
+static uint32_t zlib_read_uint32_le(const uchar *src)
+{
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) |
+         ((uint32_t)src[3] << 24);
+}
+
+static void zlib_frame_decompress_task(TaskPool *__restrict pool, void *taskdata)
+{
+  ZlibFrameReader *reader = BLI_task_pool_user_data(pool);
+  ZlibFrame *frame = taskdata;
+
+  uchar *member = MEM_mallocN(frame->member_len, __func__);
+  char *data = MEM_mallocN(MAX2(frame->data_len, 1), __func__);
+
+  bool ok = BLI_mmap_read(reader->mmap_file, member, frame->member_offset, frame->member_len);
+  if (ok) {
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    ok = (inflateInit2(&strm, -MAX_WBITS) == Z_OK);
+    if (ok) {
+      strm.next_in = member + BLEND_GZIP_FRAME_HEADER_SIZE;
+      strm.avail_in = (uInt)(frame->member_len - BLEND_GZIP_FRAME_HEADER_SIZE -
+                             BLEND_GZIP_FRAME_TRAILER_SIZE);
+      strm.next_out = (Bytef *)data;
+      strm.avail_out = (uInt)frame->data_len;
+      ok = (inflate(&strm, Z_FINISH) == Z_STREAM_END) && (strm.total_out == frame->data_len);
+      inflateEnd(&strm);
+    }
+  }
+  if (ok) {
+    const uchar *trailer = member + frame->member_len - BLEND_GZIP_FRAME_TRAILER_SIZE;
+    ok = (zlib_read_uint32_le(trailer) == crc32(0, (Bytef *)data, (uInt)frame->data_len));
+  }
+
+  MEM_freeN(member);
+  if (!ok) {
+    CLOG_ERROR(&LOG, "Failed to decompress frame at offset %zu", frame->member_offset);
+    MEM_freeN(data);
+    data = NULL;
+  }
+
+  BLI_mutex_lock(&reader->mutex);
+  frame->data = data;
+  frame->state = ZLIB_FRAME_DONE;
+  BLI_condition_notify_all(&reader->done_condition);
+  BLI_mutex_unlock(&reader->mutex);
+}
+
+/**
+ * Find all frames of a compressed file.
+ * \return NULL when the file is not written in frames, which is the case for older files.
+ */
+static ZlibFrameReader *zlib_frame_reader_open(int file)
+{
+  const off64_t file_len = BLI_lseek(file, 0, SEEK_END);
+  BLI_mmap_file *mmap_file = BLI_mmap_open(file);
+  BLI_lseek(file, 0, SEEK_SET);
+  if (mmap_file == NULL) {
+    return NULL;
+  }
+
+  ZlibFrame *frames = NULL;
+  int frames_len = 0;
+  int frames_len_alloc = 0;
+  size_t member_offset = 0;
+  off64_t data_offset = 0;
+  bool ok = true;
+
+  while (member_offset < (size_t)file_len) {
+    uchar header[BLEND_GZIP_FRAME_HEADER_SIZE];
+    uchar trailer[BLEND_GZIP_FRAME_TRAILER_SIZE];
+
+    if (!BLI_mmap_read(mmap_file, header, member_offset, sizeof(header)) ||
+        !(header[0] == 0x1f && header[1] == 0x8b && header[2] == 8 && header[3] == 0x04 &&
+          header[10] == 8 && header[11] == 0 && header[12] == BLEND_GZIP_FRAME_EXTRA_ID_1 &&
+          header[13] == BLEND_GZIP_FRAME_EXTRA_ID_2 && header[14] == 4 && header[15] == 0)) {
+      ok = false;
+      break;
+    }
+
+    const size_t member_len = zlib_read_uint32_le(&header[16]);
+    if (member_len < BLEND_GZIP_FRAME_HEADER_SIZE + BLEND_GZIP_FRAME_TRAILER_SIZE ||
+        member_offset + member_len > (size_t)file_len ||
+        !BLI_mmap_read(mmap_file,
+                       trailer,
+                       member_offset + member_len - BLEND_GZIP_FRAME_TRAILER_SIZE,
+                       sizeof(trailer))) {
+      ok = false;
+      break;
+    }
+
+    if (frames_len == frames_len_alloc) {
+      frames_len_alloc = MAX2(64, frames_len_alloc * 2);
+      frames = MEM_recallocN(frames, sizeof(ZlibFrame) * (size_t)frames_len_alloc);
+    }
+
+    ZlibFrame *frame = &frames[frames_len++];
+    frame->member_offset = member_offset;
+    frame->member_len = member_len;
+    frame->data_offset = data_offset;
+    frame->data_len = zlib_read_uint32_le(&trailer[4]);
+
+    member_offset += member_len;
+    data_offset += (off64_t)frame->data_len;
+  }
+
+  if (!ok || frames_len == 0) {
+    MEM_SAFE_FREE(frames);
+    BLI_mmap_free(mmap_file);
+    return NULL;
+  }
+
+  ZlibFrameReader *reader = MEM_callocN(sizeof(ZlibFrameReader), __func__);
+  reader->mmap_file = mmap_file;
+  reader->frames = frames;
+  reader->frames_len = frames_len;
+  reader->frame_current = -1;
+  reader->frame_previous = -1;
+  reader->read_ahead = BLI_system_thread_count();
+  reader->task_pool = BLI_task_pool_create(reader, TASK_PRIORITY_HIGH);
+  BLI_mutex_init(&reader->mutex);
+  BLI_condition_init(&reader->done_condition);
+
+  return reader;
+}
+
+static void zlib_frame_reader_free(ZlibFrameReader *reader)
+{
+  BLI_task_pool_work_and_wait(reader->task_pool);
+  BLI_task_pool_free(reader->task_pool);
+  BLI_mutex_end(&reader->mutex);
+  BLI_condition_end(&reader->done_condition);
+
+  for (int i = 0; i < reader->frames_len; i++) {
+    MEM_SAFE_FREE(reader->frames[i].data);
+  }
+  MEM_freeN(reader->frames);
+  BLI_mmap_free(reader->mmap_file);
+  MEM_freeN(reader);
+}
+
+static off64_t zlib_frame_reader_data_len(const ZlibFrameReader *reader)
+{
+  const ZlibFrame *frame_last = &reader->frames[reader->frames_len - 1];
+  return frame_last->data_offset + (off64_t)frame_last->data_len;
+}
+
+static int zlib_frame_reader_find(const ZlibFrameReader *reader, const off64_t offset)
+{
+  /* Fast path for sequential reading. */
+  const int sequential_last = MIN2(reader->frame_current + 2, reader->frames_len);
+  for (int i = MAX2(reader->frame_current, 0); i < sequential_last; i++) {
+    const ZlibFrame *frame = &reader->frames[i];
+    if (offset >= frame->data_offset && offset < frame->data_offset + (off64_t)frame->data_len) {
+      return i;
+    }
+  }
+
+  int first = 0;
+  int last = reader->frames_len - 1;
+  while (first < last) {
+    const int middle = (first + last + 1) / 2;
+    if (reader->frames[middle].data_offset <= offset) {
+      first = middle;
+    }
+    else {
+      last = middle - 1;
+    }
+  }
+  return first;
+}
+
+/** Whether a frame is needed when reading at \a frame_index, with frames decompressed ahead. */
+static bool zlib_frame_reader_keep(const ZlibFrameReader *reader,
+                                   const int frame_index,
+                                   const int i)
+{
+  return (frame_index != -1) && (i >= frame_index - 1) && (i <= frame_index + reader->read_ahead);
+}
+
+/**
+ * Get decompressed data of a frame, scheduling decompression of the following frames when
+ * reading sequentially, and freeing frames which are not needed anymore.
+ *
+ * Frames around the current and the previous read position are kept, so seeking to a block and
+ * back does not decompress any frame again.
+ */
+static const char *zlib_frame_reader_ensure(ZlibFrameReader *reader, const int frame_index)
+{
+  BLI_mutex_lock(&reader->mutex);
+
+  if (frame_index != reader->frame_current) {
+    /* Continue from the previous position when seeking back to it. */
+    if (frame_index == reader->frame_previous || frame_index == reader->frame_previous + 1) {
+      SWAP(int, reader->frame_current, reader->frame_previous);
+    }
+    const bool is_sequential = (frame_index == reader->frame_current + 1);
+    if (!is_sequential && frame_index != reader->frame_current) {
+      reader->frame_previous = reader->frame_current;
+    }
+    reader->frame_current = frame_index;
+
+    const int decompress_last = MIN2(frame_index + (is_sequential ? reader->read_ahead : 0),
+                                     reader->frames_len - 1);
+
+    for (int i = 0; i < reader->frames_len; i++) {
+      ZlibFrame *frame = &reader->frames[i];
+      if (i >= frame_index && i <= decompress_last) {
+        if (frame->state == ZLIB_FRAME_NONE) {
+          frame->state = ZLIB_FRAME_PENDING;
+          BLI_mutex_unlock(&reader->mutex);
+          BLI_task_pool_push(reader->task_pool, zlib_frame_decompress_task, frame, false, NULL);
+          BLI_mutex_lock(&reader->mutex);
+        }
+      }
+      else if (frame->state == ZLIB_FRAME_DONE &&
+               !zlib_frame_reader_keep(reader, reader->frame_current, i) &&
+               !zlib_frame_reader_keep(reader, reader->frame_previous, i)) {
+        MEM_SAFE_FREE(frame->data);
+        frame->state = ZLIB_FRAME_NONE;
+      }
+    }
+  }
+
+  ZlibFrame *frame = &reader->frames[frame_index];
+  while (frame->state != ZLIB_FRAME_DONE) {
+    BLI_condition_wait(&reader->done_condition, &reader->mutex);
+  }
+  const char *data = frame->data;
+
+  BLI_mutex_unlock(&reader->mutex);
+
+  return data;
+}
+
+static ssize_t fd_read_gzip_frames_from_file(FileData *filedata,
+                                             void *buffer,
+                                             size_t size,
+                                             bool *UNUSED(r_is_memchunck_identical))
+{
+  ZlibFrameReader *reader = filedata->zlib_frame_reader;
+  const off64_t data_len = zlib_frame_reader_data_len(reader);
+  size_t totread = 0;
+
+  while (totread < size && filedata->file_offset < data_len) {
+    const int frame_index = zlib_frame_reader_find(reader, filedata->file_offset);
+    const ZlibFrame *frame = &reader->frames[frame_index];
+    const char *data = zlib_frame_reader_ensure(reader, frame_index);
+    if (data == NULL) {
+      return EOF;
+    }
+
+    const size_t frame_offset = (size_t)(filedata->file_offset - frame->data_offset);
+    const size_t readsize = MIN2(size - totread, frame->data_len - frame_offset);
+    memcpy((char *)buffer + totread, data + frame_offset, readsize);
+
+    totread += readsize;
+    filedata->file_offset += (off64_t)readsize;
+  }
+
+  return (ssize_t)totread;
+}
+
+static off64_t fd_seek_gzip_frames_from_file(FileData *filedata, off64_t offset, int whence)
+{
+  const off64_t data_len = zlib_frame_reader_data_len(filedata->zlib_frame_reader);
+  off64_t new_pos;
+  if (whence == SEEK_CUR) {
+    new_pos = filedata->file_offset + offset;
+  }
+  else if (whence == SEEK_SET) {
+    new_pos = offset;
+  }
+  else if (whence == SEEK_END) {
+    new_pos = data_len + offset;
+  }
+  else {
+    return -1;
+  }
+
+  if (new_pos < 0 || new_pos > data_len) {
+    return -1;
+  }
+
+  filedata->file_offset = new_pos;
+  return filedata->file_offset;
+}
+
 /* Memory reading. */
 
 static ssize_t fd_read_from_memory(FileData *filedata,
@@ -1382,6 +1724,7 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   BLI_mmap_file *mmap_file = NULL;
 
   gzFile gzfile = (gzFile)Z_NULL;
+  ZlibFrameReader *zlib_frame_reader = NULL;
 
   char header[7];
 
@@ -1411,8 +1754,17 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   BLI_lseek(file, 0, SEEK_SET);
 
-  /* Gzip file. */
+  /* Gzip file written in frames, or any other gzip file. */
   errno = 0;
+  if ((read_fn == NULL) &&
+      /* Check header magic. */
+      (header[0] == 0x1f && header[1] == 0x8b)) {
+    zlib_frame_reader = zlib_frame_reader_open(file);
+    if (zlib_frame_reader != NULL) {
+      read_fn = fd_read_gzip_frames_from_file;
+      seek_fn = fd_seek_gzip_frames_from_file;
+    }
+  }
   if ((read_fn == NULL) &&
       /* Check header magic. */
       (header[0] == 0x1f && header[1] == 0x8b)) {
@@ -1441,6 +1793,7 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   fd->filedes = file;
   fd->gzfiledes = gzfile;
+  fd->zlib_frame_reader = zlib_frame_reader;
 
   fd->read = read_fn;
   fd->seek = seek_fn;
@@ -1505,25 +1858,32 @@ static ssize_t fd_read_gzip_from_memory(FileData *filedata,
                                         size_t size,
                                         bool *UNUSED(r_is_memchunck_identical))
 {
-  int err;
-
   filedata->strm.next_out = (Bytef *)buffer;
   filedata->strm.avail_out = (uint)size;
 
-  /* Inflate another chunk. */
-  err = inflate(&filedata->strm, Z_SYNC_FLUSH);
+  while (filedata->strm.avail_out != 0) {
+    /* Inflate another chunk. */
+    const int err = inflate(&filedata->strm, Z_SYNC_FLUSH);
 
-  if (err == Z_STREAM_END) {
-    return 0;
-  }
-  if (err != Z_OK) {
-    CLOG_ERROR(&LOG, "ZLib error (code %d)", err);
-    return 0;
+    if (err == Z_STREAM_END) {
+      /* Compressed files are written as multiple gzip members, continue with the next one. */
+      if (filedata->strm.avail_in == 0 || inflateReset(&filedata->strm) != Z_OK) {
+        break;
+      }
+    }
+    else if (err != Z_OK) {
+      CLOG_ERROR(&LOG, "ZLib error (code %d)", err);
+      return 0;
+    }
+    else if (filedata->strm.avail_in == 0) {
+      break;
+    }
   }
 
-  filedata->file_offset += size;
+  const size_t readsize = size - filedata->strm.avail_out;
+  filedata->file_offset += (off64_t)readsize;
 
-  return (ssize_t)size;
+  return (ssize_t)readsize;
 }
 
 static int fd_read_gzip_from_memory_init(FileData *fd)
@@ -1604,6 +1964,10 @@ void blo_filedata_free(FileData *fd)
       gzclose(fd->gzfiledes);
     }
 
+    if (fd->zlib_frame_reader != NULL) {
+      zlib_frame_reader_free(fd->zlib_frame_reader);
+    }
+
     if (fd->strm.next_in) {
       int err = inflateEnd(&fd->strm);
       if (err != Z_OK) {
@@ -3548,7 +3912,10 @@ static void read_libblock_undo_restore_at_old_address(FileData *fd, Main *main,
   ListBase *old_lb = which_libbase(old_bmain, idcode);
   ListBase *new_lb = which_libbase(main, idcode);
   BLI_remlink(old_lb, id_old);
-  BLI_remlink(new_lb, id);
+  /* Keep the position of the read ID, other IDs may have been read after it already. */
+  BLI_insertlinkreplace(new_lb, id, id_old);
+  void *id_old_next = id_old->next;
+  void *id_old_prev = id_old->prev;
 
   /* We do not need any remapping from this call here, since no ID pointer is valid in the data
    * currently (they are all pointing to old addresses, and need to go through `lib_link`
@@ -3560,7 +3927,8 @@ static void read_libblock_undo_restore_at_old_address(FileData *fd, Main *main,
    * #Scene. */
   id_old->orig_id = id;
 
-  BLI_addtail(new_lb, id_old);
+  id_old->next = id_old_next;
+  id_old->prev = id_old_prev;
   BLI_addtail(old_lb, id);
 }
 
@@ -3644,6 +4012,143 @@ static bool read_libblock_undo_restore(
   return false;
 }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+
+typedef struct DirectLinkTask {
+  BHead *bhead;
+  Main *main;
+  ID *id;
+  /** Existing ID the data is restored into for undo, see
+   * #read_libblock_undo_restore_at_old_address. */
+  ID *id_old;
+  int tag;
+  bool success;
+  bool file_ok;
+} DirectLinkTask;
+
+typedef struct DirectLinkTaskList {
+  DirectLinkTask *tasks;
+  int tasks_len;
+  int tasks_alloc;
+} DirectLinkTaskList;
+
+static void direct_link_tasks_begin(FileData *fd)
+{
+  BLI_assert(fd->direct_link_tasks == NULL);
+
+  /* Memfiles are entirely in memory and their blocks are read along with the block headers,
+   * other streams than memory-mapped files can't be read from several threads. */
+  if ((fd->mmap_file == NULL && fd->memfile == NULL) || BLI_system_thread_count() < 2) {
+    return;
+  }
+  if (fd->skip_flags & BLO_READ_SKIP_DATA) {
+    return;
+  }
+
+  fd->direct_link_tasks = MEM_callocN(sizeof(DirectLinkTaskList), __func__);
+}
+
+/* Only data-block types which direct data reading code doesn't access anything outside of the
+ * data-block itself and the #FileData it is read from can be read in parallel. */
+static bool direct_link_task_supported(const short idcode)
+{
+  return ELEM(idcode,
+              ID_ME,
+              ID_CU,
+              ID_MB,
+              ID_LT,
+              ID_AC,
+              ID_IM,
+              ID_PT,
+              ID_VF,
+              ID_TXT,
+              ID_SO);
+}
+
+static BHead *direct_link_task_add(
+    FileData *fd, Main *main, BHead *bhead, ID *id, ID *id_old, const int tag)
+{
+  DirectLinkTaskList *task_list = fd->direct_link_tasks;
+  if (task_list->tasks_len == task_list->tasks_alloc) {
+    task_list->tasks_alloc = max_ii(64, task_list->tasks_alloc * 2);
+    task_list->tasks = MEM_reallocN(task_list->tasks,
+                                    sizeof(*task_list->tasks) * (size_t)task_list->tasks_alloc);
+  }
+
+  DirectLinkTask *task = &task_list->tasks[task_list->tasks_len++];
+  task->bhead = bhead;
+  task->main = main;
+  task->id = id;
+  task->id_old = id_old;
+  task->tag = tag;
+  task->success = false;
+  task->file_ok = true;
+
+  /* Skip the data blocks, this also ensures all of them are in #FileData.bhead_list, so the
+   * tasks can walk over them without reading new block headers. */
+  bhead = blo_bhead_next(fd, bhead);
+  while (bhead && bhead->code == DATA) {
+    bhead = blo_bhead_next(fd, bhead);
+  }
+  return bhead;
+}
+
+static void direct_link_task_run(void *__restrict userdata,
+                                 const int index,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  FileData *fd = userdata;
+  DirectLinkTask *task = &fd->direct_link_tasks->tasks[index];
+
+  /* Each task reads through its own copy of the file data, with its own file position and map of
+   * the data read for the data-block. The rest of it is only read from. */
+  FileData task_fd = *fd;
+  task_fd.datamap = oldnewmap_new();
+  task_fd.direct_link_tasks = NULL;
+
+  read_data_into_datamap(&task_fd, task->bhead, dataname(GS(task->id->name)));
+  task->success = direct_link_id(&task_fd, task->main, task->tag, task->id, task->id_old);
+  task->file_ok = (task_fd.flags & FD_FLAGS_FILE_OK) != 0;
+
+  /* Free data that was read but not used by the data-block. */
+  oldnewmap_clear(task_fd.datamap);
+  oldnewmap_free(task_fd.datamap);
+}
+
+static void direct_link_tasks_end(FileData *fd)
+{
+  DirectLinkTaskList *task_list = fd->direct_link_tasks;
+  if (task_list == NULL) {
+    return;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, task_list->tasks_len, fd, direct_link_task_run, &settings);
+
+  /* Freeing data-blocks and restoring them for undo modifies Main, so it is done afterwards, in
+   * the order they were read. */
+  for (int i = 0; i < task_list->tasks_len; i++) {
+    DirectLinkTask *task = &task_list->tasks[i];
+    if (!task->file_ok) {
+      fd->flags &= ~FD_FLAGS_FILE_OK;
+    }
+    if (!task->success) {
+      BKE_id_free(task->main, task->id);
+    }
+    else if (task->id_old != NULL) {
+      read_libblock_undo_restore_at_old_address(fd, task->main, task->id, task->id_old);
+    }
+  }
+
+  MEM_SAFE_FREE(task_list->tasks);
+  MEM_freeN(task_list);
+  fd->direct_link_tasks = NULL;
+}
+
+#endif /* USE_PARALLEL_DIRECT_LINK */
+
 /* This routine reads a datablock and its direct data, and advances bhead to
  * the next datablock. For library linked datablocks, only a placeholder will
  * be generated, to be replaced in read_library_linked_ids.
@@ -3728,6 +4233,12 @@ static BHead *read_libblock(FileData *fd,
     return blo_bhead_next(fd, bhead);
   }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+  if (fd->direct_link_tasks != NULL && direct_link_task_supported(idcode)) {
+    return direct_link_task_add(fd, main, bhead, id, id_old, id_tag);
+  }
+#endif
+
   /* Read datablock contents.
    * Use convenient malloc name for debugging and better memory link prints. */
   const char *allocname = dataname(idcode);
@@ -4171,6 +4682,10 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     }
   }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+  direct_link_tasks_begin(fd);
+#endif
+
   while (bhead) {
     switch (bhead->code) {
       case DATA:
@@ -4222,6 +4737,10 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     }
   }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+  direct_link_tasks_end(fd);
+#endif
+
   /* do before read_libraries, but skip undo case */
   if (fd->memfile == NULL) {
     if ((fd->skip_flags & BLO_READ_SKIP_DATA) == 0) {
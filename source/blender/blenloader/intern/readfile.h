@@ -42,6 +42,8 @@ struct Object;
 struct OldNewMap;
 struct ReportList;
 struct UserDef;
+struct DirectLinkTaskList;
+struct ZlibFrameReader;
 
 typedef struct IDNameLib_Map IDNameLib_Map;
 
@@ -55,6 +57,16 @@ enum eFileDataFlag {
   FD_FLAGS_NOT_MY_LIBMAP = 1 << 5,
 };
 
+/* Compressed files are written as a sequence of independent gzip members, called frames, which
+ * can be compressed and decompressed in parallel. Concatenated gzip members are a regular gzip
+ * stream, so such files can also be read as a whole. Each frame header has an extra field with
+ * the size of the entire member, which allows to find frames without decompressing them. */
+#define BLEND_GZIP_FRAME_SIZE (1 << 20)
+#define BLEND_GZIP_FRAME_HEADER_SIZE 20
+#define BLEND_GZIP_FRAME_TRAILER_SIZE 8
+#define BLEND_GZIP_FRAME_EXTRA_ID_1 'B'
+#define BLEND_GZIP_FRAME_EXTRA_ID_2 'F'
+
 /* Disallow since it's 32bit on ms-windows. */
 #ifdef __GNUC__
 #  pragma GCC poison off_t
@@ -95,6 +107,8 @@ typedef struct FileData {
 
   /** Variables needed for reading from file. */
   gzFile gzfiledes;
+  /** Reading from compressed files written in frames. */
+  struct ZlibFrameReader *zlib_frame_reader;
   /** Gzip stream for memory decompression. */
   z_stream strm;
 
@@ -133,6 +147,9 @@ typedef struct FileData {
   struct OldNewMap *libmap;
   struct OldNewMap *packedmap;
   struct BLOCacheStorage *cache_storage;
+  /** Data-blocks whose direct data is read in parallel once all blocks have been read, see
+   * #USE_PARALLEL_DIRECT_LINK. */
+  struct DirectLinkTaskList *direct_link_tasks;
 
   struct BHeadSort *bheadmap;
   int tot_bheadmap;
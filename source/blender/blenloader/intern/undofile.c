@@ -39,6 +39,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
+#include "DNA_sdna_types.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
@@ -192,6 +193,53 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   }
 }
 
+/**
+ * Add the chunks written for an ID in the reference memfile to the written one, sharing their
+ * buffers, instead of writing that ID again.
+ *
+ * \return false when there is no usable reference data for that ID, e.g. when it is new or was
+ * read at another address since, in which case it has to be written as usual.
+ */
+bool BLO_memfile_chunks_reuse_id(MemFileWriteData *mem_data,
+                                 const void *id_address,
+                                 uint id_session_uuid)
+{
+  if (mem_data->id_session_uuid_mapping == NULL) {
+    return false;
+  }
+
+  MemFileChunk *compchunk = BLI_ghash_lookup(mem_data->id_session_uuid_mapping,
+                                             POINTER_FROM_UINT(id_session_uuid));
+  if (compchunk == NULL) {
+    return false;
+  }
+
+  /* The data of an ID always starts in a new chunk, with the block header of the ID itself.
+   * Pointers to the ID stored in other data-blocks only remain valid if its address didn't
+   * change. */
+  const BHead *bhead = (const BHead *)compchunk->buf;
+  if (compchunk->size < sizeof(*bhead) || bhead->old != id_address) {
+    return false;
+  }
+
+  MemFile *memfile = mem_data->written_memfile;
+  for (; compchunk != NULL && compchunk->id_session_uuid == id_session_uuid;
+       compchunk = compchunk->next) {
+    MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
+    curchunk->buf = compchunk->buf;
+    curchunk->size = compchunk->size;
+    curchunk->is_identical = true;
+    curchunk->is_identical_future = true;
+    curchunk->id_session_uuid = id_session_uuid;
+    BLI_addtail(&memfile->chunks, curchunk);
+
+    compchunk->is_identical_future = true;
+  }
+  mem_data->reference_current_chunk = compchunk;
+
+  return true;
+}
+
 struct Main *BLO_memfile_main_get(struct MemFile *memfile,
                                   struct Main *bmain,
                                   struct Scene **r_scene)
@@ -102,6 +102,8 @@
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
 #include "BKE_blender_version.h"
@@ -163,7 +165,7 @@ struct WriteWrap {
   /* internal */
   union {
     int file_handle;
-    gzFile gz_handle;
+    struct ZlibWriter *zlib_writer;
   } _user_data;
 };
 
@@ -193,29 +195,225 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
-#define FILE_HANDLE(ww) (ww)->_user_data.gz_handle
+/* zlib
+ *
+ * Data is collected into frames of #BLEND_GZIP_FRAME_SIZE bytes, which are compressed in
+ * parallel while writing continues, and written to the file in order, see #readfile.h for the
+ * format. */
+#define FILE_HANDLE(ww) (ww)->_user_data.zlib_writer
+
+typedef struct ZlibFrame {
+  struct ZlibFrame *next, *prev;
+
+  char *data;
+  size_t data_len;
+
+  /** Complete gzip member, NULL when compression failed. */
+  uchar *member;
+  size_t member_len;
+  /** Set once compressed, protected by #ZlibWriter.mutex. */
+  bool is_done;
+} ZlibFrame;
+
+typedef struct ZlibWriter {
+  int file_handle;
+  TaskPool *task_pool;
+
+  ThreadMutex mutex;
+  ThreadCondition done_condition;
+  /** Frames pushed for compression, in file order. */
+  ListBase frames;
+  int frames_len;
+
+  /** Frame being filled. */
+  ZlibFrame *frame;
+  bool error;
+} ZlibWriter;
+
+static void zlib_write_uint32_le(uchar *dst, const uint32_t value)
+{
+  dst[0] = (uchar)(value & 0xff);
+  dst[1] = (uchar)((value >> 8) & 0xff);
+  dst[2] = (uchar)((value >> 16) & 0xff);
+  dst[3] = (uchar)((value >> 24) & 0xff);
+}
+
+static void zlib_frame_compress_task(TaskPool *__restrict pool, void *taskdata)
+{
+  ZlibWriter *writer = BLI_task_pool_user_data(pool);
+  ZlibFrame *frame = taskdata;
+
+  const size_t member_len_max = BLEND_GZIP_FRAME_HEADER_SIZE + compressBound(frame->data_len) +
+                                BLEND_GZIP_FRAME_TRAILER_SIZE;
+  uchar *member = MEM_mallocN(member_len_max, __func__);
+  size_t member_len = 0;
+
+  /* Raw deflate stream, header and trailer are written here to store the member size. */
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  bool ok = (deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) ==
+             Z_OK);
+  if (ok) {
+    strm.next_in = (Bytef *)frame->data;
+    strm.avail_in = (uInt)frame->data_len;
+    strm.next_out = member + BLEND_GZIP_FRAME_HEADER_SIZE;
+    strm.avail_out = (uInt)(member_len_max - BLEND_GZIP_FRAME_HEADER_SIZE -
+                            BLEND_GZIP_FRAME_TRAILER_SIZE);
+    ok = (deflate(&strm, Z_FINISH) == Z_STREAM_END);
+    member_len = BLEND_GZIP_FRAME_HEADER_SIZE + strm.total_out + BLEND_GZIP_FRAME_TRAILER_SIZE;
+    deflateEnd(&strm);
+  }
+
+  if (ok) {
+    /* Magic, deflate method, FEXTRA flag, no modification time, unknown OS. */
+    const uchar header[12] = {0x1f, 0x8b, 8, 0x04, 0, 0, 0, 0, 0, 0xff, 8, 0};
+    memcpy(member, header, sizeof(header));
+    /* Extra field: subfield ID, subfield length and the member size. */
+    member[12] = BLEND_GZIP_FRAME_EXTRA_ID_1;
+    member[13] = BLEND_GZIP_FRAME_EXTRA_ID_2;
+    member[14] = 4;
+    member[15] = 0;
+    zlib_write_uint32_le(&member[16], (uint32_t)member_len);
+
+    uchar *trailer = member + member_len - BLEND_GZIP_FRAME_TRAILER_SIZE;
+    zlib_write_uint32_le(&trailer[0], (uint32_t)crc32(0, (Bytef *)frame->data, frame->data_len));
+    zlib_write_uint32_le(&trailer[4], (uint32_t)frame->data_len);
+  }
+  else {
+    MEM_freeN(member);
+    member = NULL;
+  }
+
+  MEM_freeN(frame->data);
+  frame->data = NULL;
+
+  BLI_mutex_lock(&writer->mutex);
+  frame->member = member;
+  frame->member_len = member_len;
+  frame->is_done = true;
+  BLI_condition_notify_all(&writer->done_condition);
+  BLI_mutex_unlock(&writer->mutex);
+}
+
+/**
+ * Write compressed frames to the file in order, waiting for frames still being compressed
+ * until no more than \a max_pending are left.
+ */
+static void zlib_writer_flush(ZlibWriter *writer, const int max_pending)
+{
+  BLI_mutex_lock(&writer->mutex);
+  while (writer->frames.first != NULL) {
+    ZlibFrame *frame = writer->frames.first;
+    if (!frame->is_done) {
+      if (writer->frames_len <= max_pending) {
+        break;
+      }
+      BLI_condition_wait(&writer->done_condition, &writer->mutex);
+      continue;
+    }
+
+    BLI_remlink(&writer->frames, frame);
+    writer->frames_len--;
+    BLI_mutex_unlock(&writer->mutex);
+
+    if (frame->member == NULL ||
+        (size_t)write(writer->file_handle, frame->member, frame->member_len) !=
+            frame->member_len) {
+      writer->error = true;
+    }
+    MEM_SAFE_FREE(frame->member);
+    MEM_freeN(frame);
+
+    BLI_mutex_lock(&writer->mutex);
+  }
+  BLI_mutex_unlock(&writer->mutex);
+}
+
+static void zlib_writer_submit_frame(ZlibWriter *writer)
+{
+  ZlibFrame *frame = writer->frame;
+  writer->frame = NULL;
+
+  BLI_mutex_lock(&writer->mutex);
+  BLI_addtail(&writer->frames, frame);
+  writer->frames_len++;
+  BLI_mutex_unlock(&writer->mutex);
+
+  BLI_task_pool_push(writer->task_pool, zlib_frame_compress_task, frame, false, NULL);
+
+  /* Limit memory used by frames waiting to be written. */
+  zlib_writer_flush(writer, 2 * BLI_system_thread_count());
+}
 
 static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 {
-  gzFile file;
+  int file;
 
-  file = BLI_gzopen(filepath, "wb1");
+  file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
 
-  if (file != Z_NULL) {
-    FILE_HANDLE(ww) = file;
-    return true;
+  if (file == -1) {
+    return false;
   }
 
-  return false;
+  ZlibWriter *writer = MEM_callocN(sizeof(ZlibWriter), __func__);
+  writer->file_handle = file;
+  writer->task_pool = BLI_task_pool_create(writer, TASK_PRIORITY_HIGH);
+  BLI_mutex_init(&writer->mutex);
+  BLI_condition_init(&writer->done_condition);
+
+  FILE_HANDLE(ww) = writer;
+  return true;
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-  return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+  ZlibWriter *writer = FILE_HANDLE(ww);
+
+  if (writer->frame != NULL) {
+    if (writer->frame->data_len != 0) {
+      zlib_writer_submit_frame(writer);
+    }
+    else {
+      MEM_freeN(writer->frame->data);
+      MEM_freeN(writer->frame);
+      writer->frame = NULL;
+    }
+  }
+
+  BLI_task_pool_work_and_wait(writer->task_pool);
+  zlib_writer_flush(writer, 0);
+
+  BLI_task_pool_free(writer->task_pool);
+  BLI_mutex_end(&writer->mutex);
+  BLI_condition_end(&writer->done_condition);
+
+  const bool ok = (close(writer->file_handle) != -1) && !writer->error;
+  MEM_freeN(writer);
+  return ok;
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-  return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+  ZlibWriter *writer = FILE_HANDLE(ww);
+  size_t remaining_len = buf_len;
+
+  while (remaining_len != 0 && !writer->error) {
+    if (writer->frame == NULL) {
+      writer->frame = MEM_callocN(sizeof(ZlibFrame), __func__);
+      writer->frame->data = MEM_mallocN(BLEND_GZIP_FRAME_SIZE, __func__);
+    }
+
+    ZlibFrame *frame = writer->frame;
+    const size_t copy_len = MIN2(remaining_len, BLEND_GZIP_FRAME_SIZE - frame->data_len);
+    memcpy(frame->data + frame->data_len, buf, copy_len);
+    frame->data_len += copy_len;
+    buf += copy_len;
+    remaining_len -= copy_len;
+
+    if (frame->data_len == BLEND_GZIP_FRAME_SIZE) {
+      zlib_writer_submit_frame(writer);
+    }
+  }
+
+  return writer->error ? 0 : buf_len;
 }
 #undef FILE_HANDLE
 
@@ -416,6 +614,7 @@ static WriteData *mywrite_begin(WriteWrap *ww, MemFile *compare, MemFile *curren
 
   if (current != NULL) {
     BLO_memfile_write_init(&wd->mem, current, compare);
+    wd->mem.use_unchanged_id_chunks = USER_EXPERIMENTAL_TEST(&U, use_undo_skip_unchanged);
     wd->use_memfile = true;
   }
 
@@ -989,21 +1188,29 @@ static bool write_file_handle(Main *mainvar,
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
 
+        /* Whether the ID or its embedded IDs were tagged for update since the previous undo
+         * push. */
+        bool is_changed_since_undo_push = false;
+
         if (wd->use_memfile) {
           /* Record the changes that happened up to this undo push in
            * recalc_up_to_undo_push, and clear recalc_after_undo_push again
            * to start accumulating for the next undo push. */
+          is_changed_since_undo_push |= id->recalc_after_undo_push != 0;
           id->recalc_up_to_undo_push = id->recalc_after_undo_push;
           id->recalc_after_undo_push = 0;
 
           bNodeTree *nodetree = ntreeFromID(id);
           if (nodetree != NULL) {
+            is_changed_since_undo_push |= nodetree->id.recalc_after_undo_push != 0;
             nodetree->id.recalc_up_to_undo_push = nodetree->id.recalc_after_undo_push;
             nodetree->id.recalc_after_undo_push = 0;
           }
           if (GS(id->name) == ID_SCE) {
             Scene *scene = (Scene *)id;
             if (scene->master_collection != NULL) {
+              is_changed_since_undo_push |= scene->master_collection->id.recalc_after_undo_push !=
+                                            0;
               scene->master_collection->id.recalc_up_to_undo_push =
                   scene->master_collection->id.recalc_after_undo_push;
               scene->master_collection->id.recalc_after_undo_push = 0;
@@ -1011,6 +1218,15 @@ static bool write_file_handle(Main *mainvar,
           }
         }
 
+        if (wd->use_memfile && wd->mem.use_unchanged_id_chunks && !is_changed_since_undo_push) {
+          /* Unchanged IDs are stored by sharing the data written in the previous undo step,
+           * this avoids serializing them again just to find out they are identical. */
+          BLI_assert(wd->buf_used_len == 0);
+          if (BLO_memfile_chunks_reuse_id(&wd->mem, id, id->session_uuid)) {
+            continue;
+          }
+        }
+
         mywrite_id_begin(wd, id);
 
         memcpy(id_buffer, id, idtype_struct_size);
@@ -0,0 +1,148 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 by Blender Foundation.
+ */
+#include "blendfile_loading_base_test.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "zlib.h"
+
+/* Enough vertices for the mesh data to span several compressed frames. */
+static const int MESH_VERTS_NUM = 200000;
+
+class BlendfileCompressTest : public BlendfileLoadingBaseTest {
+ protected:
+  Main *bmain = nullptr;
+  char filepath[FILE_MAX];
+
+ public:
+  static void SetUpTestCase()
+  {
+    BlendfileLoadingBaseTest::SetUpTestCase();
+    BKE_tempdir_init(nullptr);
+  }
+
+ protected:
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    BLI_path_join(filepath, sizeof(filepath), BKE_tempdir_session(), "compress.blend", NULL);
+
+    Mesh *me = BKE_mesh_add(bmain, "Mesh");
+    me->totvert = MESH_VERTS_NUM;
+    CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, nullptr, me->totvert);
+    BKE_mesh_update_customdata_pointers(me, false);
+    for (int i = 0; i < me->totvert; i++) {
+      /* Not too regular, so frames do not compress to almost nothing. */
+      me->mvert[i].co[0] = (float)i;
+      me->mvert[i].co[1] = (float)((i * 7919) % 1013);
+      me->mvert[i].co[2] = -(float)(i % 97) * 0.5f;
+    }
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain);
+    BLI_delete(filepath, false, false);
+
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  bool blendfile_write(const int write_flags)
+  {
+    BlendFileWriteParams params = {BLO_WRITE_PATH_REMAP_NONE};
+    return BLO_write_file(bmain, filepath, write_flags, &params, nullptr);
+  }
+
+  bool blendfile_read()
+  {
+    BlendFileReadReport bf_reports = {nullptr};
+    bfile = BLO_read_from_file(filepath, BLO_READ_SKIP_NONE, &bf_reports);
+    return bfile != nullptr;
+  }
+
+  void expect_mesh_read()
+  {
+    ASSERT_EQ(BLI_listbase_count(&bfile->main->meshes), 1);
+    const Mesh *me_written = static_cast<const Mesh *>(bmain->meshes.first);
+    const Mesh *me_read = static_cast<const Mesh *>(bfile->main->meshes.first);
+    ASSERT_EQ(me_read->totvert, me_written->totvert);
+    ASSERT_NE(me_read->mvert, nullptr);
+    for (int i = 0; i < me_read->totvert; i++) {
+      ASSERT_EQ(memcmp(me_read->mvert[i].co, me_written->mvert[i].co, sizeof(float[3])), 0)
+          << "Vertex " << i;
+    }
+  }
+};
+
+/* Files are compressed in frames, each a gzip member which can be decompressed on its own. */
+TEST_F(BlendfileCompressTest, frames_round_trip)
+{
+  ASSERT_TRUE(blendfile_write(G_FILE_COMPRESS));
+
+  size_t file_len = 0;
+  uchar *file_data = static_cast<uchar *>(BLI_file_read_binary_as_mem(filepath, 0, &file_len));
+  ASSERT_NE(file_data, nullptr);
+  /* Gzip magic with the extra field storing the member size. */
+  ASSERT_GT(file_len, 20u);
+  EXPECT_EQ(file_data[0], 0x1f);
+  EXPECT_EQ(file_data[1], 0x8b);
+  EXPECT_EQ(file_data[3] & 0x04, 0x04);
+  EXPECT_EQ(file_data[12], 'B');
+  EXPECT_EQ(file_data[13], 'F');
+  const size_t member_len = file_data[16] | (file_data[17] << 8) | (file_data[18] << 16) |
+                            ((size_t)file_data[19] << 24);
+  EXPECT_LT(member_len, file_len) << "File is expected to have more than one frame";
+  MEM_freeN(file_data);
+
+  ASSERT_TRUE(blendfile_read());
+  expect_mesh_read();
+}
+
+/* Files compressed as a single gzip stream, as written by older versions, still load. */
+TEST_F(BlendfileCompressTest, single_stream_legacy)
+{
+  ASSERT_TRUE(blendfile_write(0));
+
+  size_t file_len = 0;
+  void *file_data = BLI_file_read_binary_as_mem(filepath, 0, &file_len);
+  ASSERT_NE(file_data, nullptr);
+  gzFile file = static_cast<gzFile>(BLI_gzopen(filepath, "wb1"));
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(gzwrite(file, file_data, (unsigned int)file_len), (int)file_len);
+  EXPECT_EQ(gzclose(file), Z_OK);
+  MEM_freeN(file_data);
+
+  ASSERT_TRUE(blendfile_read());
+  expect_mesh_read();
+}
@@ -175,6 +175,18 @@ void BlurBaseOperation::updateSize()
   }
 }
 
+/**
+ * Full frame counterpart of #updateSize, the size is read from the first element of the size
+ * input buffer as the socket readers are not available.
+ */
+void BlurBaseOperation::update_size_from_buffer(const MemoryBuffer *size_input)
+{
+  if (!this->m_sizeavailable) {
+    this->m_size = size_input->get_value(0, 0, 0);
+    this->m_sizeavailable = true;
+  }
+}
+
 void BlurBaseOperation::determineResolution(unsigned int resolution[2],
                                             unsigned int preferredResolution[2])
 {
@@ -185,4 +197,26 @@ void BlurBaseOperation::determineResolution(unsigned int resolution[2],
   }
 }
 
+void BlurBaseOperation::get_area_of_interest(const int input_idx,
+                                             const rcti &output_area,
+                                             rcti &r_input_area)
+{
+  if (!get_flags().is_fullframe_operation) {
+    NodeOperation::get_area_of_interest(input_idx, output_area, r_input_area);
+    return;
+  }
+
+  switch (input_idx) {
+    case IMAGE_INPUT_INDEX: {
+      NodeOperation *image_op = getInputOperation(IMAGE_INPUT_INDEX);
+      BLI_rcti_init(&r_input_area, 0, image_op->getWidth(), 0, image_op->getHeight());
+      break;
+    }
+    case SIZE_INPUT_INDEX:
+      /* Only the first element is read, see #update_size_from_buffer. */
+      BLI_rcti_init(&r_input_area, 0, 1, 0, 1);
+      break;
+  }
+}
+
 }  // namespace blender::compositor
@@ -28,7 +28,10 @@
 namespace blender::compositor {
 
 class BlurBaseOperation : public NodeOperation, public QualityStepHelper {
- private:
+ protected:
+  static constexpr int IMAGE_INPUT_INDEX = 0;
+  static constexpr int SIZE_INPUT_INDEX = 1;
+
  protected:
   BlurBaseOperation(DataType data_type);
   float *make_gausstab(float rad, int size);
@@ -38,6 +41,7 @@ class BlurBaseOperation : public NodeOperation, public QualityStepHelper {
   float *make_dist_fac_inverse(float rad, int size, int falloff);
 
   void updateSize();
+  void update_size_from_buffer(const MemoryBuffer *size_input);
 
   /**
    * Cached reference to the inputProgram
@@ -77,6 +81,8 @@ class BlurBaseOperation : public NodeOperation, public QualityStepHelper {
 
   void determineResolution(unsigned int resolution[2],
                            unsigned int preferredResolution[2]) override;
+
+  void get_area_of_interest(int input_idx, const rcti &output_area, rcti &r_input_area) override;
 };
 
 }  // namespace blender::compositor
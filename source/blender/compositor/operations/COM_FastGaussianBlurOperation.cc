@@ -18,15 +18,23 @@
 
 #include <climits>
 
+#include "BLI_array.hh"
+#include "BLI_index_range.hh"
+#include "BLI_math_base.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 #include "COM_FastGaussianBlurOperation.h"
 #include "MEM_guardedalloc.h"
 
 namespace blender::compositor {
 
+/** Number of neighboring columns filtered together by the vertical pass of #IIR_gauss. */
+static constexpr unsigned int IIR_GAUSS_COLUMN_BLOCK_SIZE = 16;
+
 FastGaussianBlurOperation::FastGaussianBlurOperation() : BlurBaseOperation(DataType::Color)
 {
   this->m_iirgaus = nullptr;
+  flags.is_fullframe_operation = true;
 }
 
 void FastGaussianBlurOperation::executePixel(float output[4], int x, int y, void *data)
@@ -77,52 +85,75 @@ void FastGaussianBlurOperation::deinitExecution()
   BlurBaseOperation::deinitMutex();
 }
 
-void *FastGaussianBlurOperation::initializeTileData(rcti *rect)
+void FastGaussianBlurOperation::blur_buffer(MemoryBuffer *buf)
 {
-  lockMutex();
-  if (!this->m_iirgaus) {
-    MemoryBuffer *newBuf = (MemoryBuffer *)this->m_inputProgram->initializeTileData(rect);
-    MemoryBuffer *copy = new MemoryBuffer(*newBuf);
-    updateSize();
-
-    int c;
-    this->m_sx = this->m_data.sizex * this->m_size / 2.0f;
-    this->m_sy = this->m_data.sizey * this->m_size / 2.0f;
+  int c;
+  this->m_sx = this->m_data.sizex * this->m_size / 2.0f;
+  this->m_sy = this->m_data.sizey * this->m_size / 2.0f;
 
-    if ((this->m_sx == this->m_sy) && (this->m_sx > 0.0f)) {
+  if ((this->m_sx == this->m_sy) && (this->m_sx > 0.0f)) {
+    for (c = 0; c < COM_DATA_TYPE_COLOR_CHANNELS; c++) {
+      IIR_gauss(buf, this->m_sx, c, 3);
+    }
+  }
+  else {
+    if (this->m_sx > 0.0f) {
       for (c = 0; c < COM_DATA_TYPE_COLOR_CHANNELS; c++) {
-        IIR_gauss(copy, this->m_sx, c, 3);
+        IIR_gauss(buf, this->m_sx, c, 1);
       }
     }
-    else {
-      if (this->m_sx > 0.0f) {
-        for (c = 0; c < COM_DATA_TYPE_COLOR_CHANNELS; c++) {
-          IIR_gauss(copy, this->m_sx, c, 1);
-        }
-      }
-      if (this->m_sy > 0.0f) {
-        for (c = 0; c < COM_DATA_TYPE_COLOR_CHANNELS; c++) {
-          IIR_gauss(copy, this->m_sy, c, 2);
-        }
+    if (this->m_sy > 0.0f) {
+      for (c = 0; c < COM_DATA_TYPE_COLOR_CHANNELS; c++) {
+        IIR_gauss(buf, this->m_sy, c, 2);
       }
     }
+  }
+}
+
+void *FastGaussianBlurOperation::initializeTileData(rcti *rect)
+{
+  lockMutex();
+  if (!this->m_iirgaus) {
+    MemoryBuffer *newBuf = (MemoryBuffer *)this->m_inputProgram->initializeTileData(rect);
+    MemoryBuffer *copy = new MemoryBuffer(*newBuf);
+    updateSize();
+    blur_buffer(copy);
     this->m_iirgaus = copy;
   }
   unlockMutex();
   return this->m_iirgaus;
 }
 
+void FastGaussianBlurOperation::update_memory_buffer(MemoryBuffer *output,
+                                                     const rcti &area,
+                                                     Span<MemoryBuffer *> inputs)
+{
+  const MemoryBuffer *image = inputs[IMAGE_INPUT_INDEX];
+  if (image->is_a_single_elem()) {
+    /* Blurring a constant gives the same constant. */
+    output->copy_from(image, area);
+    return;
+  }
+
+  /* The recursive filter runs over whole rows and columns, so the full image is blurred once
+   * and each requested area is copied from it. */
+  if (!this->m_iirgaus) {
+    update_size_from_buffer(inputs[SIZE_INPUT_INDEX]);
+    MemoryBuffer *copy = new MemoryBuffer(*image);
+    blur_buffer(copy);
+    this->m_iirgaus = copy;
+  }
+  output->copy_from(this->m_iirgaus, area);
+}
+
 void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src,
                                           float sigma,
                                           unsigned int chan,
                                           unsigned int xy)
 {
-  double q, q2, sc, cf[4], tsM[9], tsu[3], tsv[3];
-  double *X, *Y, *W;
+  double q, q2, sc, cf[4], tsM[9];
   const unsigned int src_width = src->getWidth();
   const unsigned int src_height = src->getHeight();
-  unsigned int x, y, sz;
-  unsigned int i;
   float *buffer = src->getBuffer();
   const uint8_t num_channels = src->get_num_channels();
 
@@ -135,7 +166,7 @@ void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src,
     xy = 3;
   }
 
-  // XXX The YVV macro defined below explicitly expects sources of at least 3x3 pixels,
+  // XXX The YVV function defined below explicitly expects sources of at least 3x3 pixels,
   //     so just skipping blur along faulty direction if src's def is below that limit!
   if (src_width < 3) {
     xy &= ~1;
@@ -186,75 +217,89 @@ void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src,
                  cf[3] * cf[3] * cf[3] - cf[3] * cf[2] + cf[3]);
   tsM[8] = sc * (cf[3] * (cf[1] + cf[3] * cf[2]));
 
-#define YVV(L) \
-  { \
-    W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0]; \
-    W[1] = cf[0] * X[1] + cf[1] * W[0] + cf[2] * X[0] + cf[3] * X[0]; \
-    W[2] = cf[0] * X[2] + cf[1] * W[1] + cf[2] * W[0] + cf[3] * X[0]; \
-    for (i = 3; i < L; i++) { \
-      W[i] = cf[0] * X[i] + cf[1] * W[i - 1] + cf[2] * W[i - 2] + cf[3] * W[i - 3]; \
-    } \
-    tsu[0] = W[L - 1] - X[L - 1]; \
-    tsu[1] = W[L - 2] - X[L - 1]; \
-    tsu[2] = W[L - 3] - X[L - 1]; \
-    tsv[0] = tsM[0] * tsu[0] + tsM[1] * tsu[1] + tsM[2] * tsu[2] + X[L - 1]; \
-    tsv[1] = tsM[3] * tsu[0] + tsM[4] * tsu[1] + tsM[5] * tsu[2] + X[L - 1]; \
-    tsv[2] = tsM[6] * tsu[0] + tsM[7] * tsu[1] + tsM[8] * tsu[2] + X[L - 1]; \
-    Y[L - 1] = cf[0] * W[L - 1] + cf[1] * tsv[0] + cf[2] * tsv[1] + cf[3] * tsv[2]; \
-    Y[L - 2] = cf[0] * W[L - 2] + cf[1] * Y[L - 1] + cf[2] * tsv[0] + cf[3] * tsv[1]; \
-    Y[L - 3] = cf[0] * W[L - 3] + cf[1] * Y[L - 2] + cf[2] * Y[L - 1] + cf[3] * tsv[0]; \
-    /* 'i != UINT_MAX' is really 'i >= 0', but necessary for unsigned int wrapping */ \
-    for (i = L - 4; i != UINT_MAX; i--) { \
-      Y[i] = cf[0] * W[i] + cf[1] * Y[i + 1] + cf[2] * Y[i + 2] + cf[3] * Y[i + 3]; \
-    } \
-  } \
-  (void)0
-
-  // intermediate buffers
-  sz = MAX2(src_width, src_height);
-  X = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss X buf");
-  Y = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss Y buf");
-  W = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss W buf");
+  /* Forward and backward passes over a single line of `L` samples from `X` into `Y`, `W` is
+   * scratch space of the same length. */
+  auto YVV = [&](const double *X, double *W, double *Y, const unsigned int L) {
+    double tsu[3], tsv[3];
+    unsigned int i;
+    W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0];
+    W[1] = cf[0] * X[1] + cf[1] * W[0] + cf[2] * X[0] + cf[3] * X[0];
+    W[2] = cf[0] * X[2] + cf[1] * W[1] + cf[2] * W[0] + cf[3] * X[0];
+    for (i = 3; i < L; i++) {
+      W[i] = cf[0] * X[i] + cf[1] * W[i - 1] + cf[2] * W[i - 2] + cf[3] * W[i - 3];
+    }
+    tsu[0] = W[L - 1] - X[L - 1];
+    tsu[1] = W[L - 2] - X[L - 1];
+    tsu[2] = W[L - 3] - X[L - 1];
+    tsv[0] = tsM[0] * tsu[0] + tsM[1] * tsu[1] + tsM[2] * tsu[2] + X[L - 1];
+    tsv[1] = tsM[3] * tsu[0] + tsM[4] * tsu[1] + tsM[5] * tsu[2] + X[L - 1];
+    tsv[2] = tsM[6] * tsu[0] + tsM[7] * tsu[1] + tsM[8] * tsu[2] + X[L - 1];
+    Y[L - 1] = cf[0] * W[L - 1] + cf[1] * tsv[0] + cf[2] * tsv[1] + cf[3] * tsv[2];
+    Y[L - 2] = cf[0] * W[L - 2] + cf[1] * Y[L - 1] + cf[2] * tsv[0] + cf[3] * tsv[1];
+    Y[L - 3] = cf[0] * W[L - 3] + cf[1] * Y[L - 2] + cf[2] * Y[L - 1] + cf[3] * tsv[0];
+    /* 'i != UINT_MAX' is really 'i >= 0', but necessary for unsigned int wrapping */
+    for (i = L - 4; i != UINT_MAX; i--) {
+      Y[i] = cf[0] * W[i] + cf[1] * Y[i + 1] + cf[2] * Y[i + 2] + cf[3] * Y[i + 3];
+    }
+  };
+
+  /* Lines are independent of each other, so they are filtered in parallel with per task
+   * intermediate buffers. */
   if (xy & 1) {  // H
-    int offset;
-    for (y = 0; y < src_height; y++) {
-      const int yx = y * src_width;
-      offset = yx * num_channels + chan;
-      for (x = 0; x < src_width; x++) {
-        X[x] = buffer[offset];
-        offset += num_channels;
-      }
-      YVV(src_width);
-      offset = yx * num_channels + chan;
-      for (x = 0; x < src_width; x++) {
-        buffer[offset] = Y[x];
-        offset += num_channels;
+    threading::parallel_for(IndexRange(src_height), 16, [&](const IndexRange rows) {
+      Array<double> X(src_width), Y(src_width), W(src_width);
+      for (const int64_t y : rows) {
+        const size_t yx = (size_t)y * src_width;
+        size_t offset = yx * num_channels + chan;
+        for (unsigned int x = 0; x < src_width; x++) {
+          X[x] = buffer[offset];
+          offset += num_channels;
+        }
+        YVV(X.data(), W.data(), Y.data(), src_width);
+        offset = yx * num_channels + chan;
+        for (unsigned int x = 0; x < src_width; x++) {
+          buffer[offset] = Y[x];
+          offset += num_channels;
+        }
       }
-    }
+    });
   }
   if (xy & 2) {  // V
-    int offset;
-    const int add = src_width * num_channels;
-
-    for (x = 0; x < src_width; x++) {
-      offset = x * num_channels + chan;
-      for (y = 0; y < src_height; y++) {
-        X[y] = buffer[offset];
-        offset += add;
-      }
-      YVV(src_height);
-      offset = x * num_channels + chan;
-      for (y = 0; y < src_height; y++) {
-        buffer[offset] = Y[y];
-        offset += add;
+    /* Columns are gathered in blocks of neighboring columns, transposing them into contiguous
+     * lines, so that each image row is read and written sequentially instead of striding down
+     * the image once per column. */
+    const unsigned int block_size = IIR_GAUSS_COLUMN_BLOCK_SIZE;
+    const unsigned int num_blocks = divide_ceil_u(src_width, block_size);
+    const size_t add = (size_t)src_width * num_channels;
+    threading::parallel_for(IndexRange(num_blocks), 1, [&](const IndexRange blocks) {
+      Array<double> X((size_t)block_size * src_height), Y((size_t)block_size * src_height);
+      Array<double> W(src_height);
+      for (const int64_t block : blocks) {
+        const unsigned int xmin = (unsigned int)block * block_size;
+        const unsigned int xmax = MIN2(xmin + block_size, src_width);
+        const unsigned int num_columns = xmax - xmin;
+
+        size_t offset = (size_t)xmin * num_channels + chan;
+        for (unsigned int y = 0; y < src_height; y++, offset += add) {
+          const float *in = &buffer[offset];
+          for (unsigned int c = 0; c < num_columns; c++, in += num_channels) {
+            X[(size_t)c * src_height + y] = *in;
+          }
+        }
+        for (unsigned int c = 0; c < num_columns; c++) {
+          const size_t line = (size_t)c * src_height;
+          YVV(&X[line], W.data(), &Y[line], src_height);
+        }
+        offset = (size_t)xmin * num_channels + chan;
+        for (unsigned int y = 0; y < src_height; y++, offset += add) {
+          float *out = &buffer[offset];
+          for (unsigned int c = 0; c < num_columns; c++, out += num_channels) {
+            *out = Y[(size_t)c * src_height + y];
+          }
+        }
       }
-    }
+    });
   }
-
-  MEM_freeN(X);
-  MEM_freeN(W);
-  MEM_freeN(Y);
-#undef YVV
 }
 
 ///
@@ -267,6 +312,7 @@ FastGaussianBlurValueOperation::FastGaussianBlurValueOperation()
   this->m_sigma = 1.0f;
   this->m_overlay = 0;
   flags.complex = true;
+  flags.is_fullframe_operation = true;
 }
 
 void FastGaussianBlurValueOperation::executePixel(float output[4], int x, int y, void *data)
@@ -307,41 +353,69 @@ void FastGaussianBlurValueOperation::deinitExecution()
   deinitMutex();
 }
 
-void *FastGaussianBlurValueOperation::initializeTileData(rcti *rect)
+void FastGaussianBlurValueOperation::blur_buffer(MemoryBuffer *src, MemoryBuffer *copy)
 {
-  lockMutex();
-  if (!this->m_iirgaus) {
-    MemoryBuffer *newBuf = (MemoryBuffer *)this->m_inputprogram->initializeTileData(rect);
-    MemoryBuffer *copy = new MemoryBuffer(*newBuf);
-    FastGaussianBlurOperation::IIR_gauss(copy, this->m_sigma, 0, 3);
-
-    if (this->m_overlay == FAST_GAUSS_OVERLAY_MIN) {
-      float *src = newBuf->getBuffer();
-      float *dst = copy->getBuffer();
-      for (int i = copy->getWidth() * copy->getHeight(); i != 0;
-           i--, src += COM_DATA_TYPE_VALUE_CHANNELS, dst += COM_DATA_TYPE_VALUE_CHANNELS) {
-        if (*src < *dst) {
-          *dst = *src;
-        }
+  FastGaussianBlurOperation::IIR_gauss(copy, this->m_sigma, 0, 3);
+
+  if (this->m_overlay == FAST_GAUSS_OVERLAY_MIN) {
+    float *src_buf = src->getBuffer();
+    float *dst = copy->getBuffer();
+    for (int i = copy->getWidth() * copy->getHeight(); i != 0;
+         i--, src_buf += COM_DATA_TYPE_VALUE_CHANNELS, dst += COM_DATA_TYPE_VALUE_CHANNELS) {
+      if (*src_buf < *dst) {
+        *dst = *src_buf;
       }
     }
-    else if (this->m_overlay == FAST_GAUSS_OVERLAY_MAX) {
-      float *src = newBuf->getBuffer();
-      float *dst = copy->getBuffer();
-      for (int i = copy->getWidth() * copy->getHeight(); i != 0;
-           i--, src += COM_DATA_TYPE_VALUE_CHANNELS, dst += COM_DATA_TYPE_VALUE_CHANNELS) {
-        if (*src > *dst) {
-          *dst = *src;
-        }
+  }
+  else if (this->m_overlay == FAST_GAUSS_OVERLAY_MAX) {
+    float *src_buf = src->getBuffer();
+    float *dst = copy->getBuffer();
+    for (int i = copy->getWidth() * copy->getHeight(); i != 0;
+         i--, src_buf += COM_DATA_TYPE_VALUE_CHANNELS, dst += COM_DATA_TYPE_VALUE_CHANNELS) {
+      if (*src_buf > *dst) {
+        *dst = *src_buf;
       }
     }
+  }
+}
 
-    //      newBuf->
-
+void *FastGaussianBlurValueOperation::initializeTileData(rcti *rect)
+{
+  lockMutex();
+  if (!this->m_iirgaus) {
+    MemoryBuffer *newBuf = (MemoryBuffer *)this->m_inputprogram->initializeTileData(rect);
+    MemoryBuffer *copy = new MemoryBuffer(*newBuf);
+    blur_buffer(newBuf, copy);
     this->m_iirgaus = copy;
   }
   unlockMutex();
   return this->m_iirgaus;
 }
 
+void FastGaussianBlurValueOperation::get_area_of_interest(const int UNUSED(input_idx),
+                                                          const rcti &UNUSED(output_area),
+                                                          rcti &r_input_area)
+{
+  NodeOperation *image_op = getInputOperation(0);
+  BLI_rcti_init(&r_input_area, 0, image_op->getWidth(), 0, image_op->getHeight());
+}
+
+void FastGaussianBlurValueOperation::update_memory_buffer(MemoryBuffer *output,
+                                                          const rcti &area,
+                                                          Span<MemoryBuffer *> inputs)
+{
+  MemoryBuffer *image = inputs[0];
+  if (image->is_a_single_elem()) {
+    output->copy_from(image, area);
+    return;
+  }
+
+  if (!this->m_iirgaus) {
+    MemoryBuffer *copy = new MemoryBuffer(*image);
+    blur_buffer(image, copy);
+    this->m_iirgaus = copy;
+  }
+  output->copy_from(this->m_iirgaus, area);
+}
+
 }  // namespace blender::compositor
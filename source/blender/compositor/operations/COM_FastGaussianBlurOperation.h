@@ -29,6 +29,8 @@ class FastGaussianBlurOperation : public BlurBaseOperation {
   float m_sy;
   MemoryBuffer *m_iirgaus;
 
+  void blur_buffer(MemoryBuffer *buf);
+
  public:
   FastGaussianBlurOperation();
   bool determineDependingAreaOfInterest(rcti *input,
@@ -40,6 +42,10 @@ class FastGaussianBlurOperation : public BlurBaseOperation {
   void *initializeTileData(rcti *rect) override;
   void deinitExecution() override;
   void initExecution() override;
+
+  void update_memory_buffer(MemoryBuffer *output,
+                            const rcti &area,
+                            Span<MemoryBuffer *> inputs) override;
 };
 
 enum {
@@ -60,6 +66,8 @@ class FastGaussianBlurValueOperation : public NodeOperation {
    *  1 re-mix with lighter */
   int m_overlay;
 
+  void blur_buffer(MemoryBuffer *src, MemoryBuffer *copy);
+
  public:
   FastGaussianBlurValueOperation();
   bool determineDependingAreaOfInterest(rcti *input,
@@ -70,6 +78,12 @@ class FastGaussianBlurValueOperation : public NodeOperation {
   void *initializeTileData(rcti *rect) override;
   void deinitExecution() override;
   void initExecution() override;
+
+  void get_area_of_interest(int input_idx, const rcti &output_area, rcti &r_input_area) override;
+  void update_memory_buffer(MemoryBuffer *output,
+                            const rcti &area,
+                            Span<MemoryBuffer *> inputs) override;
+
   void setSigma(float sigma)
   {
     this->m_sigma = sigma;
@@ -18,6 +18,7 @@
 
 #include "COM_GaussianXBlurOperation.h"
 #include "BLI_math.h"
+#include "COM_ExecutionSystem.h"
 #include "COM_OpenCLDevice.h"
 #include "MEM_guardedalloc.h"
 
@@ -32,6 +33,7 @@ GaussianXBlurOperation::GaussianXBlurOperation() : BlurBaseOperation(DataType::C
   this->m_gausstab_sse = nullptr;
 #endif
   this->m_filtersize = 0;
+  flags.is_fullframe_operation = true;
 }
 
 void *GaussianXBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -208,4 +210,66 @@ bool GaussianXBlurOperation::determineDependingAreaOfInterest(rcti *input,
   }
 }
 
+void GaussianXBlurOperation::get_area_of_interest(const int input_idx,
+                                                  const rcti &output_area,
+                                                  rcti &r_input_area)
+{
+  if (input_idx != IMAGE_INPUT_INDEX) {
+    BlurBaseOperation::get_area_of_interest(input_idx, output_area, r_input_area);
+    return;
+  }
+
+  /* Filter size is only known once execution is initialized, read whole rows. */
+  NodeOperation *image_op = getInputOperation(IMAGE_INPUT_INDEX);
+  r_input_area.xmin = 0;
+  r_input_area.xmax = image_op->getWidth();
+  r_input_area.ymin = output_area.ymin;
+  r_input_area.ymax = output_area.ymax;
+}
+
+void GaussianXBlurOperation::update_memory_buffer(MemoryBuffer *output,
+                                                  const rcti &area,
+                                                  Span<MemoryBuffer *> inputs)
+{
+  if (!this->m_sizeavailable) {
+    update_size_from_buffer(inputs[SIZE_INPUT_INDEX]);
+    updateGauss();
+  }
+
+  const MemoryBuffer *input = inputs[IMAGE_INPUT_INDEX];
+  const rcti &input_rect = input->get_rect();
+  const int step = getStep();
+  const int in_step_stride = input->elem_stride * step;
+  exec_system_->execute_work(area, [=](const rcti &split_rect) {
+    for (int y = split_rect.ymin; y < split_rect.ymax; y++) {
+      const int in_y = clamp_i(y, input_rect.ymin, input_rect.ymax - 1);
+      float *out = output->get_elem(split_rect.xmin, y);
+      for (int x = split_rect.xmin; x < split_rect.xmax; x++, out += output->elem_stride) {
+        const int xmin = max_ii(x - m_filtersize, input_rect.xmin);
+        const int xmax = min_ii(x + m_filtersize + 1, input_rect.xmax);
+        const float *in = input->get_elem(xmin, in_y);
+        float multiplier_accum = 0.0f;
+#ifdef BLI_HAVE_SSE2
+        __m128 accum_r = _mm_setzero_ps();
+        for (int nx = xmin, index = (xmin - x) + m_filtersize; nx < xmax;
+             nx += step, index += step, in += in_step_stride) {
+          accum_r = _mm_add_ps(accum_r, _mm_mul_ps(_mm_loadu_ps(in), m_gausstab_sse[index]));
+          multiplier_accum += m_gausstab[index];
+        }
+        _mm_storeu_ps(out, _mm_mul_ps(accum_r, _mm_set1_ps(1.0f / multiplier_accum)));
+#else
+        float color_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int nx = xmin, index = (xmin - x) + m_filtersize; nx < xmax;
+             nx += step, index += step, in += in_step_stride) {
+          const float multiplier = m_gausstab[index];
+          madd_v4_v4fl(color_accum, in, multiplier);
+          multiplier_accum += multiplier;
+        }
+        mul_v4_v4fl(out, color_accum, 1.0f / multiplier_accum);
+#endif
+      }
+    }
+  });
+}
+
 }  // namespace blender::compositor
@@ -18,6 +18,7 @@
 
 #include "COM_GaussianYBlurOperation.h"
 #include "BLI_math.h"
+#include "COM_ExecutionSystem.h"
 #include "COM_OpenCLDevice.h"
 #include "MEM_guardedalloc.h"
 
@@ -32,6 +33,7 @@ GaussianYBlurOperation::GaussianYBlurOperation() : BlurBaseOperation(DataType::C
   this->m_gausstab_sse = nullptr;
 #endif
   this->m_filtersize = 0;
+  flags.is_fullframe_operation = true;
 }
 
 void *GaussianYBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -208,4 +210,67 @@ bool GaussianYBlurOperation::determineDependingAreaOfInterest(rcti *input,
   }
 }
 
+void GaussianYBlurOperation::get_area_of_interest(const int input_idx,
+                                                  const rcti &output_area,
+                                                  rcti &r_input_area)
+{
+  if (input_idx != IMAGE_INPUT_INDEX) {
+    BlurBaseOperation::get_area_of_interest(input_idx, output_area, r_input_area);
+    return;
+  }
+
+  /* Filter size is only known once execution is initialized, read whole columns. */
+  NodeOperation *image_op = getInputOperation(IMAGE_INPUT_INDEX);
+  r_input_area.xmin = output_area.xmin;
+  r_input_area.xmax = output_area.xmax;
+  r_input_area.ymin = 0;
+  r_input_area.ymax = image_op->getHeight();
+}
+
+void GaussianYBlurOperation::update_memory_buffer(MemoryBuffer *output,
+                                                  const rcti &area,
+                                                  Span<MemoryBuffer *> inputs)
+{
+  if (!this->m_sizeavailable) {
+    update_size_from_buffer(inputs[SIZE_INPUT_INDEX]);
+    updateGauss();
+  }
+
+  const MemoryBuffer *input = inputs[IMAGE_INPUT_INDEX];
+  const rcti &input_rect = input->get_rect();
+  const int step = getStep();
+  exec_system_->execute_work(area, [=](const rcti &split_rect) {
+    const int row_width = BLI_rcti_size_x(&split_rect);
+    for (int y = split_rect.ymin; y < split_rect.ymax; y++) {
+      const int ymin = max_ii(y - m_filtersize, input_rect.ymin);
+      const int ymax = min_ii(y + m_filtersize + 1, input_rect.ymax);
+      float *out_row = output->get_elem(split_rect.xmin, y);
+
+      /* Accumulate whole input rows into the output row instead of walking down a column per
+       * pixel, so that both buffers are read sequentially. Weights only depend on the row. */
+      float *out = out_row;
+      for (int i = 0; i < row_width; i++, out += output->elem_stride) {
+        zero_v4(out);
+      }
+      float multiplier_accum = 0.0f;
+      for (int ny = ymin, index = (ymin - y) + m_filtersize; ny < ymax;
+           ny += step, index += step) {
+        const float multiplier = m_gausstab[index];
+        const float *in = input->get_elem(split_rect.xmin, ny);
+        out = out_row;
+        for (int i = 0; i < row_width; i++, out += output->elem_stride, in += input->elem_stride) {
+          madd_v4_v4fl(out, in, multiplier);
+        }
+        multiplier_accum += multiplier;
+      }
+
+      const float multiplier_inv = 1.0f / multiplier_accum;
+      out = out_row;
+      for (int i = 0; i < row_width; i++, out += output->elem_stride) {
+        mul_v4_fl(out, multiplier_inv);
+      }
+    }
+  });
+}
+
 }  // namespace blender::compositor
@@ -66,6 +66,11 @@ class GaussianYBlurOperation : public BlurBaseOperation {
   {
     flags.open_cl = (m_data.sizex >= 128);
   }
+
+  void get_area_of_interest(int input_idx, const rcti &output_area, rcti &r_input_area) override;
+  void update_memory_buffer(MemoryBuffer *output,
+                            const rcti &area,
+                            Span<MemoryBuffer *> inputs) override;
 };
 
 }  // namespace blender::compositor
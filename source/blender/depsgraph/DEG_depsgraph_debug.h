@@ -62,6 +62,11 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* Write a timeline of every operation evaluation (thread, start/stop and wait time) to a file in
+ * the Chrome trace event format, until #DEG_debug_trace_end is called. */
+void DEG_debug_trace_begin(const char *filepath);
+void DEG_debug_trace_end(void);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
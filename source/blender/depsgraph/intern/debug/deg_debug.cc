@@ -34,6 +34,19 @@
 
 namespace blender::deg {
 
+CopyOnWriteStats::CopyOnWriteStats()
+{
+  reset();
+}
+
+void CopyOnWriteStats::reset()
+{
+  num_updated_ids = 0;
+  update_time_us = 0;
+  num_copied_bytes = 0;
+  num_unchanged_bytes = 0;
+}
+
 DepsgraphDebug::DepsgraphDebug()
     : flags(G.debug), is_ever_evaluated(false), graph_evaluation_start_time_(0)
 {
@@ -57,6 +70,7 @@ void DepsgraphDebug::begin_graph_evaluation()
   }
 
   graph_evaluation_start_time_ = current_time;
+  cow_stats.reset();
 }
 
 void DepsgraphDebug::end_graph_evaluation()
@@ -68,6 +82,14 @@ void DepsgraphDebug::end_graph_evaluation()
   const double graph_eval_end_time = PIL_check_seconds_timer();
   printf("Depsgraph updated in %f seconds.\n", graph_eval_end_time - graph_evaluation_start_time_);
   printf("Depsgraph evaluation FPS: %f\n", 1.0f / fps_samples_.get_averaged());
+  if (cow_stats.num_updated_ids != 0) {
+    printf("Copy-on-write: %d datablocks updated in %f seconds, %.2f MiB copied, %.2f MiB "
+           "unchanged.\n",
+           cow_stats.num_updated_ids.load(),
+           cow_stats.update_time_us / 1e6,
+           cow_stats.num_copied_bytes / (1024.0 * 1024.0),
+           cow_stats.num_unchanged_bytes / (1024.0 * 1024.0));
+  }
 
   is_ever_evaluated = true;
 }
@@ -23,6 +23,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 #include "intern/debug/deg_time_average.h"
 #include "intern/depsgraph_type.h"
 
@@ -33,6 +36,22 @@
 namespace blender {
 namespace deg {
 
+/* Statistics of copy-on-write updates done during a single graph evaluation. */
+struct CopyOnWriteStats {
+  CopyOnWriteStats();
+
+  void reset();
+
+  std::atomic<int> num_updated_ids;
+  /* Time spent in updates, in microseconds. */
+  std::atomic<uint64_t> update_time_us;
+
+  /* Geometry arrays copied from the original data-block, and arrays of the previous copy which
+   * were kept as-is because the update was not tagged for changes to them. */
+  std::atomic<uint64_t> num_copied_bytes;
+  std::atomic<uint64_t> num_unchanged_bytes;
+};
+
 class DepsgraphDebug {
  public:
   DepsgraphDebug();
@@ -53,6 +72,10 @@ class DepsgraphDebug {
    * This is NOT an indication that depsgraph is at its evaluated state. */
   bool is_ever_evaluated;
 
+  /* Only gathered when time debug is enabled. Updated from evaluation threads, which only have
+   * const access to the graph. */
+  mutable CopyOnWriteStats cow_stats;
+
  protected:
   /* Maximum number of counters used to calculate frame rate of depsgraph update. */
   static const constexpr int MAX_FPS_COUNTERS = 64;
@@ -0,0 +1,250 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/debug/deg_debug_trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#include "BLI_fileops.h"
+#include "BLI_utildefines.h"
+#include "BLI_vector.hh"
+
+#include "PIL_time.h"
+
+#include "intern/depsgraph.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace blender::deg {
+
+namespace {
+
+/* All events are reported as part of a single process, threads are identified by an index which
+ * is assigned on the first traced operation of the thread. */
+const int TRACE_PROCESS_ID = 1;
+
+struct TraceEvent {
+  string name;
+  const char *category;
+  string depsgraph_name;
+  int thread_id;
+  double start_time;
+  double end_time;
+  double wait_time;
+};
+
+struct TraceState {
+  std::mutex mutex;
+  std::atomic<bool> is_enabled{false};
+  FILE *file = nullptr;
+  bool is_first_event = true;
+  /* Time of the trace begin, all event times are relative to it. */
+  double start_time = 0.0;
+  /* Number of threads for which name meta-data has been written already. */
+  int num_named_threads = 0;
+  /* Events which are not yet written to the file. */
+  Vector<TraceEvent> events;
+};
+
+TraceState &trace_state()
+{
+  static TraceState state;
+  return state;
+}
+
+std::atomic<int> num_trace_threads{0};
+
+int trace_thread_id()
+{
+  static thread_local int thread_id = num_trace_threads.fetch_add(1);
+  return thread_id;
+}
+
+void trace_write_string(FILE *file, const char *str)
+{
+  fputc('"', file);
+  for (const char *c = str; *c != '\0'; c++) {
+    switch (*c) {
+      case '"':
+        fputs("\\\"", file);
+        break;
+      case '\\':
+        fputs("\\\\", file);
+        break;
+      default:
+        if ((unsigned char)*c < 0x20) {
+          fprintf(file, "\\u%04x", (unsigned char)*c);
+        }
+        else {
+          fputc(*c, file);
+        }
+        break;
+    }
+  }
+  fputc('"', file);
+}
+
+/* Events are separated ahead of writing them, so that the file stays valid JSON once the closing
+ * bracket is written. Trace viewers accept the file without it as well. */
+void trace_begin_event(TraceState &state)
+{
+  if (state.is_first_event) {
+    state.is_first_event = false;
+  }
+  else {
+    fputs(",\n", state.file);
+  }
+}
+
+void trace_write_thread_names(TraceState &state)
+{
+  const int num_threads = num_trace_threads.load();
+  for (; state.num_named_threads < num_threads; state.num_named_threads++) {
+    trace_begin_event(state);
+    fprintf(state.file,
+            "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+            "\"args\": {\"name\": \"Thread %d\"}}",
+            TRACE_PROCESS_ID,
+            state.num_named_threads,
+            state.num_named_threads);
+  }
+}
+
+void trace_write_event(TraceState &state, const TraceEvent &event)
+{
+  /* Times are in microseconds. */
+  const double start_us = (event.start_time - state.start_time) * 1e6;
+  const double duration_us = (event.end_time - event.start_time) * 1e6;
+
+  trace_begin_event(state);
+  fputs("{\"name\": ", state.file);
+  trace_write_string(state.file, event.name.c_str());
+  fputs(", \"cat\": ", state.file);
+  trace_write_string(state.file, event.category);
+  fprintf(state.file,
+          ", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, ",
+          TRACE_PROCESS_ID,
+          event.thread_id,
+          start_us,
+          duration_us);
+  fputs("\"args\": {\"depsgraph\": ", state.file);
+  trace_write_string(state.file, event.depsgraph_name.c_str());
+  fprintf(state.file, ", \"wait_us\": %.3f}}", event.wait_time * 1e6);
+}
+
+void trace_close_file(TraceState &state)
+{
+  if (state.file == nullptr) {
+    return;
+  }
+  fputs("\n]\n", state.file);
+  fclose(state.file);
+  state.file = nullptr;
+  state.is_enabled = false;
+  state.events.clear();
+}
+
+}  // namespace
+
+void deg_debug_trace_begin(const char *filepath)
+{
+  TraceState &state = trace_state();
+  std::scoped_lock lock(state.mutex);
+  trace_close_file(state);
+
+  state.file = BLI_fopen(filepath, "w");
+  if (state.file == nullptr) {
+    fprintf(stderr, "Depsgraph: unable to open trace file '%s'\n", filepath);
+    return;
+  }
+  fputs("[\n", state.file);
+  state.is_first_event = true;
+  state.num_named_threads = 0;
+  state.start_time = PIL_check_seconds_timer();
+  state.is_enabled = true;
+}
+
+void deg_debug_trace_end()
+{
+  TraceState &state = trace_state();
+  std::scoped_lock lock(state.mutex);
+  trace_close_file(state);
+}
+
+bool deg_debug_trace_is_enabled()
+{
+  return trace_state().is_enabled;
+}
+
+void deg_debug_trace_operation(const Depsgraph *graph,
+                               const OperationNode *operation_node,
+                               const double schedule_time,
+                               const double start_time,
+                               const double end_time)
+{
+  TraceEvent event;
+  event.name = operation_node->full_identifier();
+  event.category = nodeTypeAsString(operation_node->owner->type);
+  event.depsgraph_name = graph->debug.name;
+  event.thread_id = trace_thread_id();
+  event.start_time = start_time;
+  event.end_time = end_time;
+  event.wait_time = max(start_time - schedule_time, 0.0);
+
+  TraceState &state = trace_state();
+  std::scoped_lock lock(state.mutex);
+  if (state.file != nullptr) {
+    state.events.append(std::move(event));
+  }
+}
+
+void deg_debug_trace_graph_evaluation(const Depsgraph *graph,
+                                      const double start_time,
+                                      const double end_time)
+{
+  TraceEvent event;
+  event.name = "Depsgraph Evaluation";
+  event.category = "Depsgraph";
+  event.depsgraph_name = graph->debug.name;
+  event.thread_id = trace_thread_id();
+  event.start_time = start_time;
+  event.end_time = end_time;
+  event.wait_time = 0.0;
+
+  TraceState &state = trace_state();
+  std::scoped_lock lock(state.mutex);
+  if (state.file == nullptr) {
+    return;
+  }
+  trace_write_thread_names(state);
+  trace_write_event(state, event);
+  for (const TraceEvent &operation_event : state.events) {
+    trace_write_event(state, operation_event);
+  }
+  state.events.clear();
+  fflush(state.file);
+}
+
+}  // namespace blender::deg
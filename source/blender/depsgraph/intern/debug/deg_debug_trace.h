@@ -0,0 +1,54 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Timeline of operation evaluations, written in the Chrome trace event format so it can be
+ * inspected in `chrome://tracing` or Perfetto.
+ */
+
+#pragma once
+
+namespace blender {
+namespace deg {
+
+struct Depsgraph;
+struct OperationNode;
+
+/* Start writing evaluation trace to the given file, closing previously opened trace. */
+void deg_debug_trace_begin(const char *filepath);
+/* Finish the trace file, making it a valid JSON document. */
+void deg_debug_trace_end();
+
+bool deg_debug_trace_is_enabled();
+
+/* Record evaluation of a single operation on the current thread.
+ * The wait time is the time the operation spent in the task pool being ready but not running. */
+void deg_debug_trace_operation(const Depsgraph *graph,
+                               const OperationNode *operation_node,
+                               double schedule_time,
+                               double start_time,
+                               double end_time);
+
+/* Record an evaluation of the whole graph, and write all events gathered so far to the file. */
+void deg_debug_trace_graph_evaluation(const Depsgraph *graph, double start_time, double end_time);
+
+}  // namespace deg
+}  // namespace blender
@@ -35,6 +35,7 @@
 #include "DEG_depsgraph_query.h"
 
 #include "intern/debug/deg_debug.h"
+#include "intern/debug/deg_debug_trace.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_relation.h"
 #include "intern/depsgraph_type.h"
@@ -68,6 +69,16 @@ const char *DEG_debug_name_get(struct Depsgraph *depsgraph)
   return deg_graph->debug.name.c_str();
 }
 
+void DEG_debug_trace_begin(const char *filepath)
+{
+  deg::deg_debug_trace_begin(filepath);
+}
+
+void DEG_debug_trace_end()
+{
+  deg::deg_debug_trace_end();
+}
+
 bool DEG_debug_compare(const struct Depsgraph *graph1, const struct Depsgraph *graph2)
 {
   BLI_assert(graph1 != nullptr);
@@ -25,11 +25,16 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <queue>
+#include <vector>
+
 #include "PIL_time.h"
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
+#include "BLI_math_base.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -43,6 +48,7 @@
 
 #include "atomic_ops.h"
 
+#include "intern/debug/deg_debug_trace.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_relation.h"
 #include "intern/depsgraph_tag.h"
@@ -69,11 +75,6 @@ void schedule_children(DepsgraphEvalState *state,
                        ScheduleFunction *schedule_function,
                        ScheduleFunctionArgs... schedule_function_args);
 
-void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
-{
-  BLI_task_pool_push(pool, deg_task_run_func, node, false, nullptr);
-}
-
 /* Denotes which part of dependency graph is being evaluated. */
 enum class EvaluationStage {
   /* Stage 1: Only  Copy-on-Write operations are to be evaluated, prior to anything else.
@@ -91,13 +92,86 @@ enum class EvaluationStage {
   SINGLE_THREADED_WORKAROUND,
 };
 
+/* Lower bound of the operation evaluation cost, used for operations which were not evaluated yet.
+ * Makes longer chains of operations preferred over shorter ones. */
+const float MIN_EVALUATION_COST = 1e-6f;
+
+/* Weight of the latest evaluation time when updating the averaged operation evaluation cost. */
+const float EVALUATION_COST_UPDATE_FACTOR = 0.25f;
+
+/* Operations which are ready for evaluation, ordered by their critical path cost.
+ *
+ * Every task pushed to the task pool evaluates the top operation of this queue rather than a
+ * specific one, so the order in which operations are evaluated follows their priority instead of
+ * the order in which they became ready. */
+class ReadyOperationQueue {
+ public:
+  ReadyOperationQueue()
+  {
+    BLI_spin_init(&lock_);
+  }
+
+  ~ReadyOperationQueue()
+  {
+    BLI_spin_end(&lock_);
+  }
+
+  void push(OperationNode *node)
+  {
+    BLI_spin_lock(&lock_);
+    queue_.push(node);
+    BLI_spin_unlock(&lock_);
+  }
+
+  OperationNode *pop()
+  {
+    BLI_spin_lock(&lock_);
+    BLI_assert(!queue_.empty());
+    OperationNode *node = queue_.top();
+    queue_.pop();
+    BLI_spin_unlock(&lock_);
+    return node;
+  }
+
+ private:
+  struct PriorityCompare {
+    bool operator()(const OperationNode *a, const OperationNode *b) const
+    {
+      return a->critical_path_cost < b->critical_path_cost;
+    }
+  };
+
+  SpinLock lock_;
+  std::priority_queue<OperationNode *, std::vector<OperationNode *>, PriorityCompare> queue_;
+};
+
 struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
+  bool do_trace;
   EvaluationStage stage;
   bool need_single_thread_pass;
+  ReadyOperationQueue ready_queue;
 };
 
+void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
+{
+  DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_user_data(pool);
+  state->ready_queue.push(node);
+  BLI_task_pool_push(pool, deg_task_run_func, nullptr, false, nullptr);
+}
+
+void update_evaluation_cost(OperationNode *operation_node, const double time)
+{
+  if (operation_node->evaluation_cost == 0.0f) {
+    operation_node->evaluation_cost = time;
+  }
+  else {
+    operation_node->evaluation_cost = interpf(
+        time, operation_node->evaluation_cost, EVALUATION_COST_UPDATE_FACTOR);
+  }
+}
+
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
@@ -105,30 +179,35 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
   /* Sanity checks. */
   BLI_assert(!operation_node->is_noop() && "NOOP nodes should not actually be scheduled");
   /* Perform operation. */
+  const double start_time = PIL_check_seconds_timer();
+  operation_node->evaluate(depsgraph);
+  const double end_time = PIL_check_seconds_timer();
+
+  update_evaluation_cost(operation_node, end_time - start_time);
   if (state->do_stats) {
-    const double start_time = PIL_check_seconds_timer();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
+    operation_node->stats.current_time += end_time - start_time;
   }
-  else {
-    operation_node->evaluate(depsgraph);
+  if (state->do_trace) {
+    deg_debug_trace_operation(
+        state->graph, operation_node, operation_node->trace_schedule_time, start_time, end_time);
   }
 }
 
-void deg_task_run_func(TaskPool *pool, void *taskdata)
+void deg_task_run_func(TaskPool *pool, void *UNUSED(taskdata))
 {
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
-  /* Evaluate node. */
-  OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
+  /* Evaluate the most important ready operation, which is not necessarily the one this task was
+   * pushed for. */
+  OperationNode *operation_node = state->ready_queue.pop();
   evaluate_node(state, operation_node);
 
   /* Schedule children. */
   schedule_children(state, operation_node, schedule_node_to_pool, pool);
 }
 
-bool check_operation_node_visible(OperationNode *op_node)
+bool check_operation_node_visible(const OperationNode *op_node)
 {
   const ComponentNode *comp_node = op_node->owner;
   /* Special exception, copy on write component is to be always evaluated,
@@ -178,10 +257,69 @@ void calculate_pending_parents(Depsgraph *graph)
   }
 }
 
+bool is_operation_pending(const OperationNode *node)
+{
+  return check_operation_node_visible(node) &&
+         (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0;
+}
+
+/* Calculate cost of the most expensive chain of pending operations starting at every operation,
+ * using averaged costs of previous evaluations. Operations are visited in reverse topological
+ * order, custom_flags counts children which are not visited yet. */
+void calculate_critical_path_costs(Depsgraph *graph)
+{
+  Vector<OperationNode *> stack;
+  for (OperationNode *node : graph->operations) {
+    node->critical_path_cost = 0.0f;
+    node->custom_flags = 0;
+    if (!is_operation_pending(node)) {
+      continue;
+    }
+    for (Relation *rel : node->outlinks) {
+      OperationNode *child = (OperationNode *)rel->to;
+      if ((rel->flag & RELATION_FLAG_CYCLIC) == 0 && is_operation_pending(child)) {
+        ++node->custom_flags;
+      }
+    }
+    if (node->custom_flags == 0) {
+      stack.append(node);
+    }
+  }
+
+  while (!stack.is_empty()) {
+    OperationNode *node = stack.pop_last();
+    float children_cost = 0.0f;
+    for (Relation *rel : node->outlinks) {
+      OperationNode *child = (OperationNode *)rel->to;
+      if ((rel->flag & RELATION_FLAG_CYCLIC) == 0 && is_operation_pending(child)) {
+        children_cost = max_ff(children_cost, child->critical_path_cost);
+      }
+    }
+    const float node_cost = node->is_noop() ? 0.0f :
+                                              max_ff(node->evaluation_cost, MIN_EVALUATION_COST);
+    node->critical_path_cost = node_cost + children_cost;
+
+    for (Relation *rel : node->inlinks) {
+      if (rel->from->type != NodeType::OPERATION || (rel->flag & RELATION_FLAG_CYCLIC) != 0) {
+        continue;
+      }
+      OperationNode *parent = (OperationNode *)rel->from;
+      if (!is_operation_pending(parent)) {
+        continue;
+      }
+      BLI_assert(parent->custom_flags > 0);
+      if (--parent->custom_flags == 0) {
+        stack.append(parent);
+      }
+    }
+  }
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
   const bool do_stats = state->do_stats;
   calculate_pending_parents(graph);
+  calculate_critical_path_costs(graph);
   /* Clear tags and other things which needs to be clear. */
   for (OperationNode *node : graph->operations) {
     if (do_stats) {
@@ -270,6 +408,9 @@ void schedule_node(DepsgraphEvalState *state,
       schedule_children(state, node, schedule_function, schedule_function_args...);
     }
     else {
+      if (state->do_trace) {
+        node->trace_schedule_time = PIL_check_seconds_timer();
+      }
       /* children are scheduled once this task is completed */
       schedule_function(node, 0, schedule_function_args...);
     }
@@ -375,12 +516,16 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
 
   graph->debug.begin_graph_evaluation();
 
+  const bool do_trace = deg_debug_trace_is_enabled();
+  const double trace_start_time = do_trace ? PIL_check_seconds_timer() : 0.0;
+
   graph->is_evaluating = true;
   depsgraph_ensure_view_layer(graph);
   /* Set up evaluation state. */
   DepsgraphEvalState state;
   state.graph = graph;
   state.do_stats = graph->debug.do_time_debug();
+  state.do_trace = do_trace;
   state.need_single_thread_pass = false;
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
@@ -415,6 +560,10 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   deg_graph_clear_tags(graph);
   graph->is_evaluating = false;
 
+  if (do_trace) {
+    deg_debug_trace_graph_evaluation(graph, trace_start_time, PIL_check_seconds_timer());
+  }
+
   graph->debug.end_graph_evaluation();
 }
 
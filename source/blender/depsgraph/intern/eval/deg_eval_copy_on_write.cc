@@ -33,14 +33,17 @@
 
 #include "intern/eval/deg_eval_copy_on_write.h"
 
+#include <array>
 #include <cstring>
 
 #include "BLI_listbase.h"
 #include "BLI_string.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_curve.h"
+#include "BKE_customdata.h"
 #include "BKE_global.h"
 #include "BKE_gpencil.h"
 #include "BKE_idprop.h"
@@ -53,6 +56,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "PIL_time.h"
+
 #include "DNA_ID.h"
 #include "DNA_anim_types.h"
 #include "DNA_armature_types.h"
@@ -87,6 +92,7 @@
 #include "BKE_armature.h"
 #include "BKE_editmesh.h"
 #include "BKE_lib_query.h"
+#include "BKE_mesh.h"
 #include "BKE_modifier.h"
 #include "BKE_object.h"
 #include "BKE_pointcache.h"
@@ -283,8 +289,8 @@ struct ValidateData {
 };
 
 /* Similar to generic BKE_id_copy() but does not require main and assumes pointer
- * is already allocated. */
-bool id_copy_inplace_no_main(const ID *id, ID *newid)
+ * is already allocated. The flag is combined with the regular copy-on-write copy flags. */
+bool id_copy_inplace_no_main(const ID *id, ID *newid, const int flag = 0)
 {
   const ID *id_for_copy = id;
 
@@ -305,7 +311,7 @@ bool id_copy_inplace_no_main(const ID *id, ID *newid)
                                 (ID *)id_for_copy,
                                 &newid,
                                 (LIB_ID_COPY_LOCALIZE | LIB_ID_CREATE_NO_ALLOCATE |
-                                 LIB_ID_COPY_SET_COPIED_ON_WRITE)) != nullptr);
+                                 LIB_ID_COPY_SET_COPIED_ON_WRITE | flag)) != nullptr);
 
 #ifdef NESTED_ID_NASTY_WORKAROUND
   if (result) {
@@ -316,6 +322,134 @@ bool id_copy_inplace_no_main(const ID *id, ID *newid)
   return result;
 }
 
+/* Geometry arrays of a copied-on-write mesh, detached from it before it is freed on update, so
+ * that the next copy can reuse them instead of allocating and copying all arrays again. Only
+ * arrays without pointers to other allocated data are kept. */
+class MeshArrayStash {
+ public:
+  ~MeshArrayStash()
+  {
+    for (StashedArray &array : arrays_) {
+      MEM_freeN(array.data);
+    }
+  }
+
+  /* The recalc flags of the copy tell whether arrays of the original mesh could have been
+   * modified or replaced since the previous copy. */
+  void stash_from_mesh(Mesh *mesh_cow, const int recalc)
+  {
+    arrays_changed_ = mesh_arrays_may_have_changed(recalc);
+    for (const MeshDomain &domain : mesh_domains(mesh_cow)) {
+      for (int i = 0; i < domain.data->totlayer; i++) {
+        CustomDataLayer *layer = &domain.data->layers[i];
+        if (layer->data == nullptr || (layer->flag & CD_FLAG_NOFREE) ||
+            CustomData_layertype_is_dynamic(layer->type)) {
+          continue;
+        }
+        StashedArray array;
+        array.data = layer->data;
+        array.domain = domain.data;
+        array.type = layer->type;
+        array.totelem = domain.totelem;
+        STRNCPY(array.name, layer->name);
+        arrays_.append(array);
+        /* Freeing the layer skips data which is not there anymore. */
+        layer->data = nullptr;
+      }
+    }
+  }
+
+  /* Make the copied mesh own the geometry arrays it references from the original mesh, reusing
+   * stashed arrays of matching layers. Such arrays are only written when the original arrays
+   * could have changed. */
+  void take_referenced_arrays(Mesh *mesh_cow)
+  {
+    for (const MeshDomain &domain : mesh_domains(mesh_cow)) {
+      for (int i = 0; i < domain.data->totlayer; i++) {
+        CustomDataLayer *layer = &domain.data->layers[i];
+        if (!(layer->flag & CD_FLAG_NOFREE)) {
+          continue;
+        }
+        const size_t size = (size_t)CustomData_sizeof(layer->type) * domain.totelem;
+        void *data = pop_stashed_array(domain, *layer);
+        if (data != nullptr) {
+          if (!arrays_changed_) {
+            num_unchanged_bytes += size;
+          }
+          else {
+            memcpy(data, layer->data, size);
+            num_copied_bytes += size;
+          }
+          layer->data = data;
+          layer->flag &= ~CD_FLAG_NOFREE;
+        }
+        else {
+          num_copied_bytes += size;
+        }
+      }
+      /* Duplicate everything which could not be reused. */
+      CustomData_duplicate_referenced_layers(domain.data, domain.totelem);
+    }
+    BKE_mesh_update_customdata_pointers(mesh_cow, false);
+  }
+
+  uint64_t num_copied_bytes = 0;
+  uint64_t num_unchanged_bytes = 0;
+
+ private:
+  struct MeshDomain {
+    CustomData *data;
+    int totelem;
+  };
+
+  struct StashedArray {
+    void *data;
+    /* Layers are matched by the domain they belong to in the mesh, so pointers to the custom
+     * data of the copied mesh are used, which stay the same across updates. */
+    const CustomData *domain;
+    int type;
+    int totelem;
+    char name[MAX_CUSTOMDATA_LAYER_NAME];
+  };
+
+  /* Updates only tagged for these are known to leave the geometry arrays of the original mesh
+   * untouched, other tags (geometry, selection, animation, or an explicit copy-on-write) can come
+   * from code writing to the arrays in place. */
+  static bool mesh_arrays_may_have_changed(const int recalc)
+  {
+    const int unchanged_recalc = ID_RECALC_TRANSFORM | ID_RECALC_SHADING | ID_RECALC_BASE_FLAGS |
+                                 ID_RECALC_POINT_CACHE | ID_RECALC_EDITORS |
+                                 ID_RECALC_PARAMETERS;
+    return recalc == 0 || (recalc & ~unchanged_recalc) != 0;
+  }
+
+  static std::array<MeshDomain, 5> mesh_domains(Mesh *mesh)
+  {
+    return {{{&mesh->vdata, mesh->totvert},
+             {&mesh->edata, mesh->totedge},
+             {&mesh->fdata, mesh->totface},
+             {&mesh->ldata, mesh->totloop},
+             {&mesh->pdata, mesh->totpoly}}};
+  }
+
+  void *pop_stashed_array(const MeshDomain &domain, const CustomDataLayer &layer)
+  {
+    for (const int i : arrays_.index_range()) {
+      const StashedArray &array = arrays_[i];
+      if (array.domain == domain.data && array.type == layer.type &&
+          array.totelem == domain.totelem && STREQ(array.name, layer.name)) {
+        void *data = array.data;
+        arrays_.remove_and_reorder(i);
+        return data;
+      }
+    }
+    return nullptr;
+  }
+
+  Vector<StashedArray> arrays_;
+  bool arrays_changed_ = true;
+};
+
 /* Similar to BKE_scene_copy() but does not require main and assumes pointer
  * is already allocated. */
 bool scene_copy_inplace_no_main(const Scene *scene, Scene *new_scene)
@@ -834,16 +968,16 @@ int foreach_libblock_validate_callback(LibraryIDLinkCallbackData *cb_data)
   return IDWALK_RET_NOP;
 }
 
-}  // namespace
-
 /* Actual implementation of logic which "expands" all the data which was not
  * yet copied-on-write.
  *
- * NOTE: Expects that CoW datablock is empty. */
-ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph,
-                                       const IDNode *id_node,
-                                       DepsgraphNodeBuilder *node_builder,
-                                       bool create_placeholders)
+ * NOTE: Expects that CoW datablock is empty. Geometry arrays of its previous
+ * content can be passed in a stash to be reused. */
+ID *expand_copy_on_write_datablock(const Depsgraph *depsgraph,
+                                  const IDNode *id_node,
+                                  DepsgraphNodeBuilder *node_builder,
+                                  bool create_placeholders,
+                                  MeshArrayStash *mesh_array_stash)
 {
   const ID *id_orig = id_node->id_orig;
   ID *id_cow = id_node->id_cow;
@@ -888,8 +1022,14 @@ ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph,
       break;
     }
     case ID_ME: {
-      /* TODO(sergey): Ideally we want to handle meshes in a special
-       * manner here to avoid initial copy of all the geometry arrays. */
+      /* Reference geometry arrays of the original mesh, then only copy the
+       * ones which changed since the previous copy. */
+      done = id_copy_inplace_no_main(id_orig, id_cow, LIB_ID_COPY_CD_REFERENCE);
+      if (done) {
+        MeshArrayStash empty_stash;
+        MeshArrayStash &stash = (mesh_array_stash != nullptr) ? *mesh_array_stash : empty_stash;
+        stash.take_referenced_arrays((Mesh *)id_cow);
+      }
       break;
     }
     default:
@@ -928,6 +1068,17 @@ ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph,
   return id_cow;
 }
 
+}  // namespace
+
+ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph,
+                                       const IDNode *id_node,
+                                       DepsgraphNodeBuilder *node_builder,
+                                       bool create_placeholders)
+{
+  return expand_copy_on_write_datablock(
+      depsgraph, id_node, node_builder, create_placeholders, nullptr);
+}
+
 /* NOTE: Depsgraph is supposed to have ID node already. */
 ID *deg_expand_copy_on_write_datablock(const Depsgraph *depsgraph,
                                        ID *id_orig,
@@ -947,11 +1098,24 @@ ID *deg_update_copy_on_write_datablock(const Depsgraph *depsgraph, const IDNode
   if (!deg_copy_on_write_is_needed(id_orig)) {
     return id_cow;
   }
+  const bool do_time_debug = depsgraph->debug.do_time_debug();
+  const double start_time = do_time_debug ? PIL_check_seconds_timer() : 0.0;
   RuntimeBackup backup(depsgraph);
   backup.init_from_id(id_cow);
+  MeshArrayStash mesh_array_stash;
+  if (GS(id_orig->name) == ID_ME && check_datablock_expanded(id_cow)) {
+    mesh_array_stash.stash_from_mesh((Mesh *)id_cow, id_cow->recalc);
+  }
   deg_free_copy_on_write_datablock(id_cow);
-  deg_expand_copy_on_write_datablock(depsgraph, id_node);
+  expand_copy_on_write_datablock(depsgraph, id_node, nullptr, false, &mesh_array_stash);
   backup.restore_to_id(id_cow);
+  if (do_time_debug) {
+    CopyOnWriteStats &stats = depsgraph->debug.cow_stats;
+    stats.num_updated_ids++;
+    stats.update_time_us += (uint64_t)((PIL_check_seconds_timer() - start_time) * 1e6);
+    stats.num_copied_bytes += mesh_array_stash.num_copied_bytes;
+    stats.num_unchanged_bytes += mesh_array_stash.num_unchanged_bytes;
+  }
   return id_cow;
 }
 
@@ -209,7 +209,12 @@ const char *operationCodeAsString(OperationCode opcode)
   return "UNKNOWN";
 }
 
-OperationNode::OperationNode() : name_tag(-1), flag(0)
+OperationNode::OperationNode()
+    : trace_schedule_time(0.0),
+      evaluation_cost(0.0f),
+      critical_path_cost(0.0f),
+      name_tag(-1),
+      flag(0)
 {
 }
 
@@ -265,6 +265,15 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Time at which the operation was pushed for evaluation, only set when evaluation is traced. */
+  double trace_schedule_time;
+
+  /* Estimated evaluation time in seconds, averaged over previous evaluations. */
+  float evaluation_cost;
+  /* Estimated time of the most expensive chain of operations starting at this one. Operations
+   * with the highest value are on the critical path and are evaluated first. */
+  float critical_path_cost;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
@@ -239,6 +239,8 @@ typedef struct MeshBatchCache {
   bool is_dirty; /* Instantly invalidates cache, skipping mesh check */
   bool is_editmode;
   bool is_uvsyncsel;
+  /* The triangulation of n-gons depends on vertex positions, see #mesh_batch_cache_tag_deform. */
+  bool has_ngons;
 
   struct DRW_MeshWeightState weight_state;
 
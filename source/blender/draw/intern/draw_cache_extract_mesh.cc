@@ -246,6 +246,10 @@ struct ExtractorIterData {
   const void *elems = nullptr;
   const int *loose_elems = nullptr;
 
+  /* Only used when iterating over polygons and their triangles in a single pass. */
+  ExtractorRunDatas looptri_extractors;
+  const void *looptri_elems = nullptr;
+
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("DRW:MeshRenderDataUpdateTaskData")
 #endif
@@ -256,11 +260,13 @@ static void extract_task_reduce(const void *__restrict userdata,
                                 void *__restrict chunk_from)
 {
   const ExtractorIterData *data = static_cast<const ExtractorIterData *>(userdata);
-  for (const ExtractorRunData &run_data : data->extractors) {
-    const MeshExtract *extractor = run_data.extractor;
-    if (extractor->task_reduce) {
-      extractor->task_reduce(POINTER_OFFSET(chunk_to, run_data.data_offset),
-                             POINTER_OFFSET(chunk_from, run_data.data_offset));
+  for (const ExtractorRunDatas *extractors : {&data->extractors, &data->looptri_extractors}) {
+    for (const ExtractorRunData &run_data : *extractors) {
+      const MeshExtract *extractor = run_data.extractor;
+      if (extractor->task_reduce) {
+        extractor->task_reduce(POINTER_OFFSET(chunk_to, run_data.data_offset),
+                               POINTER_OFFSET(chunk_from, run_data.data_offset));
+      }
     }
   }
 }
@@ -324,6 +330,59 @@ static void extract_range_iter_poly_mesh(void *__restrict userdata,
   }
 }
 
+/* Triangles are stored per polygon, each polygon having `totloop - 2` triangles. This allows to
+ * iterate over the triangles of a polygon while iterating over the polygons, instead of iterating
+ * over all the mesh data twice. */
+static void extract_range_iter_poly_looptri_bm(void *__restrict userdata,
+                                               const int iter,
+                                               const TaskParallelTLS *__restrict tls)
+{
+  void *extract_data = tls->userdata_chunk;
+
+  const ExtractorIterData *data = static_cast<const ExtractorIterData *>(userdata);
+  const MeshRenderData *mr = data->mr;
+  const BMFace *f = ((const BMFace **)data->elems)[iter];
+  for (const ExtractorRunData &run_data : data->extractors) {
+    run_data.extractor->iter_poly_bm(
+        mr, f, iter, POINTER_OFFSET(extract_data, run_data.data_offset));
+  }
+
+  const int tri_first = poly_to_tri_count(iter, BM_elem_index_get(BM_FACE_FIRST_LOOP(f)));
+  const int tri_end = tri_first + f->len - 2;
+  for (int tri_index = tri_first; tri_index < tri_end; tri_index++) {
+    BMLoop **elt = ((BMLoop * (*)[3]) data->looptri_elems)[tri_index];
+    for (const ExtractorRunData &run_data : data->looptri_extractors) {
+      run_data.extractor->iter_looptri_bm(
+          mr, elt, tri_index, POINTER_OFFSET(extract_data, run_data.data_offset));
+    }
+  }
+}
+
+static void extract_range_iter_poly_looptri_mesh(void *__restrict userdata,
+                                                 const int iter,
+                                                 const TaskParallelTLS *__restrict tls)
+{
+  void *extract_data = tls->userdata_chunk;
+
+  const ExtractorIterData *data = static_cast<const ExtractorIterData *>(userdata);
+  const MeshRenderData *mr = data->mr;
+  const MPoly *mp = &((const MPoly *)data->elems)[iter];
+  for (const ExtractorRunData &run_data : data->extractors) {
+    run_data.extractor->iter_poly_mesh(
+        mr, mp, iter, POINTER_OFFSET(extract_data, run_data.data_offset));
+  }
+
+  const int tri_first = poly_to_tri_count(iter, mp->loopstart);
+  const int tri_end = tri_first + mp->totloop - 2;
+  for (int tri_index = tri_first; tri_index < tri_end; tri_index++) {
+    const MLoopTri *mlt = &((const MLoopTri *)data->looptri_elems)[tri_index];
+    for (const ExtractorRunData &run_data : data->looptri_extractors) {
+      run_data.extractor->iter_looptri_mesh(
+          mr, mlt, tri_index, POINTER_OFFSET(extract_data, run_data.data_offset));
+    }
+  }
+}
+
 static void extract_range_iter_ledge_bm(void *__restrict userdata,
                                         const int iter,
                                         const TaskParallelTLS *__restrict tls)
@@ -431,6 +490,24 @@ BLI_INLINE void extract_task_range_run_iter(const MeshRenderData *mr,
   BLI_task_parallel_range(0, stop, &range_data, func, settings);
 }
 
+/* Run the polygon and the triangle extractors in a single pass over the polygons. */
+BLI_INLINE void extract_task_range_run_iter_poly_looptri(const MeshRenderData *mr,
+                                                         ExtractorRunDatas *extractors,
+                                                         bool is_mesh,
+                                                         TaskParallelSettings *settings)
+{
+  ExtractorIterData range_data;
+  range_data.mr = mr;
+  range_data.elems = is_mesh ? mr->mpoly : (void *)mr->bm->ftable;
+  range_data.looptri_elems = is_mesh ? mr->mlooptri : (void *)mr->edit_bmesh->looptris;
+  TaskParallelRangeFunc func = is_mesh ? extract_range_iter_poly_looptri_mesh :
+                                         extract_range_iter_poly_looptri_bm;
+
+  extractors->filter_into(range_data.extractors, MR_ITER_POLY);
+  extractors->filter_into(range_data.looptri_extractors, MR_ITER_LOOPTRI);
+  BLI_task_parallel_range(0, mr->poly_len, &range_data, func, settings);
+}
+
 static void extract_task_range_run(void *__restrict taskdata)
 {
   ExtractTaskData *data = (ExtractTaskData *)taskdata;
@@ -450,10 +527,13 @@ static void extract_task_range_run(void *__restrict taskdata)
 
   extract_init(data->mr, data->cache, *data->extractors, data->mbc, userdata_chunk);
 
-  if (iter_type & MR_ITER_LOOPTRI) {
+  if ((iter_type & MR_ITER_LOOPTRI) && (iter_type & MR_ITER_POLY)) {
+    extract_task_range_run_iter_poly_looptri(data->mr, data->extractors, is_mesh, &settings);
+  }
+  else if (iter_type & MR_ITER_LOOPTRI) {
     extract_task_range_run_iter(data->mr, data->extractors, MR_ITER_LOOPTRI, is_mesh, &settings);
   }
-  if (iter_type & MR_ITER_POLY) {
+  else if (iter_type & MR_ITER_POLY) {
     extract_task_range_run_iter(data->mr, data->extractors, MR_ITER_POLY, is_mesh, &settings);
   }
   if (iter_type & MR_ITER_LEDGE) {
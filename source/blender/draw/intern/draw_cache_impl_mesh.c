@@ -638,6 +638,16 @@ static bool mesh_batch_cache_valid(Mesh *me)
   return true;
 }
 
+static bool mesh_has_ngons(const Mesh *me)
+{
+  for (int i = 0; i < me->totpoly; i++) {
+    if (me->mpoly[i].totloop > 4) {
+      return true;
+    }
+  }
+  return false;
+}
+
 static void mesh_batch_cache_init(Mesh *me)
 {
   MeshBatchCache *cache = me->runtime.batch_cache;
@@ -652,6 +662,7 @@ static void mesh_batch_cache_init(Mesh *me)
   cache->is_editmode = me->edit_mesh != NULL;
 
   if (cache->is_editmode == false) {
+    cache->has_ngons = mesh_has_ngons(me);
     // cache->edge_len = mesh_render_edges_len_get(me);
     // cache->tri_len = mesh_render_looptri_len_get(me);
     // cache->poly_len = mesh_render_polys_len_get(me);
@@ -784,6 +795,48 @@ static void mesh_batch_cache_discard_uvedit_select(MeshBatchCache *cache)
   mesh_batch_cache_discard_batch(cache, batch_map);
 }
 
+/**
+ * Tag the buffers depending on vertex positions to be filled again, without freeing them.
+ * Batches keep referencing the same buffers and the new data is uploaded in place, all other
+ * buffers (index buffers, UVs, vertex colors...) are reused as they are.
+ */
+static void mesh_batch_cache_tag_deform(MeshBatchCache *cache)
+{
+  /* The triangulation of n-gons depends on vertex positions, so the triangle index buffers have
+   * to be rebuilt as well. */
+  if (cache->is_editmode || cache->has_ngons) {
+    cache->is_dirty = true;
+    return;
+  }
+  FOREACH_MESH_BUFFER_CACHE (cache, mbufcache) {
+    GPUVertBuf *vbos[] = {mbufcache->vbo.pos_nor,
+                          mbufcache->vbo.lnor,
+                          mbufcache->vbo.edge_fac,
+                          mbufcache->vbo.tan,
+                          mbufcache->vbo.edituv_stretch_area,
+                          mbufcache->vbo.edituv_stretch_angle,
+                          mbufcache->vbo.mesh_analysis,
+                          mbufcache->vbo.fdots_pos,
+                          mbufcache->vbo.fdots_nor};
+    for (int i = 0; i < ARRAY_SIZE(vbos); i++) {
+      if (vbos[i] != NULL && (GPU_vertbuf_get_status(vbos[i]) & GPU_VERTBUF_INIT)) {
+        GPU_vertbuf_tag_dirty(vbos[i]);
+      }
+    }
+  }
+  /* Keep the batches, only make sure the requested ones get their vertex buffers extracted. */
+  DRWBatchFlag batch_map = MDEPS_CREATE_MAP(vbo.pos_nor,
+                                            vbo.lnor,
+                                            vbo.edge_fac,
+                                            vbo.tan,
+                                            vbo.edituv_stretch_area,
+                                            vbo.edituv_stretch_angle,
+                                            vbo.mesh_analysis,
+                                            vbo.fdots_pos,
+                                            vbo.fdots_nor);
+  cache->batch_ready &= ~batch_map;
+}
+
 void DRW_mesh_batch_cache_dirty_tag(Mesh *me, eMeshBatchDirtyMode mode)
 {
   MeshBatchCache *cache = me->runtime.batch_cache;
@@ -832,6 +885,9 @@ void DRW_mesh_batch_cache_dirty_tag(Mesh *me, eMeshBatchDirtyMode mode)
       batch_map = MDEPS_CREATE_MAP(vbo.edituv_data, vbo.fdots_edituv_data);
       mesh_batch_cache_discard_batch(cache, batch_map);
       break;
+    case BKE_MESH_BATCH_DIRTY_DEFORM:
+      mesh_batch_cache_tag_deform(cache);
+      break;
     default:
       BLI_assert(0);
   }
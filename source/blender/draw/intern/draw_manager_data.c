@@ -34,6 +34,7 @@
 #include "DNA_curve_types.h"
 #include "DNA_mesh_types.h"
 #include "DNA_meta_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BLI_alloca.h"
 #include "BLI_hash.h"
@@ -939,7 +940,7 @@ static float sculpt_debug_colors[9][4] = {
     {0.7f, 0.2f, 1.0f, 1.0f},
 };
 
-static void sculpt_draw_cb(DRWSculptCallbackData *scd, GPU_PBVH_Buffers *buffers)
+static void sculpt_draw_cb(DRWSculptCallbackData *scd, GPU_PBVH_Buffers *buffers, bool use_lod)
 {
   if (!buffers) {
     return;
@@ -950,7 +951,8 @@ static void sculpt_draw_cb(DRWSculptCallbackData *scd, GPU_PBVH_Buffers *buffers
     return;
   }
 
-  GPUBatch *geom = GPU_pbvh_buffers_batch_get(buffers, scd->fast_mode, scd->use_wire);
+  GPUBatch *geom = GPU_pbvh_buffers_batch_get(
+      buffers, scd->fast_mode || use_lod, scd->use_wire);
   short index = 0;
 
   if (scd->use_mats) {
@@ -1012,6 +1014,21 @@ static void drw_sculpt_get_frustum_planes(Object *ob, float planes[6][4])
   }
 }
 
+static void drw_sculpt_get_lod_params(Object *ob,
+                                      const RegionView3D *rv3d,
+                                      PBVHLodParams *r_lod_params)
+{
+  float persmat[4][4];
+  mul_m4_m4m4(persmat, rv3d->persmat, ob->obmat);
+  for (int i = 0; i < 4; i++) {
+    r_lod_params->persmat_w[i] = persmat[i][3];
+  }
+
+  /* PBVH bounds are in object space, the error is in pixels of the interface scale. */
+  r_lod_params->pixel_size = rv3d->pixsize * U.pixelsize / mat4_to_scale(ob->obmat);
+  r_lod_params->error_max = 1.0f;
+}
+
 static void drw_sculpt_generate_calls(DRWSculptCallbackData *scd)
 {
   /* PBVH should always exist for non-empty meshes, created by depsgraph eval. */
@@ -1056,9 +1073,10 @@ static void drw_sculpt_generate_calls(DRWSculptCallbackData *scd)
   draw_frustum.planes = draw_planes;
   draw_frustum.num_planes = 6;
 
-  /* Fast mode to show low poly multires while navigating. */
+  /* Fast mode to show low poly multires while navigating. Meshes have simplified buffers too,
+   * but they are only drawn for nodes far from the view, see #BKE_pbvh_lod_use. */
   scd->fast_mode = false;
-  if (p && (p->flags & PAINT_FAST_NAVIGATE)) {
+  if (p && (p->flags & PAINT_FAST_NAVIGATE) && BKE_pbvh_type(pbvh) == PBVH_GRIDS) {
     scd->fast_mode = rv3d && (rv3d->rflag & RV3D_NAVIGATING);
   }
 
@@ -1069,6 +1087,12 @@ static void drw_sculpt_generate_calls(DRWSculptCallbackData *scd)
     update_only_visible = true;
   }
 
+  /* Draw simplified buffers of nodes far enough from the view while navigating. */
+  PBVHLodParams lod_params;
+  if (navigating) {
+    drw_sculpt_get_lod_params(scd->ob, rv3d, &lod_params);
+  }
+
   Mesh *mesh = scd->ob->data;
   BKE_pbvh_update_normals(pbvh, mesh->runtime.subdiv_ccg);
 
@@ -1076,7 +1100,8 @@ static void drw_sculpt_generate_calls(DRWSculptCallbackData *scd)
                    update_only_visible,
                    &update_frustum,
                    &draw_frustum,
-                   (void (*)(void *, GPU_PBVH_Buffers *))sculpt_draw_cb,
+                   navigating ? &lod_params : NULL,
+                   (void (*)(void *, GPU_PBVH_Buffers *, bool))sculpt_draw_cb,
                    scd);
 
   if (SCULPT_DEBUG_BUFFERS) {
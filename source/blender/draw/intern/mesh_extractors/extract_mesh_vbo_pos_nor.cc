@@ -23,6 +23,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_task.hh"
+
 #include "draw_cache_extract_mesh_private.h"
 
 namespace blender::draw {
@@ -72,10 +74,13 @@ static void extract_pos_nor_init(const MeshRenderData *mr,
     }
   }
   else {
-    const MVert *mv = mr->mvert;
-    for (int v = 0; v < mr->vert_len; v++, mv++) {
-      data->normals[v].low = GPU_normal_convert_i10_s3(mv->no);
-    }
+    const MVert *mvert = mr->mvert;
+    GPUNormal *normals = data->normals;
+    threading::parallel_for(IndexRange(mr->vert_len), 4096, [&](IndexRange range) {
+      for (const int v : range) {
+        normals[v].low = GPU_normal_convert_i10_s3(mvert[v].no);
+      }
+    });
   }
 }
 
@@ -259,10 +264,13 @@ static void extract_pos_nor_hq_init(const MeshRenderData *mr,
     }
   }
   else {
-    const MVert *mv = mr->mvert;
-    for (int v = 0; v < mr->vert_len; v++, mv++) {
-      copy_v3_v3_short(data->normals[v].high, mv->no);
-    }
+    const MVert *mvert = mr->mvert;
+    GPUNormal *normals = data->normals;
+    threading::parallel_for(IndexRange(mr->vert_len), 4096, [&](IndexRange range) {
+      for (const int v : range) {
+        copy_v3_v3_short(normals[v].high, mvert[v].no);
+      }
+    });
   }
 }
 
@@ -0,0 +1,270 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "draw_testing.hh"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BLI_math.h"
+#include "BLI_task.h"
+
+#include "BKE_editmesh.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "GPU_batch.h"
+#include "GPU_capabilities.h"
+#include "GPU_index_buffer.h"
+#include "GPU_vertex_buffer.h"
+
+#include "intern/draw_cache_extract.h"
+#include "intern/draw_cache_impl.h"
+
+namespace blender::draw {
+
+/* Small enough for all extractors to run in a single task. */
+#define GRID_SIZE 12
+
+/* Grid where blocks of two cells are filled with a hexagon, two quads or four triangles, so that
+ * polygons have different numbers of triangles. */
+static Mesh *mesh_mixed_grid_create(const int size)
+{
+  const int row = size + 1;
+  int polys_len = 0;
+  int loops_len = 0;
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x += 2) {
+      switch ((x / 2 + y) % 3) {
+        case 0:
+          polys_len += 1;
+          loops_len += 6;
+          break;
+        case 1:
+          polys_len += 2;
+          loops_len += 8;
+          break;
+        default:
+          polys_len += 4;
+          loops_len += 12;
+          break;
+      }
+    }
+  }
+
+  Mesh *me = BKE_mesh_new_nomain(row * row, 0, 0, loops_len, polys_len);
+
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      MVert *mv = &me->mvert[y * row + x];
+      mv->co[0] = (float)x / size;
+      mv->co[1] = (float)y / size;
+      mv->co[2] = sinf((float)(x * y) * 0.3f) * 0.1f;
+    }
+  }
+
+  int poly_index = 0;
+  int loop_index = 0;
+  auto add_poly = [&](const std::initializer_list<int> verts) {
+    MPoly *mp = &me->mpoly[poly_index++];
+    mp->loopstart = loop_index;
+    mp->totloop = verts.size();
+    for (const int v : verts) {
+      me->mloop[loop_index++].v = v;
+    }
+  };
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x += 2) {
+      const int v = y * row + x;
+      switch ((x / 2 + y) % 3) {
+        case 0:
+          add_poly({v, v + 1, v + 2, v + row + 2, v + row + 1, v + row});
+          break;
+        case 1:
+          add_poly({v, v + 1, v + row + 1, v + row});
+          add_poly({v + 1, v + 2, v + row + 2, v + row + 1});
+          break;
+        default:
+          add_poly({v, v + 1, v + row + 1});
+          add_poly({v, v + row + 1, v + row});
+          add_poly({v + 1, v + 2, v + row + 2});
+          add_poly({v + 1, v + row + 2, v + row + 1});
+          break;
+      }
+    }
+  }
+
+  BKE_mesh_calc_edges(me, false, false);
+  BKE_mesh_calc_normals(me);
+  return me;
+}
+
+static Mesh *mesh_quad_grid_create(const int size)
+{
+  const int row = size + 1;
+  Mesh *me = BKE_mesh_new_nomain(row * row, 0, 0, size * size * 4, size * size);
+
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      MVert *mv = &me->mvert[y * row + x];
+      mv->co[0] = (float)x / size;
+      mv->co[1] = (float)y / size;
+    }
+  }
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int poly_index = y * size + x;
+      const int v = y * row + x;
+      const int verts[4] = {v, v + 1, v + row + 1, v + row};
+      MPoly *mp = &me->mpoly[poly_index];
+      mp->loopstart = poly_index * 4;
+      mp->totloop = 4;
+      for (int i = 0; i < 4; i++) {
+        me->mloop[mp->loopstart + i].v = verts[i];
+      }
+    }
+  }
+
+  BKE_mesh_calc_edges(me, false, false);
+  BKE_mesh_calc_normals(me);
+  return me;
+}
+
+static void mesh_extract(Mesh *me)
+{
+  Object ob = {{nullptr}};
+  ob.type = OB_MESH;
+  ob.data = me;
+  unit_m4(ob.obmat);
+  Scene scene = {{nullptr}};
+
+  struct TaskGraph *task_graph = BLI_task_graph_create();
+  DRW_mesh_batch_cache_create_requested(task_graph, &ob, me, &scene, false, false);
+  BLI_task_graph_work_and_wait(task_graph);
+  BLI_task_graph_free(task_graph);
+}
+
+static uint32_t *mesh_index_buffer_copy(GPUIndexBuf *ibo)
+{
+  /* Binding uploads the index buffer, so it can be read back. */
+  GPU_indexbuf_bind_as_ssbo(ibo, 0);
+  return GPU_indexbuf_unmap(ibo, GPU_indexbuf_read(ibo));
+}
+
+/* The vertex positions are extracted while iterating over polygons and the adjacency of edges
+ * while iterating over triangles. When both are requested, the triangles of every polygon are
+ * visited in the same pass as the polygon. This must give the same buffers as extracting them in
+ * separate passes. */
+static void test_mesh_extraction_poly_looptri()
+{
+  BKE_idtype_init();
+
+  Mesh *me_separate = mesh_mixed_grid_create(GRID_SIZE);
+  Mesh *me_single = mesh_mixed_grid_create(GRID_SIZE);
+
+  DRW_mesh_batch_cache_validate(me_separate);
+  DRW_mesh_batch_cache_get_all_verts(me_separate);
+  mesh_extract(me_separate);
+  DRW_mesh_batch_cache_get_edge_detection(me_separate, nullptr);
+  mesh_extract(me_separate);
+
+  DRW_mesh_batch_cache_validate(me_single);
+  DRW_mesh_batch_cache_get_all_verts(me_single);
+  DRW_mesh_batch_cache_get_edge_detection(me_single, nullptr);
+  mesh_extract(me_single);
+
+  MeshBatchCache *cache_separate = static_cast<MeshBatchCache *>(
+      me_separate->runtime.batch_cache);
+  MeshBatchCache *cache_single = static_cast<MeshBatchCache *>(me_single->runtime.batch_cache);
+
+  /* Vertex buffers are not uploaded yet, so their data is still available. */
+  GPUVertBuf *pos_nor_separate = cache_separate->final.vbo.pos_nor;
+  GPUVertBuf *pos_nor_single = cache_single->final.vbo.pos_nor;
+  const uint vert_len = GPU_vertbuf_get_vertex_len(pos_nor_separate);
+  ASSERT_EQ(vert_len, GPU_vertbuf_get_vertex_len(pos_nor_single));
+  ASSERT_EQ(vert_len, me_separate->totloop);
+  const uint stride = GPU_vertbuf_get_format(pos_nor_separate)->stride;
+  EXPECT_EQ(memcmp(GPU_vertbuf_get_data(pos_nor_separate),
+                   GPU_vertbuf_get_data(pos_nor_single),
+                   vert_len * stride),
+            0);
+
+  EXPECT_EQ(cache_separate->is_manifold, cache_single->is_manifold);
+
+  if (GPU_shader_storage_buffer_objects_support()) {
+    uint32_t *lines_adjacency_separate = mesh_index_buffer_copy(
+        cache_separate->final.ibo.lines_adjacency);
+    uint32_t *lines_adjacency_single = mesh_index_buffer_copy(
+        cache_single->final.ibo.lines_adjacency);
+    const size_t size = MEM_allocN_len(lines_adjacency_separate);
+    ASSERT_EQ(size, MEM_allocN_len(lines_adjacency_single));
+    EXPECT_EQ(memcmp(lines_adjacency_separate, lines_adjacency_single, size), 0);
+    MEM_freeN(lines_adjacency_separate);
+    MEM_freeN(lines_adjacency_single);
+  }
+
+  DRW_mesh_batch_cache_free(me_separate);
+  DRW_mesh_batch_cache_free(me_single);
+  BKE_id_free(nullptr, me_separate);
+  BKE_id_free(nullptr, me_single);
+}
+DRAW_TEST(mesh_extraction_poly_looptri)
+
+/* Deforming a mesh without n-gons only extracts the positions again. The batches keep using the
+ * same vertex buffer, which has to contain the deformed positions once it is uploaded. */
+static void test_mesh_extraction_deform()
+{
+  BKE_idtype_init();
+
+  Mesh *me = mesh_quad_grid_create(GRID_SIZE);
+
+  DRW_mesh_batch_cache_validate(me);
+  GPUBatch *surface = DRW_mesh_batch_cache_get_surface(me);
+  mesh_extract(me);
+
+  MeshBatchCache *cache = static_cast<MeshBatchCache *>(me->runtime.batch_cache);
+  GPUVertBuf *pos_nor = cache->final.vbo.pos_nor;
+  ASSERT_EQ(surface->verts[0], pos_nor);
+  GPU_vertbuf_use(pos_nor);
+
+  for (int i = 0; i < me->totvert; i++) {
+    me->mvert[i].co[2] = sinf((float)i * 0.3f) * 0.1f;
+  }
+  BKE_mesh_calc_normals(me);
+  DRW_mesh_batch_cache_dirty_tag(me, BKE_MESH_BATCH_DIRTY_DEFORM);
+
+  DRW_mesh_batch_cache_validate(me);
+  EXPECT_EQ(DRW_mesh_batch_cache_get_surface(me), surface);
+  mesh_extract(me);
+  ASSERT_EQ(me->runtime.batch_cache, cache);
+  EXPECT_EQ(surface->verts[0], pos_nor);
+  EXPECT_EQ(cache->final.vbo.pos_nor, pos_nor);
+
+  GPU_vertbuf_use(pos_nor);
+  ASSERT_EQ(GPU_vertbuf_get_vertex_len(pos_nor), me->totloop);
+  const uint stride = GPU_vertbuf_get_format(pos_nor)->stride;
+  const char *data = static_cast<const char *>(
+      GPU_vertbuf_unmap(pos_nor, GPU_vertbuf_read(pos_nor)));
+  for (int i = 0; i < me->totloop; i++) {
+    const float *co = reinterpret_cast<const float *>(data + i * stride);
+    const float *co_expected = me->mvert[me->mloop[i].v].co;
+    EXPECT_EQ(co[0], co_expected[0]);
+    EXPECT_EQ(co[1], co_expected[1]);
+    EXPECT_EQ(co[2], co_expected[2]);
+  }
+  MEM_freeN((void *)data);
+
+  DRW_mesh_batch_cache_free(me);
+  BKE_id_free(nullptr, me);
+}
+DRAW_TEST(mesh_extraction_deform)
+
+}  // namespace blender::draw
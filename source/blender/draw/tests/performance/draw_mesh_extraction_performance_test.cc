@@ -0,0 +1,100 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "draw_testing.hh"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BLI_math.h"
+#include "BLI_task.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "PIL_time_utildefines.h"
+
+#include "intern/draw_cache_impl.h"
+
+namespace blender::draw {
+
+/* Number of quads along each side of the benchmark grid, for 5M faces. */
+#define GRID_SIZE 2237
+#define NUM_RUN_AVERAGED 5
+
+static Mesh *mesh_grid_create(const int size)
+{
+  const int verts_len = (size + 1) * (size + 1);
+  const int polys_len = size * size;
+  Mesh *me = BKE_mesh_new_nomain(verts_len, 0, 0, polys_len * 4, polys_len);
+
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++) {
+      MVert *mv = &me->mvert[y * (size + 1) + x];
+      mv->co[0] = (float)x / size;
+      mv->co[1] = (float)y / size;
+      mv->co[2] = sinf((float)(x + y) * 0.1f) * 0.01f;
+    }
+  }
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int p = y * size + x;
+      const int v = y * (size + 1) + x;
+      MPoly *mp = &me->mpoly[p];
+      mp->loopstart = p * 4;
+      mp->totloop = 4;
+      MLoop *ml = &me->mloop[p * 4];
+      ml[0].v = v;
+      ml[1].v = v + 1;
+      ml[2].v = v + size + 2;
+      ml[3].v = v + size + 1;
+    }
+  }
+
+  BKE_mesh_calc_edges(me, false, false);
+  BKE_mesh_calc_normals(me);
+  return me;
+}
+
+/* Measures the time to extract the buffers of the surface batch, which is what is extracted for
+ * every mesh in solid mode. Only the extraction on the CPU is timed, the buffers are not sent to
+ * the GPU. */
+static void test_mesh_extraction_surface()
+{
+  BKE_idtype_init();
+
+  Mesh *me = mesh_grid_create(GRID_SIZE);
+  Object ob = {{nullptr}};
+  ob.type = OB_MESH;
+  ob.data = me;
+  unit_m4(ob.obmat);
+  Scene scene = {{nullptr}};
+
+  printf("Extracting mesh with %d faces, %d loops\n", me->totpoly, me->totloop);
+
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    DRW_mesh_batch_cache_validate(me);
+    DRW_mesh_batch_cache_get_surface(me);
+
+    struct TaskGraph *task_graph = BLI_task_graph_create();
+    TIMEIT_START_AVERAGED(mesh_extraction_surface);
+    DRW_mesh_batch_cache_create_requested(task_graph, &ob, me, &scene, false, false);
+    BLI_task_graph_work_and_wait(task_graph);
+    TIMEIT_END_AVERAGED(mesh_extraction_surface);
+    BLI_task_graph_free(task_graph);
+
+    DRW_mesh_batch_cache_free(me);
+  }
+
+  BKE_id_free(nullptr, me);
+}
+DRAW_TEST(mesh_extraction_surface)
+
+}  // namespace blender::draw
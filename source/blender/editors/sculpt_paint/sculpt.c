@@ -31,6 +31,7 @@
 #include "BLI_hash.h"
 #include "BLI_math.h"
 #include "BLI_math_color_blend.h"
+#include "BLI_string.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 
@@ -50,6 +51,7 @@
 #include "BKE_ccg.h"
 #include "BKE_colortools.h"
 #include "BKE_context.h"
+#include "BKE_global.h"
 #include "BKE_image.h"
 #include "BKE_kelvinlet.h"
 #include "BKE_key.h"
@@ -2560,6 +2562,176 @@ float SCULPT_brush_strength_factor(SculptSession *ss,
   return avg;
 }
 
+void SCULPT_brush_batch_init(SculptBrushBatch *batch, const Brush *br, const bool use_normals)
+{
+  batch->len = 0;
+  batch->use_normals = use_normals || (br->flag & BRUSH_FRONTFACE);
+}
+
+bool SCULPT_brush_batch_add(SculptBrushBatch *batch, const PBVHVertexIter *vd, const float dist_sq)
+{
+  BLI_assert(batch->len < SCULPT_BRUSH_BATCH_SIZE);
+  const int i = batch->len++;
+
+  copy_v3_v3(batch->co[i], vd->co);
+  if (batch->use_normals) {
+    if (vd->no) {
+      normal_short_to_float_v3(batch->no[i], vd->no);
+    }
+    else {
+      copy_v3_v3(batch->no[i], vd->fno);
+    }
+  }
+  batch->dist_sq[i] = dist_sq;
+  batch->mask[i] = vd->mask ? *vd->mask : 0.0f;
+  batch->vertex_index[i] = vd->index;
+  batch->node_index[i] = vd->i;
+  batch->mvert[i] = vd->mvert;
+
+  return batch->len == SCULPT_BRUSH_BATCH_SIZE;
+}
+
+/* Same as #BKE_brush_curve_strength for all values, which are distances divided by the radius.
+ * The preset is resolved once so the loops over the values can be vectorized. */
+static void sculpt_brush_curve_strength_batch(const Brush *br, float *values, const int len)
+{
+  switch (br->curve_preset) {
+    case BRUSH_CURVE_CUSTOM:
+      for (int i = 0; i < len; i++) {
+        values[i] = values[i] >= 1.0f ? 0.0f : BKE_curvemapping_evaluateF(br->curve, 0, values[i]);
+      }
+      return;
+    case BRUSH_CURVE_SHARP:
+      for (int i = 0; i < len; i++) {
+        const float p = 1.0f - values[i];
+        values[i] = values[i] >= 1.0f ? 0.0f : p * p;
+      }
+      return;
+    case BRUSH_CURVE_SMOOTH:
+      for (int i = 0; i < len; i++) {
+        const float p = 1.0f - values[i];
+        values[i] = values[i] >= 1.0f ? 0.0f : 3.0f * p * p - 2.0f * p * p * p;
+      }
+      return;
+    case BRUSH_CURVE_SMOOTHER:
+      for (int i = 0; i < len; i++) {
+        const float p = 1.0f - values[i];
+        values[i] = values[i] >= 1.0f ? 0.0f : pow3f(p) * (p * (p * 6.0f - 15.0f) + 10.0f);
+      }
+      return;
+    case BRUSH_CURVE_ROOT:
+      for (int i = 0; i < len; i++) {
+        const float p = 1.0f - values[i];
+        values[i] = values[i] >= 1.0f ? 0.0f : sqrtf(p);
+      }
+      return;
+    case BRUSH_CURVE_LIN:
+      for (int i = 0; i < len; i++) {
+        const float p = 1.0f - values[i];
+        values[i] = values[i] >= 1.0f ? 0.0f : p;
+      }
+      return;
+    case BRUSH_CURVE_CONSTANT:
+      for (int i = 0; i < len; i++) {
+        values[i] = values[i] >= 1.0f ? 0.0f : 1.0f;
+      }
+      return;
+    case BRUSH_CURVE_SPHERE:
+      for (int i = 0; i < len; i++) {
+        const float p = 1.0f - values[i];
+        values[i] = values[i] >= 1.0f ? 0.0f : sqrtf(2 * p - p * p);
+      }
+      return;
+    case BRUSH_CURVE_POW4:
+      for (int i = 0; i < len; i++) {
+        const float p = 1.0f - values[i];
+        values[i] = values[i] >= 1.0f ? 0.0f : p * p * p * p;
+      }
+      return;
+    case BRUSH_CURVE_INVSQUARE:
+      for (int i = 0; i < len; i++) {
+        const float p = 1.0f - values[i];
+        values[i] = values[i] >= 1.0f ? 0.0f : p * (2.0f - p);
+      }
+      return;
+  }
+
+  for (int i = 0; i < len; i++) {
+    values[i] = values[i] >= 1.0f ? 0.0f : 1.0f;
+  }
+}
+
+void SCULPT_brush_strength_factor_batch(SculptSession *ss,
+                                        const Brush *br,
+                                        SculptBrushBatch *batch,
+                                        const int thread_id)
+{
+  StrokeCache *cache = ss->cache;
+  const int len = batch->len;
+  float *fade = batch->fade;
+
+  /* Textures are sampled per vertex. */
+  if (br->mtex.tex) {
+    for (int i = 0; i < len; i++) {
+      fade[i] = SCULPT_brush_strength_factor(ss,
+                                             br,
+                                             batch->co[i],
+                                             sqrtf(batch->dist_sq[i]),
+                                             NULL,
+                                             batch->no[i],
+                                             batch->mask[i],
+                                             batch->vertex_index[i],
+                                             thread_id);
+    }
+    return;
+  }
+
+  /* Hardness, as a distance divided by the radius. */
+  const float radius_inv = 1.0f / cache->radius;
+  const float hardness = cache->paint_brush.hardness;
+  if (hardness == 1.0f) {
+    for (int i = 0; i < len; i++) {
+      fade[i] = sqrtf(batch->dist_sq[i]) * radius_inv < hardness ? 0.0f : 1.0f;
+    }
+  }
+  else {
+    const float hardness_scale = 1.0f / (1.0f - hardness);
+    for (int i = 0; i < len; i++) {
+      const float p = sqrtf(batch->dist_sq[i]) * radius_inv;
+      fade[i] = p < hardness ? 0.0f : (p - hardness) * hardness_scale;
+    }
+  }
+
+  /* Falloff curve. */
+  sculpt_brush_curve_strength_batch(br, fade, len);
+
+  if (br->flag & BRUSH_FRONTFACE) {
+    const float *view_normal = cache->view_normal;
+    for (int i = 0; i < len; i++) {
+      const float dot = dot_v3v3(batch->no[i], view_normal);
+      fade[i] *= dot > 0.0f ? dot : 0.0f;
+    }
+  }
+
+  /* Paint mask. */
+  for (int i = 0; i < len; i++) {
+    fade[i] *= 1.0f - batch->mask[i];
+  }
+
+  /* Auto-masking. */
+  AutomaskingCache *automasking = cache->automasking;
+  if (automasking && automasking->factor) {
+    for (int i = 0; i < len; i++) {
+      fade[i] *= automasking->factor[batch->vertex_index[i]];
+    }
+  }
+  else if (automasking) {
+    for (int i = 0; i < len; i++) {
+      fade[i] *= SCULPT_automasking_factor_get(automasking, ss, batch->vertex_index[i]);
+    }
+  }
+}
+
 /* Test AABB against sphere. */
 bool SCULPT_search_sphere_cb(PBVHNode *node, void *data_v)
 {
@@ -3259,6 +3431,26 @@ static void do_displacement_smear_brush(Sculpt *sd, Object *ob, PBVHNode **nodes
 
 /** \} */
 
+/* Offsets the vertices of the batch. */
+static void do_draw_brush_batch_apply(SculptSession *ss,
+                                      const Brush *brush,
+                                      SculptBrushBatch *batch,
+                                      const float offset[3],
+                                      float (*proxy)[3],
+                                      const int thread_id)
+{
+  SCULPT_brush_strength_factor_batch(ss, brush, batch, thread_id);
+
+  for (int i = 0; i < batch->len; i++) {
+    mul_v3_v3fl(proxy[batch->node_index[i]], offset, batch->fade[i]);
+
+    if (batch->mvert[i]) {
+      batch->mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+  batch->len = 0;
+}
+
 static void do_draw_brush_task_cb_ex(void *__restrict userdata,
                                      const int n,
                                      const TaskParallelTLS *__restrict tls)
@@ -3278,28 +3470,20 @@ static void do_draw_brush_task_cb_ex(void *__restrict userdata,
       ss, &test, data->brush->falloff_shape);
   const int thread_id = BLI_task_parallel_thread_id(tls);
 
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, brush, false);
+
   BKE_pbvh_vertex_iter_begin (ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE) {
     if (!sculpt_brush_test_sq_fn(&test, vd.co)) {
       continue;
     }
-    /* Offset vertex. */
-    const float fade = SCULPT_brush_strength_factor(ss,
-                                                    brush,
-                                                    vd.co,
-                                                    sqrtf(test.dist),
-                                                    vd.no,
-                                                    vd.fno,
-                                                    vd.mask ? *vd.mask : 0.0f,
-                                                    vd.index,
-                                                    thread_id);
-
-    mul_v3_v3fl(proxy[vd.i], offset, fade);
-
-    if (vd.mvert) {
-      vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
+    if (SCULPT_brush_batch_add(&batch, &vd, test.dist)) {
+      do_draw_brush_batch_apply(ss, brush, &batch, offset, proxy, thread_id);
     }
   }
   BKE_pbvh_vertex_iter_end;
+
+  do_draw_brush_batch_apply(ss, brush, &batch, offset, proxy, thread_id);
 }
 
 static void do_draw_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -4779,6 +4963,29 @@ static void do_layer_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode
   BLI_task_parallel_range(0, totnode, &data, do_layer_brush_task_cb_ex, &settings);
 }
 
+/* Offsets the vertices of the batch along their normals. */
+static void do_inflate_brush_batch_apply(SculptSession *ss,
+                                         const Brush *brush,
+                                         SculptBrushBatch *batch,
+                                         float (*proxy)[3],
+                                         const int thread_id)
+{
+  const float bstrength = ss->cache->bstrength;
+
+  SCULPT_brush_strength_factor_batch(ss, brush, batch, thread_id);
+
+  for (int i = 0; i < batch->len; i++) {
+    float val[3];
+    mul_v3_v3fl(val, batch->no[i], bstrength * batch->fade[i] * ss->cache->radius);
+    mul_v3_v3v3(proxy[batch->node_index[i]], val, ss->cache->scale);
+
+    if (batch->mvert[i]) {
+      batch->mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+  batch->len = 0;
+}
+
 static void do_inflate_brush_task_cb_ex(void *__restrict userdata,
                                         const int n,
                                         const TaskParallelTLS *__restrict tls)
@@ -4789,7 +4996,6 @@ static void do_inflate_brush_task_cb_ex(void *__restrict userdata,
 
   PBVHVertexIter vd;
   float(*proxy)[3];
-  const float bstrength = ss->cache->bstrength;
 
   proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
 
@@ -4798,36 +5004,20 @@ static void do_inflate_brush_task_cb_ex(void *__restrict userdata,
       ss, &test, data->brush->falloff_shape);
   const int thread_id = BLI_task_parallel_thread_id(tls);
 
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, brush, true);
+
   BKE_pbvh_vertex_iter_begin (ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE) {
     if (!sculpt_brush_test_sq_fn(&test, vd.co)) {
       continue;
     }
-    const float fade = bstrength * SCULPT_brush_strength_factor(ss,
-                                                                brush,
-                                                                vd.co,
-                                                                sqrtf(test.dist),
-                                                                vd.no,
-                                                                vd.fno,
-                                                                vd.mask ? *vd.mask : 0.0f,
-                                                                vd.index,
-                                                                thread_id);
-    float val[3];
-
-    if (vd.fno) {
-      copy_v3_v3(val, vd.fno);
-    }
-    else {
-      normal_short_to_float_v3(val, vd.no);
-    }
-
-    mul_v3_fl(val, fade * ss->cache->radius);
-    mul_v3_v3v3(proxy[vd.i], val, ss->cache->scale);
-
-    if (vd.mvert) {
-      vd.mvert->flag |= ME_VERT_PBVH_UPDATE;
+    if (SCULPT_brush_batch_add(&batch, &vd, test.dist)) {
+      do_inflate_brush_batch_apply(ss, brush, &batch, proxy, thread_id);
     }
   }
   BKE_pbvh_vertex_iter_end;
+
+  do_inflate_brush_batch_apply(ss, brush, &batch, proxy, thread_id);
 }
 
 static void do_inflate_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
@@ -5910,6 +6100,8 @@ static void do_brush_action(Sculpt *sd, Object *ob, Brush *brush, UnifiedPaintSe
 
   /* Build a list of all nodes that are potentially within the brush's area of influence */
 
+  double time = PIL_check_seconds_timer();
+
   if (SCULPT_tool_needs_all_pbvh_nodes(brush)) {
     /* These brushes need to update all nodes as they are not constrained by the brush radius */
     BKE_pbvh_search_gather(ss->pbvh, NULL, NULL, &nodes, &totnode);
@@ -5929,6 +6121,8 @@ static void do_brush_action(Sculpt *sd, Object *ob, Brush *brush, UnifiedPaintSe
     nodes = sculpt_pbvh_gather_generic(ob, sd, brush, use_original, radius_scale, &totnode);
   }
 
+  ss->cache->dab_time.search += PIL_check_seconds_timer() - time;
+
   /* Draw Face Sets in draw mode makes a single undo push, in alt-smooth mode deforms the
    * vertices and uses regular coords undo. */
   /* It also assigns the paint_face_set here as it needs to be done regardless of the stroke type
@@ -5977,10 +6171,16 @@ static void do_brush_action(Sculpt *sd, Object *ob, Brush *brush, UnifiedPaintSe
       .nodes = nodes,
   };
 
+  time = PIL_check_seconds_timer();
+
   TaskParallelSettings settings;
   BKE_pbvh_parallel_range_settings(&settings, true, totnode);
   BLI_task_parallel_range(0, totnode, &task_data, do_brush_action_task_cb, &settings);
 
+  const double time_undo_end = PIL_check_seconds_timer();
+  ss->cache->dab_time.undo += time_undo_end - time;
+  time = time_undo_end;
+
   if (sculpt_brush_needs_normal(ss, brush)) {
     update_sculpt_normal(sd, ob, nodes, totnode);
   }
@@ -6148,6 +6348,8 @@ static void do_brush_action(Sculpt *sd, Object *ob, Brush *brush, UnifiedPaintSe
     }
   }
 
+  ss->cache->dab_time.brush += PIL_check_seconds_timer() - time;
+
   MEM_SAFE_FREE(nodes);
 
   /* Update average stroke position. */
@@ -7855,6 +8057,8 @@ void SCULPT_flush_update_done(const bContext *C, Object *ob, SculptUpdateType up
   }
 
   if (need_tag) {
+    /* Only vertex data was modified, the PBVH can be kept. */
+    ss->refit_pbvh_on_update = true;
     DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
   }
 }
@@ -7887,6 +8091,9 @@ static bool sculpt_stroke_test_start(bContext *C, struct wmOperator *op, const f
 
     sculpt_update_cache_invariants(C, sd, ss, op, mouse);
 
+    /* Only report normal updates made during the stroke. */
+    BKE_pbvh_normals_update_time_take(ss->pbvh);
+
     SCULPT_undo_push_begin(ob, sculpt_tool_name(sd));
 
     return true;
@@ -7894,6 +8101,37 @@ static bool sculpt_stroke_test_start(bContext *C, struct wmOperator *op, const f
   return false;
 }
 
+static void sculpt_dab_time_print(const char *name, const SculptDabTime *dab_time)
+{
+  printf("%s: search %.3f ms, brush %.3f ms, normals %.3f ms, undo %.3f ms\n",
+         name,
+         dab_time->search * 1000.0,
+         dab_time->brush * 1000.0,
+         dab_time->normals * 1000.0,
+         dab_time->undo * 1000.0);
+}
+
+/* Reports the time of the dab and adds it to the time of the stroke. */
+static void sculpt_dab_time_report(SculptSession *ss)
+{
+  StrokeCache *cache = ss->cache;
+
+  /* Normals are updated when drawing, the time of those updates since the previous dab is
+   * reported. There are none in background mode. */
+  cache->dab_time.normals += BKE_pbvh_normals_update_time_take(ss->pbvh);
+
+  char name[32];
+  BLI_snprintf(name, sizeof(name), "Sculpt dab %d", cache->dabs_num);
+  sculpt_dab_time_print(name, &cache->dab_time);
+
+  cache->stroke_time.search += cache->dab_time.search;
+  cache->stroke_time.brush += cache->dab_time.brush;
+  cache->stroke_time.normals += cache->dab_time.normals;
+  cache->stroke_time.undo += cache->dab_time.undo;
+  cache->dabs_num++;
+  memset(&cache->dab_time, 0, sizeof(cache->dab_time));
+}
+
 static void sculpt_stroke_update_step(bContext *C,
                                       struct PaintStroke *UNUSED(stroke),
                                       PointerRNA *itemptr)
@@ -7922,11 +8160,16 @@ static void sculpt_stroke_update_step(bContext *C,
   }
 
   if (SCULPT_stroke_is_dynamic_topology(ss, brush)) {
+    const double time = PIL_check_seconds_timer();
     do_symmetrical_brush_actions(sd, ob, sculpt_topology_update, ups);
+    ss->cache->dab_time.brush += PIL_check_seconds_timer() - time;
   }
 
   do_symmetrical_brush_actions(sd, ob, do_brush_action, ups);
+
+  const double time = PIL_check_seconds_timer();
   sculpt_combine_proxies(sd, ob);
+  ss->cache->dab_time.brush += PIL_check_seconds_timer() - time;
 
   /* Hack to fix noise texture tearing mesh. */
   sculpt_fix_noise_tear(sd, ob);
@@ -7961,6 +8204,10 @@ static void sculpt_stroke_update_step(bContext *C,
   else {
     SCULPT_flush_update_step(C, SCULPT_UPDATE_COORDS);
   }
+
+  if (G.debug & G_DEBUG_SCULPT_TIME) {
+    sculpt_dab_time_report(ss);
+  }
 }
 
 static void sculpt_brush_exit_tex(Sculpt *sd)
@@ -8019,11 +8266,21 @@ static void sculpt_stroke_done(const bContext *C, struct PaintStroke *UNUSED(str
   }
 
   BKE_pbvh_node_color_buffer_free(ss->pbvh);
+  SculptDabTime stroke_time = ss->cache->stroke_time;
+  const int dabs_num = ss->cache->dabs_num;
   SCULPT_cache_free(ss->cache);
   ss->cache = NULL;
 
+  const double time = PIL_check_seconds_timer();
   SCULPT_undo_push_end();
 
+  if (G.debug & G_DEBUG_SCULPT_TIME) {
+    stroke_time.undo += PIL_check_seconds_timer() - time;
+    char name[32];
+    BLI_snprintf(name, sizeof(name), "Sculpt stroke of %d dabs", dabs_num);
+    sculpt_dab_time_print(name, &stroke_time);
+  }
+
   if (brush->sculpt_tool == SCULPT_TOOL_MASK) {
     SCULPT_flush_update_done(C, ob, SCULPT_UPDATE_MASK);
   }
@@ -36,6 +36,10 @@
 #include "BKE_paint.h"
 #include "BKE_pbvh.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct AutomaskingCache;
 struct KeyBlock;
 struct Object;
@@ -672,6 +676,9 @@ typedef struct SculptUndoNode {
   /* Sculpt Face Sets */
   int *face_sets;
 
+  /* Per vertex arrays of the node while its step is not being pushed or restored. */
+  struct SculptUndoNodeCompressed *compressed;
+
   size_t undo_size;
 } SculptUndoNode;
 
@@ -869,6 +876,42 @@ float SCULPT_brush_strength_factor(struct SculptSession *ss,
                                    const int vertex_index,
                                    const int thread_id);
 
+/* Batched evaluation of the brush strength factor. Brushes gather the vertices that pass the
+ * brush test and evaluate the factor of all of them at once, so the falloff curve, mask and
+ * automasking are applied with loops the compiler can vectorize. */
+#define SCULPT_BRUSH_BATCH_SIZE 64
+
+typedef struct SculptBrushBatch {
+  int len;
+  /* Normals are gathered when the brush needs them or uses front faces only. */
+  bool use_normals;
+
+  float co[SCULPT_BRUSH_BATCH_SIZE][3];
+  float no[SCULPT_BRUSH_BATCH_SIZE][3];
+  /* Squared distance from the brush test. */
+  float dist_sq[SCULPT_BRUSH_BATCH_SIZE];
+  float mask[SCULPT_BRUSH_BATCH_SIZE];
+  int vertex_index[SCULPT_BRUSH_BATCH_SIZE];
+  /* Index of the vertex in its node, for writing to proxies. */
+  int node_index[SCULPT_BRUSH_BATCH_SIZE];
+  struct MVert *mvert[SCULPT_BRUSH_BATCH_SIZE];
+
+  /* Strength factors, written by #SCULPT_brush_strength_factor_batch. */
+  float fade[SCULPT_BRUSH_BATCH_SIZE];
+} SculptBrushBatch;
+
+void SCULPT_brush_batch_init(SculptBrushBatch *batch,
+                             const struct Brush *br,
+                             const bool use_normals);
+/* Returns true when the batch is full and has to be evaluated. */
+bool SCULPT_brush_batch_add(SculptBrushBatch *batch,
+                            const PBVHVertexIter *vd,
+                            const float dist_sq);
+void SCULPT_brush_strength_factor_batch(struct SculptSession *ss,
+                                        const struct Brush *br,
+                                        SculptBrushBatch *batch,
+                                        const int thread_id);
+
 /* Tilts a normal by the x and y tilt values using the view axis. */
 void SCULPT_tilt_apply_to_normal(float r_normal[3],
                                  struct StrokeCache *cache,
@@ -906,6 +949,14 @@ typedef struct AutomaskingCache {
   float *factor;
 } AutomaskingCache;
 
+/* Time spent in the stages of sculpt dabs, in seconds. */
+typedef struct SculptDabTime {
+  double search;
+  double brush;
+  double normals;
+  double undo;
+} SculptDabTime;
+
 typedef struct StrokeCache {
   /* Invariants */
   float initial_radius;
@@ -1066,6 +1117,12 @@ typedef struct StrokeCache {
   rcti previous_r; /* previous redraw rectangle */
   rcti current_r;  /* current redraw rectangle */
 
+  /* Timing of the current dab and of all dabs of the stroke, reported with
+   * `--debug-sculpt-time`. */
+  SculptDabTime dab_time;
+  SculptDabTime stroke_time;
+  int dabs_num;
+
 } StrokeCache;
 
 /* Sculpt Filters */
@@ -1370,3 +1427,7 @@ void SCULPT_OT_dyntopo_detail_size_edit(struct wmOperatorType *ot);
 
 /* Dyntopo. */
 void SCULPT_OT_dynamic_topology_toggle(struct wmOperatorType *ot);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2021 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+
+#include "DNA_brush_types.h"
+#include "DNA_genfile.h"
+#include "DNA_scene_types.h"
+#include "DNA_texture_types.h"
+
+#include "BKE_appdir.h"
+#include "BKE_blender.h"
+#include "BKE_brush.h"
+#include "BKE_colortools.h"
+#include "BKE_global.h"
+#include "BKE_idtype.h"
+#include "BKE_main.h"
+#include "BKE_scene.h"
+#include "BKE_texture.h"
+
+#include "ED_view3d.h"
+
+#include "CLG_log.h"
+
+#include "sculpt_intern.h"
+
+namespace blender::ed::sculpt_paint::tests {
+
+/* More vertices than fit in a batch, so batches are evaluated full and partially filled. */
+static const int VERTS_NUM = SCULPT_BRUSH_BATCH_SIZE * 3 + 7;
+
+class SculptBrushBatchTest : public testing::Test {
+ protected:
+  Main *bmain = nullptr;
+  Brush *brush = nullptr;
+  ViewContext vc = {nullptr};
+  StrokeCache cache;
+  SculptSession ss;
+  AutomaskingCache automasking;
+
+  /* Vertices in a cube around the brush at the origin, some of them outside of its radius. */
+  float co[VERTS_NUM][3];
+  short no[VERTS_NUM][3];
+  float fno[VERTS_NUM][3];
+  float mask[VERTS_NUM];
+  float automasking_factor[VERTS_NUM];
+
+ public:
+  static void SetUpTestCase()
+  {
+    testing::Test::SetUpTestCase();
+
+    CLG_init();
+    BLI_threadapi_init();
+
+    DNA_sdna_current_init();
+    BKE_blender_globals_init();
+
+    BKE_idtype_init();
+    BKE_appdir_init();
+
+    G.background = true;
+    G.factory_startup = true;
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_blender_free();
+
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+
+    BKE_blender_atexit();
+
+    BKE_tempdir_session_purge();
+    BKE_appdir_exit();
+    CLG_exit();
+
+    testing::Test::TearDownTestCase();
+  }
+
+ protected:
+  void SetUp() override
+  {
+    bmain = BKE_main_new();
+    vc.scene = BKE_scene_add(bmain, "Scene");
+    brush = BKE_brush_add(bmain, "Brush", OB_MODE_SCULPT);
+    BKE_curvemapping_init(brush->curve);
+
+    memset(&cache, 0, sizeof(cache));
+    cache.vc = &vc;
+    cache.radius = 1.0f;
+    cache.paint_brush.hardness = 0.0f;
+    copy_v3_fl3(cache.view_normal, 0.0f, 0.0f, 1.0f);
+
+    memset(&ss, 0, sizeof(ss));
+    ss.cache = &cache;
+
+    memset(&automasking, 0, sizeof(automasking));
+
+    RNG *rng = BLI_rng_new(0);
+    for (int i = 0; i < VERTS_NUM; i++) {
+      for (int j = 0; j < 3; j++) {
+        co[i][j] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+        fno[i][j] = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+      }
+      normalize_v3(fno[i]);
+      normal_float_to_short_v3(no[i], fno[i]);
+      mask[i] = BLI_rng_get_float(rng);
+      automasking_factor[i] = BLI_rng_get_float(rng);
+    }
+    BLI_rng_free(rng);
+  }
+
+  void TearDown() override
+  {
+    BKE_main_free(bmain);
+  }
+
+  /* Evaluate the batch and compare it to the factor of each vertex. */
+  void expect_batch_apply(SculptBrushBatch *batch, const bool use_short_normals)
+  {
+    SCULPT_brush_strength_factor_batch(&ss, brush, batch, 0);
+
+    for (int i = 0; i < batch->len; i++) {
+      const int v = batch->vertex_index[i];
+      const float fade = SCULPT_brush_strength_factor(&ss,
+                                                      brush,
+                                                      co[v],
+                                                      len_v3(co[v]),
+                                                      use_short_normals ? no[v] : nullptr,
+                                                      use_short_normals ? nullptr : fno[v],
+                                                      mask[v],
+                                                      v,
+                                                      0);
+      EXPECT_NEAR(batch->fade[i], fade, 1e-5f) << "Vertex " << v;
+    }
+    batch->len = 0;
+  }
+
+  /* Gather all vertices in batches like brushes do, from mesh or grid vertex iterators. */
+  void expect_batch_matches_scalar(const bool use_short_normals)
+  {
+    SculptBrushBatch batch;
+    SCULPT_brush_batch_init(&batch, brush, false);
+
+    for (int v = 0; v < VERTS_NUM; v++) {
+      PBVHVertexIter vd;
+      memset(&vd, 0, sizeof(vd));
+      vd.co = co[v];
+      if (use_short_normals) {
+        vd.no = no[v];
+      }
+      else {
+        vd.fno = fno[v];
+      }
+      vd.mask = &mask[v];
+      vd.index = v;
+      vd.i = v;
+
+      if (SCULPT_brush_batch_add(&batch, &vd, len_squared_v3(co[v]))) {
+        expect_batch_apply(&batch, use_short_normals);
+      }
+    }
+    expect_batch_apply(&batch, use_short_normals);
+  }
+};
+
+TEST_F(SculptBrushBatchTest, curve_presets)
+{
+  const eBrushCurvePreset presets[] = {BRUSH_CURVE_CUSTOM,
+                                       BRUSH_CURVE_SMOOTH,
+                                       BRUSH_CURVE_SPHERE,
+                                       BRUSH_CURVE_ROOT,
+                                       BRUSH_CURVE_SHARP,
+                                       BRUSH_CURVE_LIN,
+                                       BRUSH_CURVE_POW4,
+                                       BRUSH_CURVE_INVSQUARE,
+                                       BRUSH_CURVE_CONSTANT,
+                                       BRUSH_CURVE_SMOOTHER};
+  for (const eBrushCurvePreset preset : presets) {
+    SCOPED_TRACE(preset);
+    brush->curve_preset = preset;
+    expect_batch_matches_scalar(true);
+  }
+}
+
+TEST_F(SculptBrushBatchTest, hardness)
+{
+  for (const float hardness : {0.25f, 0.5f, 1.0f}) {
+    SCOPED_TRACE(hardness);
+    cache.paint_brush.hardness = hardness;
+    expect_batch_matches_scalar(true);
+  }
+}
+
+TEST_F(SculptBrushBatchTest, frontface)
+{
+  brush->flag |= BRUSH_FRONTFACE;
+  expect_batch_matches_scalar(true);
+  expect_batch_matches_scalar(false);
+}
+
+/* Random masks, and no mask which keeps the full strength. */
+TEST_F(SculptBrushBatchTest, mask)
+{
+  expect_batch_matches_scalar(true);
+
+  for (int i = 0; i < VERTS_NUM; i++) {
+    mask[i] = 0.0f;
+  }
+  expect_batch_matches_scalar(true);
+}
+
+TEST_F(SculptBrushBatchTest, automasking)
+{
+  /* Precomputed factors, as used by topology and face sets auto-masking. */
+  automasking.factor = automasking_factor;
+  cache.automasking = &automasking;
+  expect_batch_matches_scalar(true);
+
+  /* Auto-masking evaluated per vertex, without any of the options needing the mesh. */
+  automasking.factor = nullptr;
+  expect_batch_matches_scalar(true);
+}
+
+TEST_F(SculptBrushBatchTest, texture)
+{
+  Tex *tex = BKE_texture_add(bmain, "Texture");
+  tex->type = TEX_CLOUDS;
+  brush->mtex.tex = tex;
+  brush->mtex.brush_map_mode = MTEX_MAP_MODE_3D;
+
+  automasking.factor = automasking_factor;
+  cache.automasking = &automasking;
+  cache.paint_brush.hardness = 0.5f;
+  brush->flag |= BRUSH_FRONTFACE;
+
+  expect_batch_matches_scalar(true);
+  expect_batch_matches_scalar(false);
+}
+
+}  // namespace blender::ed::sculpt_paint::tests
@@ -70,6 +70,8 @@
 #include "bmesh.h"
 #include "sculpt_intern.h"
 
+#include "zlib.h"
+
 /* Implementation of undo system for objects in sculpt mode.
  *
  * Each undo step in sculpt mode consists of list of nodes, each node contains:
@@ -841,6 +843,8 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
     }
 
     if (tag_update) {
+      /* Visibility changes rebuild the PBVH, other changes only modify vertex data. */
+      ss->refit_pbvh_on_update = !rebuild;
       DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
     }
     else {
@@ -851,6 +855,230 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
   MEM_SAFE_FREE(undo_modified_grids);
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Compressed Storage
+ *
+ * Once a step is pushed, the per vertex arrays of its nodes are only accessed again when the step
+ * is undone or redone, so they are kept compressed in the meantime. Every 32 bit word is XOR-ed
+ * with the same component of the previous element, which cancels out the sign, exponent and high
+ * mantissa bits of neighboring vertices. The result is split into byte planes and deflated.
+ *
+ * Restoring a step swaps its arrays with the mesh, so they are decompressed before and compressed
+ * again after.
+ * \{ */
+
+#define SCULPT_UNDO_ARRAYS_NUM 5
+
+typedef struct SculptUndoNodeCompressed {
+  /* Size in bytes of every array, zero when the node does not use it. */
+  size_t array_sizes[SCULPT_UNDO_ARRAYS_NUM];
+  /* Total size of the arrays, which is also the size of the data before deflating. */
+  size_t encoded_size;
+  /* Stored data, only encoded when deflating did not make it smaller. */
+  void *data;
+  size_t data_size;
+  bool is_deflated;
+} SculptUndoNodeCompressed;
+
+typedef struct SculptUndoNodeArray {
+  void **data;
+  /* Number of 32 bit words per element. */
+  int stride;
+} SculptUndoNodeArray;
+
+static void sculpt_undo_node_arrays_get(SculptUndoNode *unode,
+                                        SculptUndoNodeArray r_arrays[SCULPT_UNDO_ARRAYS_NUM])
+{
+  r_arrays[0] = (SculptUndoNodeArray){(void **)&unode->co, 3};
+  r_arrays[1] = (SculptUndoNodeArray){(void **)&unode->orig_co, 3};
+  r_arrays[2] = (SculptUndoNodeArray){(void **)&unode->col, 4};
+  r_arrays[3] = (SculptUndoNodeArray){(void **)&unode->mask, 1};
+  r_arrays[4] = (SculptUndoNodeArray){(void **)&unode->index, 1};
+}
+
+static void sculpt_undo_array_encode(const uint32_t *src,
+                                     uchar *dst,
+                                     const size_t words_len,
+                                     const size_t stride)
+{
+  for (size_t i = 0; i < words_len; i++) {
+    const uint32_t word = (i >= stride) ? src[i] ^ src[i - stride] : src[i];
+    dst[i] = (uchar)(word & 0xff);
+    dst[words_len + i] = (uchar)((word >> 8) & 0xff);
+    dst[2 * words_len + i] = (uchar)((word >> 16) & 0xff);
+    dst[3 * words_len + i] = (uchar)(word >> 24);
+  }
+}
+
+static void sculpt_undo_array_decode(const uchar *src,
+                                     uint32_t *dst,
+                                     const size_t words_len,
+                                     const size_t stride)
+{
+  for (size_t i = 0; i < words_len; i++) {
+    const uint32_t word = (uint32_t)src[i] | ((uint32_t)src[words_len + i] << 8) |
+                          ((uint32_t)src[2 * words_len + i] << 16) |
+                          ((uint32_t)src[3 * words_len + i] << 24);
+    dst[i] = (i >= stride) ? word ^ dst[i - stride] : word;
+  }
+}
+
+static void sculpt_undo_node_compress(SculptUndoNode *unode)
+{
+  BLI_assert(unode->compressed == NULL);
+
+  SculptUndoNodeArray arrays[SCULPT_UNDO_ARRAYS_NUM];
+  sculpt_undo_node_arrays_get(unode, arrays);
+
+  size_t array_sizes[SCULPT_UNDO_ARRAYS_NUM];
+  size_t encoded_size = 0;
+  for (int i = 0; i < SCULPT_UNDO_ARRAYS_NUM; i++) {
+    array_sizes[i] = *arrays[i].data ? MEM_allocN_len(*arrays[i].data) : 0;
+    encoded_size += array_sizes[i];
+  }
+  if (encoded_size == 0) {
+    return;
+  }
+
+  uchar *encoded = MEM_mallocN(encoded_size, __func__);
+  size_t offset = 0;
+  for (int i = 0; i < SCULPT_UNDO_ARRAYS_NUM; i++) {
+    if (array_sizes[i] == 0) {
+      continue;
+    }
+    sculpt_undo_array_encode(
+        *arrays[i].data, encoded + offset, array_sizes[i] / sizeof(uint32_t), arrays[i].stride);
+    offset += array_sizes[i];
+    MEM_freeN(*arrays[i].data);
+    *arrays[i].data = NULL;
+  }
+
+  SculptUndoNodeCompressed *compressed = MEM_callocN(sizeof(*compressed), __func__);
+  memcpy(compressed->array_sizes, array_sizes, sizeof(array_sizes));
+  compressed->encoded_size = encoded_size;
+
+  uLongf deflated_size = compressBound(encoded_size);
+  uchar *deflated = MEM_mallocN(deflated_size, __func__);
+  if (compress2(deflated, &deflated_size, encoded, encoded_size, Z_BEST_SPEED) == Z_OK &&
+      deflated_size < encoded_size) {
+    MEM_freeN(encoded);
+    compressed->data = MEM_reallocN(deflated, deflated_size);
+    compressed->data_size = deflated_size;
+    compressed->is_deflated = true;
+  }
+  else {
+    MEM_freeN(deflated);
+    compressed->data = encoded;
+    compressed->data_size = encoded_size;
+  }
+
+  unode->compressed = compressed;
+}
+
+static void sculpt_undo_node_decompress(SculptUndoNode *unode)
+{
+  SculptUndoNodeCompressed *compressed = unode->compressed;
+  if (compressed == NULL) {
+    return;
+  }
+
+  uchar *encoded = compressed->data;
+  if (compressed->is_deflated) {
+    encoded = MEM_mallocN(compressed->encoded_size, __func__);
+    uLongf encoded_size = compressed->encoded_size;
+    const int result = uncompress(encoded, &encoded_size, compressed->data, compressed->data_size);
+    BLI_assert(result == Z_OK && encoded_size == compressed->encoded_size);
+    UNUSED_VARS_NDEBUG(result);
+  }
+
+  SculptUndoNodeArray arrays[SCULPT_UNDO_ARRAYS_NUM];
+  sculpt_undo_node_arrays_get(unode, arrays);
+
+  size_t offset = 0;
+  for (int i = 0; i < SCULPT_UNDO_ARRAYS_NUM; i++) {
+    const size_t array_size = compressed->array_sizes[i];
+    if (array_size == 0) {
+      continue;
+    }
+    *arrays[i].data = MEM_mallocN(array_size, "SculptUndoNode array");
+    sculpt_undo_array_decode(
+        encoded + offset, *arrays[i].data, array_size / sizeof(uint32_t), arrays[i].stride);
+    offset += array_size;
+  }
+
+  if (encoded != compressed->data) {
+    MEM_freeN(encoded);
+  }
+  MEM_freeN(compressed->data);
+  MEM_freeN(compressed);
+  unode->compressed = NULL;
+}
+
+static void sculpt_undo_compress_task_cb(void *__restrict userdata,
+                                         const int i,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoNode **nodes = userdata;
+  sculpt_undo_node_compress(nodes[i]);
+}
+
+static void sculpt_undo_decompress_task_cb(void *__restrict userdata,
+                                           const int i,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoNode **nodes = userdata;
+  sculpt_undo_node_decompress(nodes[i]);
+}
+
+static void sculpt_undo_list_compress_ex(UndoSculpt *usculpt, const bool compress)
+{
+  const int nodes_len = BLI_listbase_count(&usculpt->nodes);
+  if (nodes_len == 0) {
+    return;
+  }
+
+  SculptUndoNode **nodes = MEM_malloc_arrayN(nodes_len, sizeof(*nodes), __func__);
+  int i = 0;
+  LISTBASE_FOREACH (SculptUndoNode *, unode, &usculpt->nodes) {
+    nodes[i++] = unode;
+    /* Memory of the compressed data is released before the arrays are allocated again. */
+    if (!compress && unode->compressed) {
+      usculpt->undo_size += unode->compressed->encoded_size - unode->compressed->data_size;
+    }
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0,
+                          nodes_len,
+                          nodes,
+                          compress ? sculpt_undo_compress_task_cb : sculpt_undo_decompress_task_cb,
+                          &settings);
+
+  if (compress) {
+    for (i = 0; i < nodes_len; i++) {
+      const SculptUndoNodeCompressed *compressed = nodes[i]->compressed;
+      if (compressed) {
+        usculpt->undo_size -= compressed->encoded_size - compressed->data_size;
+      }
+    }
+  }
+
+  MEM_freeN(nodes);
+}
+
+static void sculpt_undo_list_compress(UndoSculpt *usculpt)
+{
+  sculpt_undo_list_compress_ex(usculpt, true);
+}
+
+static void sculpt_undo_list_decompress(UndoSculpt *usculpt)
+{
+  sculpt_undo_list_compress_ex(usculpt, false);
+}
+
+/** \} */
+
 static void sculpt_undo_free_list(ListBase *lb)
 {
   SculptUndoNode *unode = lb->first;
@@ -885,6 +1113,10 @@ static void sculpt_undo_free_list(ListBase *lb)
     if (unode->mask) {
       MEM_freeN(unode->mask);
     }
+    if (unode->compressed) {
+      MEM_freeN(unode->compressed->data);
+      MEM_freeN(unode->compressed);
+    }
 
     if (unode->bm_entry) {
       BM_log_entry_drop(unode->bm_entry);
@@ -1447,9 +1679,10 @@ static bool sculpt_undosys_step_encode(struct bContext *UNUSED(C),
                                        struct Main *bmain,
                                        UndoStep *us_p)
 {
-  /* Dummy, encoding is done along the way by adding tiles
-   * to the current 'SculptUndoStep' added by encode_init. */
+  /* Encoding is done along the way by adding tiles to the current 'SculptUndoStep' added by
+   * encode_init, only the finished nodes are compressed here. */
   SculptUndoStep *us = (SculptUndoStep *)us_p;
+  sculpt_undo_list_compress(&us->data);
   us->step.data_size = us->data.undo_size;
 
   SculptUndoNode *unode = us->data.nodes.last;
@@ -1470,7 +1703,10 @@ static void sculpt_undosys_step_decode_undo_impl(struct bContext *C,
                                                  SculptUndoStep *us)
 {
   BLI_assert(us->step.is_applied == true);
+  sculpt_undo_list_decompress(&us->data);
   sculpt_undo_restore_list(C, depsgraph, &us->data.nodes);
+  sculpt_undo_list_compress(&us->data);
+  us->step.data_size = us->data.undo_size;
   us->step.is_applied = false;
 }
 
@@ -1479,7 +1715,10 @@ static void sculpt_undosys_step_decode_redo_impl(struct bContext *C,
                                                  SculptUndoStep *us)
 {
   BLI_assert(us->step.is_applied == false);
+  sculpt_undo_list_decompress(&us->data);
   sculpt_undo_restore_list(C, depsgraph, &us->data.nodes);
+  sculpt_undo_list_compress(&us->data);
+  us->step.data_size = us->data.undo_size;
   us->step.is_applied = true;
 }
 
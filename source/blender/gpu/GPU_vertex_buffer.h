@@ -81,6 +81,11 @@ const void *GPU_vertbuf_read(GPUVertBuf *verts);
 void *GPU_vertbuf_unmap(const GPUVertBuf *verts, const void *mapped_data);
 void GPU_vertbuf_clear(GPUVertBuf *verts);
 void GPU_vertbuf_discard(GPUVertBuf *);
+/**
+ * Free the host data and reset the buffer so it needs to be initialized again, but keep its
+ * device allocation. Batches using this buffer stay valid and the new data is uploaded in place.
+ */
+void GPU_vertbuf_tag_dirty(GPUVertBuf *verts);
 
 /* Avoid GPUVertBuf datablock being free but not its data. */
 void GPU_vertbuf_handle_ref_add(GPUVertBuf *verts);
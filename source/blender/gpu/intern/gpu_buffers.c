@@ -25,6 +25,7 @@
 
 #include <limits.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "MEM_guardedalloc.h"
@@ -337,6 +338,142 @@ void GPU_pbvh_mesh_buffers_update(GPU_PBVH_Buffers *buffers,
   buffers->mvert = mvert;
 }
 
+/* Triangle of the simplified buffers, with the sorted cells of its corners as key. */
+typedef struct GPUPBVHLodTri {
+  uint64_t key;
+  uint verts[3];
+} GPUPBVHLodTri;
+
+static int gpu_pbvh_lod_tri_cmp(const void *a_v, const void *b_v)
+{
+  const GPUPBVHLodTri *a = a_v;
+  const GPUPBVHLodTri *b = b_v;
+  if (a->key != b->key) {
+    return (a->key < b->key) ? -1 : 1;
+  }
+  if (a->verts[0] != b->verts[0]) {
+    return (a->verts[0] < b->verts[0]) ? -1 : 1;
+  }
+  if (a->verts[1] != b->verts[1]) {
+    return (a->verts[1] < b->verts[1]) ? -1 : 1;
+  }
+  return 0;
+}
+
+/**
+ * Build the triangles drawn for the node when it is far enough from the view, see
+ * #BKE_pbvh_lod_use. Vertices are clustered on a grid of #PBVH_LOD_GRID_RES cells over the node
+ * and every triangle is replaced by one between the first vertices of the clusters of its
+ * corners, skipping degenerate and duplicate triangles. They index the same vertex buffer as the
+ * full resolution triangles.
+ *
+ * Returns NULL when the simplified triangles are not much fewer.
+ */
+static GPUIndexBuf *gpu_pbvh_mesh_lod_index_build(const MLoop *mloop,
+                                                  const MLoopTri *looptri,
+                                                  const MVert *mvert,
+                                                  const int *face_indices,
+                                                  const int *sculpt_face_sets,
+                                                  const int face_indices_len,
+                                                  const int tottri)
+{
+  float min[3], max[3];
+  INIT_MINMAX(min, max);
+  for (int i = 0; i < face_indices_len; i++) {
+    const MLoopTri *lt = &looptri[face_indices[i]];
+    if (gpu_pbvh_is_looptri_visible(lt, mvert, mloop, sculpt_face_sets)) {
+      for (int j = 0; j < 3; j++) {
+        minmax_v3v3_v3(min, max, mvert[mloop[lt->tri[j]].v].co);
+      }
+    }
+  }
+
+  float size[3];
+  sub_v3_v3v3(size, max, min);
+  const float cell_size = max_fff(size[0], size[1], size[2]) / PBVH_LOD_GRID_RES;
+  if (!(cell_size > 0.0f)) {
+    return NULL;
+  }
+  const float cell_size_inv = 1.0f / cell_size;
+
+  const int cells_len = PBVH_LOD_GRID_RES * PBVH_LOD_GRID_RES * PBVH_LOD_GRID_RES;
+  int *cell_verts = MEM_malloc_arrayN(cells_len, sizeof(int), __func__);
+  copy_vn_i(cell_verts, cells_len, -1);
+
+  GPUPBVHLodTri *tris = MEM_malloc_arrayN(tottri, sizeof(*tris), __func__);
+  int tris_len = 0;
+  int vert_idx = 0;
+
+  for (int i = 0; i < face_indices_len; i++) {
+    const MLoopTri *lt = &looptri[face_indices[i]];
+    if (!gpu_pbvh_is_looptri_visible(lt, mvert, mloop, sculpt_face_sets)) {
+      continue;
+    }
+
+    uint cells[3];
+    uint verts[3];
+    for (int j = 0; j < 3; j++) {
+      const float *co = mvert[mloop[lt->tri[j]].v].co;
+      int cell_co[3];
+      for (int axis = 0; axis < 3; axis++) {
+        cell_co[axis] = clamp_i(
+            (int)((co[axis] - min[axis]) * cell_size_inv), 0, PBVH_LOD_GRID_RES - 1);
+      }
+      cells[j] = (uint)(cell_co[0] +
+                        PBVH_LOD_GRID_RES * (cell_co[1] + PBVH_LOD_GRID_RES * cell_co[2]));
+
+      if (cell_verts[cells[j]] == -1) {
+        cell_verts[cells[j]] = vert_idx * 3 + j;
+      }
+      verts[j] = (uint)cell_verts[cells[j]];
+    }
+    vert_idx++;
+
+    if (ELEM(cells[0], cells[1], cells[2]) || cells[1] == cells[2]) {
+      continue;
+    }
+
+    if (cells[0] > cells[1]) {
+      SWAP(uint, cells[0], cells[1]);
+    }
+    if (cells[1] > cells[2]) {
+      SWAP(uint, cells[1], cells[2]);
+    }
+    if (cells[0] > cells[1]) {
+      SWAP(uint, cells[0], cells[1]);
+    }
+
+    GPUPBVHLodTri *tri = &tris[tris_len++];
+    tri->key = ((uint64_t)cells[0] << 32) | ((uint64_t)cells[1] << 16) | (uint64_t)cells[2];
+    memcpy(tri->verts, verts, sizeof(verts));
+  }
+
+  MEM_freeN(cell_verts);
+
+  qsort(tris, (size_t)tris_len, sizeof(*tris), gpu_pbvh_lod_tri_cmp);
+
+  int unique_len = 0;
+  for (int i = 0; i < tris_len; i++) {
+    if (i == 0 || tris[i].key != tris[i - 1].key) {
+      tris[unique_len++] = tris[i];
+    }
+  }
+
+  GPUIndexBuf *index_buf = NULL;
+  if (unique_len > 0 && unique_len * 2 <= tottri) {
+    GPUIndexBufBuilder elb;
+    GPU_indexbuf_init(&elb, GPU_PRIM_TRIS, unique_len, tottri * 3);
+    for (int i = 0; i < unique_len; i++) {
+      GPU_indexbuf_add_tri_verts(&elb, tris[i].verts[0], tris[i].verts[1], tris[i].verts[2]);
+    }
+    index_buf = GPU_indexbuf_build(&elb);
+  }
+
+  MEM_freeN(tris);
+
+  return index_buf;
+}
+
 /* Threaded - do not call any functions that use OpenGL calls! */
 GPU_PBVH_Buffers *GPU_pbvh_mesh_buffers_build(const MPoly *mpoly,
                                               const MLoop *mloop,
@@ -414,6 +551,9 @@ GPU_PBVH_Buffers *GPU_pbvh_mesh_buffers_build(const MPoly *mpoly,
   }
   buffers->index_lines_buf = GPU_indexbuf_build(&elb_lines);
 
+  buffers->index_buf_fast = gpu_pbvh_mesh_lod_index_build(
+      mloop, looptri, mvert, face_indices, sculpt_face_sets, face_indices_len, tottri);
+
   buffers->tot_tri = tottri;
 
   buffers->mpoly = mpoly;
@@ -72,6 +72,13 @@ void VertBuf::clear()
   flag = GPU_VERTBUF_INVALID;
 }
 
+void VertBuf::tag_dirty()
+{
+  MEM_SAFE_FREE(data);
+  vertex_len = vertex_alloc = 0;
+  flag = GPU_VERTBUF_INVALID;
+}
+
 VertBuf *VertBuf::duplicate()
 {
   VertBuf *dst = GPUBackend::get()->vertbuf_alloc();
@@ -165,6 +172,11 @@ void GPU_vertbuf_clear(GPUVertBuf *verts)
   unwrap(verts)->clear();
 }
 
+void GPU_vertbuf_tag_dirty(GPUVertBuf *verts)
+{
+  unwrap(verts)->tag_dirty();
+}
+
 void GPU_vertbuf_discard(GPUVertBuf *verts)
 {
   unwrap(verts)->clear();
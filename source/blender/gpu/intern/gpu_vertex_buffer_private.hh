@@ -61,6 +61,7 @@ class VertBuf {
 
   void init(const GPUVertFormat *format, GPUUsageType usage);
   void clear(void);
+  void tag_dirty(void);
 
   /* Data management. */
   void allocate(uint vert_len);
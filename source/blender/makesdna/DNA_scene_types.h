@@ -1847,7 +1847,8 @@ typedef struct Scene {
 #define R_SIMPLIFY (1 << 24)
 #define R_EDGE_FRS (1 << 25)        /* R_EDGE reserved for Freestyle */
 #define R_PERSISTENT_DATA (1 << 26) /* keep data around for re-render */
-#define R_MODE_UNUSED_27 (1 << 27)  /* cleared */
+/* Evaluate the next frame while the current frame renders, was unused before. */
+#define R_DEPSGRAPH_LOOKAHEAD (1 << 27)
 
 /** #RenderData.seq_flag */
 enum {
@@ -6651,6 +6651,15 @@ static void rna_def_scene_render_data(BlenderRNA *brna)
                            "at the cost of increased memory usage");
   RNA_def_property_update(prop, 0, "rna_Scene_use_persistent_data_update");
 
+  prop = RNA_def_property(srna, "use_lookahead_evaluation", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "mode", R_DEPSGRAPH_LOOKAHEAD);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE);
+  RNA_def_property_ui_text(prop,
+                           "Evaluate Ahead",
+                           "Evaluate the next frame while the current frame renders, at the cost "
+                           "of increased memory usage");
+  RNA_def_property_update(prop, NC_SCENE | ND_RENDER_OPTIONS, NULL);
+
   /* Freestyle line thickness options */
   prop = RNA_def_property(srna, "line_thickness_mode", PROP_ENUM, PROP_NONE);
   RNA_def_property_enum_sdna(prop, NULL, "line_thickness_mode");
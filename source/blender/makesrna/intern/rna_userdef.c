@@ -6313,6 +6313,13 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
   RNA_def_property_boolean_sdna(prop, NULL, "use_override_templates", 1);
   RNA_def_property_ui_text(
       prop, "Override Templates", "Enable library override template in the python API");
+
+  prop = RNA_def_property(srna, "use_undo_skip_unchanged", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_undo_skip_unchanged", 1);
+  RNA_def_property_ui_text(prop,
+                           "Undo Skip Unchanged",
+                           "Reuse the global undo data of data-blocks which were not tagged for "
+                           "update since the previous undo step, instead of writing them again");
 }
 
 static void rna_def_userdef_addon_collection(BlenderRNA *brna, PropertyRNA *cprop)
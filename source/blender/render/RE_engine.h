@@ -207,6 +207,7 @@ void RE_engine_report(RenderEngine *engine, int type, const char *msg);
 void RE_engine_set_error_message(RenderEngine *engine, const char *msg);
 
 bool RE_engine_render(struct Render *re, bool do_all);
+void RE_engine_lookahead_free(struct Render *re);
 
 bool RE_engine_is_external(const struct Render *re);
 
@@ -31,18 +31,23 @@
 
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_math_bits.h"
 #include "BLI_rect.h"
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
 
+#include "DNA_anim_types.h"
 #include "DNA_object_types.h"
 
+#include "BKE_animsys.h"
 #include "BKE_camera.h"
 #include "BKE_colortools.h"
+#include "BKE_fcurve_driver.h"
 #include "BKE_global.h"
 #include "BKE_layer.h"
 #include "BKE_node.h"
+#include "BKE_pointcache.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
 
@@ -634,12 +639,175 @@ static bool engine_keep_depsgraph(RenderEngine *engine)
   return (engine->re->r.mode & R_PERSISTENT_DATA) || (engine->type->flag & RE_USE_GPU_CONTEXT);
 }
 
+/* Look-ahead
+ *
+ * When rendering an animation, the dependency graph of the next frame is built and evaluated in
+ * a background thread while the engine renders the current frame. The engine then takes over
+ * the evaluated graph instead of evaluating the next frame from scratch. */
+
+typedef struct RenderLookahead {
+  Depsgraph *depsgraph;
+  ViewLayer *view_layer;
+  int frame;
+
+  ListBase threads;
+  bool is_running;
+} RenderLookahead;
+
+static void engine_lookahead_check_driver_cb(ID *UNUSED(id), FCurve *fcu, void *user_data)
+{
+  bool *r_has_python_drivers = user_data;
+  ChannelDriver *driver = fcu->driver;
+
+  if (driver != NULL && driver->type == DRIVER_TYPE_PYTHON &&
+      !BKE_driver_has_simple_expression(driver)) {
+    *r_has_python_drivers = true;
+  }
+}
+
+static bool engine_lookahead_supported(Render *re, RenderEngine *engine)
+{
+  if (!(re->r.mode & R_DEPSGRAPH_LOOKAHEAD) || !(re->flag & R_ANIMATION) ||
+      (re->r.scemode & R_BUTS_PREVIEW)) {
+    return false;
+  }
+  /* Persistent data and GPU engines update a single graph from frame to frame instead. */
+  if (engine_keep_depsgraph(engine)) {
+    return false;
+  }
+  /* Motion blur steps change the scene frame while the engine renders. */
+  if (re->r.mode & R_MBLUR) {
+    return false;
+  }
+  /* Nothing may edit the scene from the interface while it is evaluated in the background. */
+  if (!G.background && !re->r.use_lock_interface) {
+    return false;
+  }
+
+  /* A single graph is kept ahead, so only do this when a single view layer is rendered. */
+  int num_view_layers = 0;
+  FOREACH_VIEW_LAYER_TO_RENDER_BEGIN (re, view_layer_iter) {
+    num_view_layers++;
+  }
+  FOREACH_VIEW_LAYER_TO_RENDER_END;
+  if (num_view_layers != 1) {
+    return false;
+  }
+
+  /* Physics caches, rigid bodies and simulations step from the previous frame, evaluating the next
+   * frame ahead would step them out of order. */
+  for (Scene *sce = re->scene; sce != NULL; sce = sce->set) {
+    if (sce->rigidbody_world != NULL) {
+      return false;
+    }
+  }
+  if (!BLI_listbase_is_empty(&re->main->simulations)) {
+    return false;
+  }
+  LISTBASE_FOREACH (Object *, ob, &re->main->objects) {
+    if (BKE_ptcache_object_has(re->scene, ob, 0)) {
+      return false;
+    }
+  }
+
+  /* Python drivers need the GIL, which can be held by the thread waiting for the look-ahead
+   * when rendering from a script. */
+  bool has_python_drivers = false;
+  BKE_fcurves_main_cb(re->main, engine_lookahead_check_driver_cb, &has_python_drivers);
+  return !has_python_drivers;
+}
+
+static void *engine_lookahead_thread(void *lookahead_v)
+{
+  RenderLookahead *lookahead = lookahead_v;
+  DEG_evaluate_on_framechange(lookahead->depsgraph, (float)lookahead->frame);
+  return NULL;
+}
+
+static void engine_lookahead_start(Render *re, ViewLayer *view_layer)
+{
+  BLI_assert(re->lookahead == NULL);
+
+  const int frame = re->scene->r.cfra + max_ii(re->r.frame_step, 1);
+  if (frame > re->r.efra) {
+    return;
+  }
+
+  RenderLookahead *lookahead = MEM_callocN(sizeof(RenderLookahead), "RenderLookahead");
+  lookahead->view_layer = view_layer;
+  lookahead->frame = frame;
+
+  /* Build on this thread: creating a graph is not thread safe, and building only reads data
+   * that is locked from the interface at this point. */
+  lookahead->depsgraph = DEG_graph_new(re->main, re->scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(lookahead->depsgraph, "RENDER LOOKAHEAD");
+  DEG_graph_relations_update(lookahead->depsgraph);
+
+  BLI_threadpool_init(&lookahead->threads, engine_lookahead_thread, 1);
+  BLI_threadpool_insert(&lookahead->threads, lookahead);
+  lookahead->is_running = true;
+
+  re->lookahead = lookahead;
+}
+
+static void engine_lookahead_wait(Render *re)
+{
+  RenderLookahead *lookahead = re->lookahead;
+
+  if (lookahead != NULL && lookahead->is_running) {
+    BLI_threadpool_end(&lookahead->threads);
+    lookahead->is_running = false;
+  }
+}
+
+/* Take the graph evaluated ahead of time if it matches the frame about to be rendered. */
+static Depsgraph *engine_lookahead_take(Render *re, ViewLayer *view_layer)
+{
+  RenderLookahead *lookahead = re->lookahead;
+  Depsgraph *depsgraph = NULL;
+
+  if (lookahead == NULL) {
+    return NULL;
+  }
+
+  engine_lookahead_wait(re);
+
+  if (lookahead->view_layer == view_layer && lookahead->frame == re->scene->r.cfra &&
+      re->scene->r.subframe == 0.0f) {
+    depsgraph = lookahead->depsgraph;
+    lookahead->depsgraph = NULL;
+  }
+
+  RE_engine_lookahead_free(re);
+
+  return depsgraph;
+}
+
+void RE_engine_lookahead_free(Render *re)
+{
+  RenderLookahead *lookahead = re->lookahead;
+
+  if (lookahead == NULL) {
+    return;
+  }
+
+  engine_lookahead_wait(re);
+
+  if (lookahead->depsgraph) {
+    DEG_graph_free(lookahead->depsgraph);
+  }
+
+  MEM_freeN(lookahead);
+  re->lookahead = NULL;
+}
+
 /* Depsgraph */
 static void engine_depsgraph_init(RenderEngine *engine, ViewLayer *view_layer)
 {
   Main *bmain = engine->re->main;
   Scene *scene = engine->re->scene;
   bool reuse_depsgraph = false;
+  bool use_lookahead_depsgraph = false;
 
   /* Reuse depsgraph from persistent data if possible. */
   if (engine->depsgraph) {
@@ -663,9 +831,16 @@ static void engine_depsgraph_init(RenderEngine *engine, ViewLayer *view_layer)
      * to avoid excessive memory usage. */
     RE_FreePersistentData(NULL);
 
-    /* Create new depsgraph if not cached with persistent data. */
-    engine->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-    DEG_debug_name_set(engine->depsgraph, "RENDER");
+    /* Use the depsgraph evaluated in the background while rendering the previous frame, or
+     * create new depsgraph if not cached with persistent data. */
+    engine->depsgraph = engine_lookahead_take(engine->re, view_layer);
+    if (engine->depsgraph) {
+      use_lookahead_depsgraph = true;
+    }
+    else {
+      engine->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+      DEG_debug_name_set(engine->depsgraph, "RENDER");
+    }
   }
 
   if (engine->re->r.scemode & R_BUTS_PREVIEW) {
@@ -685,6 +860,10 @@ static void engine_depsgraph_init(RenderEngine *engine, ViewLayer *view_layer)
       DRW_render_context_disable(engine->re);
     }
   }
+  else if (use_lookahead_depsgraph) {
+    /* Frame was evaluated ahead of time, only run Python callbacks and their updates. */
+    BKE_scene_graph_update_for_evaluated_newframe(engine->depsgraph, false);
+  }
   else {
     /* Go through update with full Python callbacks for regular render. */
     BKE_scene_graph_update_for_newframe_ex(engine->depsgraph, false);
@@ -852,6 +1031,11 @@ static void engine_render_view_layer(Render *re,
     if (engine->type->update) {
       engine->type->update(engine, re->main, engine->depsgraph);
     }
+
+    /* Evaluate the next frame while this one renders. */
+    if (re->lookahead == NULL && engine_lookahead_supported(re, engine)) {
+      engine_lookahead_start(re, view_layer);
+    }
   }
 
   if (re->draw_lock) {
@@ -872,6 +1056,9 @@ static void engine_render_view_layer(Render *re,
     }
   }
 
+  /* Main data is modified again for the next frame once the render is done. */
+  engine_lookahead_wait(re);
+
   /* Optionally composite grease pencil over render result. */
   if (engine->has_grease_pencil && use_grease_pencil && !re->result->do_exr_tile) {
     /* NOTE: External engine might have been requested to free its
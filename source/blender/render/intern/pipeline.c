@@ -629,6 +629,7 @@ void RE_FreeRender(Render *re)
   if (re->engine) {
     RE_engine_free(re->engine);
   }
+  RE_engine_lookahead_free(re);
 
   BLI_rw_mutex_end(&re->resultmutex);
   BLI_rw_mutex_end(&re->partsmutex);
@@ -1856,6 +1857,7 @@ static void render_pipeline_free(Render *re)
     RE_engine_free(re->engine);
     re->engine = NULL;
   }
+  RE_engine_lookahead_free(re);
   if (re->pipeline_depsgraph != NULL) {
     DEG_graph_free(re->pipeline_depsgraph);
     re->pipeline_depsgraph = NULL;
@@ -40,6 +40,7 @@ struct GHash;
 struct Main;
 struct Object;
 struct RenderEngine;
+struct RenderLookahead;
 struct ReportList;
 
 #ifdef __cplusplus
@@ -126,6 +127,10 @@ struct Render {
   Depsgraph *pipeline_depsgraph;
   Scene *pipeline_scene_eval;
 
+  /* Dependency graph of the next animation frame, evaluated in the background while the current
+   * frame renders. Owned by the render engine code, see #RE_engine_lookahead_free. */
+  struct RenderLookahead *lookahead;
+
   /* callbacks */
   void (*display_init)(void *handle, RenderResult *rr);
   void *dih;
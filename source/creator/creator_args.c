@@ -589,10 +589,12 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-time");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-pretty");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-uuid");
+  BLI_args_print_arg_doc(ba, "--debug-depsgraph-trace");
   BLI_args_print_arg_doc(ba, "--debug-ghost");
   BLI_args_print_arg_doc(ba, "--debug-gpu");
   BLI_args_print_arg_doc(ba, "--debug-gpu-force-workarounds");
   BLI_args_print_arg_doc(ba, "--debug-wm");
+  BLI_args_print_arg_doc(ba, "--debug-sculpt-time");
 #  ifdef WITH_XR_OPENXR
   BLI_args_print_arg_doc(ba, "--debug-xr");
   BLI_args_print_arg_doc(ba, "--debug-xr-time");
@@ -957,6 +959,9 @@ static const char arg_handle_debug_mode_generic_set_doc_wm[] =
     "\n\t"
     "Enable debug messages for the window manager, shows all operators in search, shows "
     "keymap errors.";
+static const char arg_handle_debug_mode_generic_set_doc_sculpt_time[] =
+    "\n\t"
+    "Enable timing statistics for every dab of sculpt strokes.";
 #  ifdef WITH_XR_OPENXR
 static const char arg_handle_debug_mode_generic_set_doc_xr[] =
     "\n\t"
@@ -1094,6 +1099,22 @@ static int arg_handle_debug_value_set(int argc, const char **argv, void *UNUSED(
   return 0;
 }
 
+static const char arg_handle_debug_depsgraph_trace_set_doc[] =
+    "<filepath>\n"
+    "\tWrite a timeline of dependency graph operations evaluation to <filepath>,\n"
+    "\tin the Chrome trace event format (viewable in 'chrome://tracing' or Perfetto).";
+static int arg_handle_debug_depsgraph_trace_set(int argc,
+                                                const char **argv,
+                                                void *UNUSED(data))
+{
+  if (argc > 1) {
+    DEG_debug_trace_begin(argv[1]);
+    return 1;
+  }
+  printf("\nError: you must specify a path after '--debug-depsgraph-trace'.\n");
+  return 0;
+}
+
 static const char arg_handle_debug_fpe_set_doc[] =
     "\n\t"
     "Enable floating-point exceptions.";
@@ -2121,6 +2142,11 @@ void main_args_setup(bContext *C, bArgs *ba)
                (void *)G_DEBUG_HANDLERS);
   BLI_args_add(
       ba, NULL, "--debug-wm", CB_EX(arg_handle_debug_mode_generic_set, wm), (void *)G_DEBUG_WM);
+  BLI_args_add(ba,
+               NULL,
+               "--debug-sculpt-time",
+               CB_EX(arg_handle_debug_mode_generic_set, sculpt_time),
+               (void *)G_DEBUG_SCULPT_TIME);
 #  ifdef WITH_XR_OPENXR
   BLI_args_add(
       ba, NULL, "--debug-xr", CB_EX(arg_handle_debug_mode_generic_set, xr), (void *)G_DEBUG_XR);
@@ -2199,6 +2225,8 @@ void main_args_setup(bContext *C, bArgs *ba)
                "--debug-depsgraph-uuid",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_build),
                (void *)G_DEBUG_DEPSGRAPH_UUID);
+  BLI_args_add(
+      ba, NULL, "--debug-depsgraph-trace", CB(arg_handle_debug_depsgraph_trace_set), NULL);
   BLI_args_add(ba,
                NULL,
                "--debug-gpu-force-workarounds",
@@ -227,6 +227,10 @@ class TestConfig:
             test_category = test.category()
 
             for device in self.devices:
+                # Tests not using a specific device only run once, on the CPU.
+                if not test.use_device() and device.type != 'CPU':
+                    continue
+
                 entry = self.queue.find(revision_name, test_name, test_category, device.id)
                 if entry:
                     # Test if revision hash or executable changed.
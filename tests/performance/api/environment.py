@@ -124,7 +124,7 @@ class TestEnvironment:
     def unset_log_file(self) -> None:
         self.log_file = None
 
-    def call(self, args: List[str], cwd: pathlib.Path, silent=False) -> List[str]:
+    def call(self, args: List[str], cwd: pathlib.Path, silent=False, environ: Dict={}) -> List[str]:
         # Execute command with arguments in specified directory,
         # and return combined stdout and stderr output.
 
@@ -136,7 +136,10 @@ class TestEnvironment:
             f = open(self.log_file, 'a')
             f.write('\n' + ' '.join([str(arg) for arg in args]) + '\n\n')
 
-        proc = subprocess.Popen(args, cwd=cwd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        # Extra environment variables on top of the current ones.
+        env = dict(os.environ, **environ) if environ else None
+
+        proc = subprocess.Popen(args, cwd=cwd, env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
 
         # Read line by line
         lines = []
@@ -163,7 +166,7 @@ class TestEnvironment:
 
         return lines
 
-    def call_blender(self, args: List[str], foreground=False) -> List[str]:
+    def call_blender(self, args: List[str], foreground=False, environ: Dict={}) -> List[str]:
         # Execute Blender command with arguments.
         common_args = ['--factory-startup', '--enable-autoexec', '--python-exit-code', '1']
         if foreground:
@@ -171,13 +174,14 @@ class TestEnvironment:
         else:
             common_args += ['--background']
 
-        return self.call([self.blender_executable] + common_args + args, cwd=self.base_dir)
+        return self.call([self.blender_executable] + common_args + args, cwd=self.base_dir, environ=environ)
 
     def run_in_blender(self,
                        function: Callable[[Dict], Dict],
                        args: Dict,
                        blender_args: List=[],
-                       foreground=False) -> Dict:
+                       foreground=False,
+                       environ: Dict={}) -> Dict:
         # Run function in a Blender instance. Arguments and return values are
         # passed as a Python object that must be serializable with pickle.
 
@@ -199,7 +203,7 @@ class TestEnvironment:
                       f'print("{output_prefix}" + result.decode())\n')
 
         expr_args = blender_args + ['--python-expr', expression]
-        lines = self.call_blender(expr_args, foreground=foreground)
+        lines = self.call_blender(expr_args, foreground=foreground, environ=environ)
 
         # Parse output.
         for line in lines:
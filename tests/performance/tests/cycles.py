@@ -38,21 +38,30 @@ def _run(args):
     # Render
     bpy.ops.render.render(write_still=True)
 
-    return None
+    # Number of samples rendered, to compare the throughput of integrators.
+    render = scene.render
+    scale = render.resolution_percentage / 100.0
+    num_pixels = int(render.resolution_x * scale) * int(render.resolution_y * scale)
+    return {'num_samples': num_pixels * scene.cycles.samples}
 
 
 class CyclesTest(api.Test):
-    def __init__(self, filepath):
+    def __init__(self, filepath, wavefront=False):
         self.filepath = filepath
+        # Render with the wavefront split kernel instead of the megakernel on the CPU.
+        self.wavefront = wavefront
 
     def name(self):
+        if self.wavefront:
+            return self.filepath.stem + '_wavefront'
         return self.filepath.stem
 
     def category(self):
         return "cycles"
 
     def use_device(self):
-        return True
+        # The wavefront variant only exists for the CPU.
+        return not self.wavefront
 
     def run(self, env, device_id):
         tokens = device_id.split('_')
@@ -62,7 +71,12 @@ class CyclesTest(api.Test):
                 'device_index': device_index,
                 'render_filepath': str(env.log_file.parent / (env.log_file.stem + '.png'))}
 
-        _, lines = env.run_in_blender(_run, args, ['--debug-cycles', '--verbose', '1', self.filepath])
+        environ = {'CYCLES_CPU_SPLIT_KERNEL': '1'} if self.wavefront else {}
+
+        result, lines = env.run_in_blender(_run,
+                                           args,
+                                           ['--debug-cycles', '--verbose', '1', self.filepath],
+                                           environ=environ)
 
         # Parse render time from output
         prefix = "Render time (without synchronization): "
@@ -71,12 +85,15 @@ class CyclesTest(api.Test):
             line = line.strip()
             offset = line.find(prefix)
             if offset != -1:
-                time = line[offset + len(prefix):]
-                return {'time': float(time)}
+                time = float(line[offset + len(prefix):])
+                return {'time': time,
+                        'samples_per_second': result['num_samples'] / time if time > 0.0 else 0.0}
 
         raise Exception("Error parsing render time output")
 
 
 def generate(env):
     filepaths = env.find_blend_files('cycles-x/*')
-    return [CyclesTest(filepath) for filepath in filepaths]
+    tests = [CyclesTest(filepath) for filepath in filepaths]
+    tests += [CyclesTest(filepath, wavefront=True) for filepath in filepaths]
+    return tests
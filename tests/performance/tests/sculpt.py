@@ -0,0 +1,133 @@
+# Apache License, Version 2.0
+
+import api
+
+# Settings of the active brush stored along with the stroke.
+BRUSH_SETTINGS = (
+    'sculpt_tool',
+    'size',
+    'unprojected_radius',
+    'strength',
+    'hardness',
+    'curve_preset',
+    'direction',
+    'auto_smooth_factor',
+    'normal_radius_factor',
+    'use_frontface',
+    'use_original_normal',
+    'use_space',
+    'spacing',
+)
+
+STROKE_ELEMENT_SETTINGS = (
+    'location',
+    'mouse',
+    'mouse_event',
+    'pressure',
+    'size',
+    'pen_flip',
+    'x_tilt',
+    'y_tilt',
+    'time',
+    'is_start',
+)
+
+# Summary printed at the end of the stroke, with the sum of all dabs and the final undo push.
+TIME_PREFIX = "Sculpt stroke of "
+TIME_STAGES = ('search', 'brush', 'normals', 'undo')
+
+
+def record_stroke(filepath):
+    """
+    Write the last sculpt stroke and the settings of the active brush to a
+    file, to be replayed by this test. Sculpt the stroke in the benchmark file
+    and then run this from the Python console, with the file path of the
+    benchmark file and a .json extension.
+    """
+    import bpy
+    import json
+
+    def to_json(value):
+        return list(value) if hasattr(value, '__len__') and not isinstance(value, str) else value
+
+    props = bpy.context.window_manager.operator_properties_last("sculpt.brush_stroke")
+    brush = bpy.context.tool_settings.sculpt.brush
+
+    stroke = {
+        'mode': props.mode,
+        'brush': {key: to_json(getattr(brush, key)) for key in BRUSH_SETTINGS},
+        'stroke': [{key: to_json(getattr(element, key)) for key in STROKE_ELEMENT_SETTINGS}
+                   for element in props.stroke],
+    }
+
+    with open(filepath, 'w') as f:
+        json.dump(stroke, f, indent=2)
+
+
+def _run(args):
+    import bpy
+    import json
+    import time
+
+    with open(args['stroke_filepath']) as f:
+        stroke = json.load(f)
+
+    # Strokes are projected from the view of a 3D viewport stored in the file, which is
+    # available in background mode too.
+    window = bpy.context.window_manager.windows[0]
+    area = next(area for area in window.screen.areas if area.type == 'VIEW_3D')
+    region = next(region for region in area.regions if region.type == 'WINDOW')
+    override = {'window': window, 'screen': window.screen, 'area': area, 'region': region}
+
+    if bpy.context.mode != 'SCULPT':
+        bpy.ops.object.mode_set(override, mode='SCULPT')
+
+    brush = bpy.context.tool_settings.sculpt.brush
+    for key, value in stroke['brush'].items():
+        setattr(brush, key, value)
+
+    start_time = time.time()
+    bpy.ops.sculpt.brush_stroke(override, stroke=stroke['stroke'], mode=stroke['mode'])
+    elapsed_time = time.time() - start_time
+
+    result = {'time': elapsed_time}
+    return result
+
+
+class SculptTest(api.Test):
+    def __init__(self, filepath):
+        self.filepath = filepath
+
+    def name(self):
+        return self.filepath.stem
+
+    def category(self):
+        return "sculpt"
+
+    def run(self, env, device_id):
+        args = {'stroke_filepath': str(self.filepath.with_suffix('.json'))}
+
+        result, lines = env.run_in_blender(_run, args, ['--debug-sculpt-time', str(self.filepath)])
+
+        # Parse time of the stages of the stroke from output, in seconds.
+        for stage in TIME_STAGES:
+            result[stage] = 0.0
+
+        for line in lines:
+            offset = line.find(TIME_PREFIX)
+            if offset == -1:
+                continue
+
+            # Sculpt stroke of 12 dabs: search 1.105 ms, brush 15.250 ms, normals 0.000 ms, undo 2.032 ms
+            stages = line[offset:].split(':', 1)[1].split(',')
+            for stage in stages:
+                name, value, _ = stage.split()
+                result[name] += float(value) / 1000.0
+
+        return result
+
+
+def generate(env):
+    filepaths = env.find_blend_files('sculpt')
+    return [SculptTest(filepath) for filepath in filepaths
+            if filepath.with_suffix('.json').exists()]
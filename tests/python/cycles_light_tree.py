@@ -0,0 +1,93 @@
+# Apache License, Version 2.0
+
+# ./blender.bin --background -noaudio --factory-startup --python tests/python/cycles_light_tree.py -- --verbose
+import os
+import tempfile
+import unittest
+
+import bpy
+
+
+class LightTreeTest(unittest.TestCase):
+    # Mesh lights picked with the light tree must converge to the same image as without it.
+    SAMPLES = 256
+    RESOLUTION = 32
+
+    def setUp(self):
+        bpy.ops.wm.read_factory_settings(use_empty=True)
+        scene = bpy.context.scene
+        scene.render.engine = 'CYCLES'
+        scene.cycles.device = 'CPU'
+        scene.cycles.samples = self.SAMPLES
+        scene.cycles.use_adaptive_sampling = False
+        scene.cycles.seed = 0
+        scene.render.resolution_x = self.RESOLUTION
+        scene.render.resolution_y = self.RESOLUTION
+        scene.render.resolution_percentage = 100
+        scene.render.image_settings.file_format = 'OPEN_EXR'
+
+        world = bpy.data.worlds.new("World")
+        world.color = (0.0, 0.0, 0.0)
+        scene.world = world
+
+        camera = bpy.data.objects.new("Camera", bpy.data.cameras.new("Camera"))
+        camera.location = (0.0, 0.0, 6.0)
+        scene.collection.objects.link(camera)
+        scene.camera = camera
+
+        self._add_plane("Floor", (0.0, 0.0, 0.0), 4.0, None)
+        # Emitters of different strength and area, so the energy used to pick them differs from
+        # the area used to pick triangles within them.
+        self._add_plane("Emitter Weak", (-1.0, 0.0, 1.0), 1.0, 1.0)
+        self._add_plane("Emitter Strong", (1.0, 0.5, 1.5), 0.5, 8.0)
+
+    def _add_plane(self, name, location, size, strength):
+        half = size * 0.5
+        mesh = bpy.data.meshes.new(name)
+        # Facing down, towards the floor below the emitters.
+        mesh.from_pydata(((-half, -half, 0.0), (half, -half, 0.0), (half, half, 0.0), (-half, half, 0.0)),
+                         (), ((0, 3, 2, 1),))
+        ob = bpy.data.objects.new(name, mesh)
+        ob.location = location
+        bpy.context.scene.collection.objects.link(ob)
+
+        if strength is None:
+            return
+
+        material = bpy.data.materials.new(name)
+        material.use_nodes = True
+        nodes = material.node_tree.nodes
+        nodes.clear()
+        emission = nodes.new('ShaderNodeEmission')
+        emission.inputs["Strength"].default_value = strength
+        output = nodes.new('ShaderNodeOutputMaterial')
+        material.node_tree.links.new(emission.outputs["Emission"], output.inputs["Surface"])
+        mesh.materials.append(material)
+        ob.cycles_visibility.camera = False
+
+    def _render_mean(self, use_light_tree):
+        scene = bpy.context.scene
+        scene.cycles.use_light_tree = use_light_tree
+
+        with tempfile.TemporaryDirectory() as tempdir:
+            scene.render.filepath = os.path.join(tempdir, "light_tree.exr")
+            bpy.ops.render.render(write_still=True)
+            image = bpy.data.images.load(scene.render.filepath)
+            pixels = image.pixels[:]
+            bpy.data.images.remove(image)
+
+        rgb = [value for i, value in enumerate(pixels) if i % 4 != 3]
+        return sum(rgb) / len(rgb)
+
+    def test_mesh_lights_match(self):
+        mean_reference = self._render_mean(False)
+        mean_light_tree = self._render_mean(True)
+
+        self.assertGreater(mean_reference, 0.0)
+        self.assertAlmostEqual(mean_light_tree / mean_reference, 1.0, delta=0.05)
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()